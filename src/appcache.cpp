@@ -0,0 +1,396 @@
+// Copyright (c) 2017-2018 The Biblepay Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "appcache.h"
+
+#include <algorithm>
+
+#include <boost/algorithm/string/case_conv.hpp>
+#include <boost/functional/hash.hpp>
+#include <boost/thread/locks.hpp>
+
+CAppCache appCache;
+
+//! Below this much garbage the arena is never compacted
+static const size_t KEYPOOL_MIN_GARBAGE = 64 * 1024;
+
+size_t CAppCacheKeyPool::Hash(const char* pbegin, const char* pend)
+{
+    return boost::hash_range(pbegin, pend);
+}
+
+void CAppCacheKeyPool::Compact()
+{
+    std::vector<char> vNew;
+    vNew.reserve(vArena.size() - nGarbage);
+    for (std::vector<CSlot>::iterator it = vSlots.begin(); it != vSlots.end(); ++it)
+    {
+        if (it->nRefs == 0)
+            continue;
+        uint32_t nOffset = vNew.size();
+        vNew.insert(vNew.end(), vArena.begin() + it->nOffset, vArena.begin() + it->nOffset + it->nSize);
+        it->nOffset = nOffset;
+    }
+    vArena.swap(vNew);
+    nGarbage = 0;
+}
+
+CAppCacheKeyPool::id_t CAppCacheKeyPool::Acquire(const std::string& sKey)
+{
+    id_t id;
+    if (Find(sKey, id))
+    {
+        vSlots[id].nRefs++;
+        return id;
+    }
+    CSlot slot;
+    slot.nOffset = vArena.size();
+    slot.nSize = sKey.size();
+    slot.nRefs = 1;
+    vArena.insert(vArena.end(), sKey.begin(), sKey.end());
+    if (vFree.empty())
+    {
+        id = vSlots.size();
+        vSlots.push_back(slot);
+    }
+    else
+    {
+        id = vFree.back();
+        vFree.pop_back();
+        vSlots[id] = slot;
+    }
+    mapIds.insert(std::make_pair(Hash(sKey.data(), sKey.data() + sKey.size()), id));
+    return id;
+}
+
+void CAppCacheKeyPool::Release(id_t id)
+{
+    CSlot& slot = vSlots[id];
+    if (--slot.nRefs > 0)
+        return;
+    const char* pbegin = vArena.empty() ? NULL : &vArena[0] + slot.nOffset;
+    typedef boost::unordered_multimap<size_t, id_t>::iterator iter_t;
+    std::pair<iter_t, iter_t> range = mapIds.equal_range(Hash(pbegin, pbegin + slot.nSize));
+    for (iter_t it = range.first; it != range.second; ++it)
+    {
+        if (it->second == id)
+        {
+            mapIds.erase(it);
+            break;
+        }
+    }
+    nGarbage += slot.nSize;
+    vFree.push_back(id);
+    if (nGarbage > KEYPOOL_MIN_GARBAGE && nGarbage * 2 > vArena.size())
+        Compact();
+}
+
+bool CAppCacheKeyPool::Find(const std::string& sKey, id_t& idRet) const
+{
+    typedef boost::unordered_multimap<size_t, id_t>::const_iterator iter_t;
+    std::pair<iter_t, iter_t> range = mapIds.equal_range(Hash(sKey.data(), sKey.data() + sKey.size()));
+    for (iter_t it = range.first; it != range.second; ++it)
+    {
+        const CSlot& slot = vSlots[it->second];
+        if (slot.nSize == sKey.size() && std::equal(sKey.begin(), sKey.end(), vArena.begin() + slot.nOffset))
+        {
+            idRet = it->second;
+            return true;
+        }
+    }
+    return false;
+}
+
+std::string CAppCacheKeyPool::Get(id_t id) const
+{
+    const CSlot& slot = vSlots[id];
+    return std::string(vArena.begin() + slot.nOffset, vArena.begin() + slot.nOffset + slot.nSize);
+}
+
+std::string CAppCache::NormalizeSection(const std::string& sSection)
+{
+    return boost::to_upper_copy(sSection);
+}
+
+CAppCache::section_t CAppCache::GetSectionId(const std::string& sSection)
+{
+    std::string sName = NormalizeSection(sSection);
+    std::map<std::string, section_t>::const_iterator it = mapSectionIds.find(sName);
+    if (it != mapSectionIds.end())
+        return it->second;
+    section_t nSection = vSections.size();
+    mapSectionIds.insert(std::make_pair(sName, nSection));
+    vSectionNames.push_back(sName);
+    vSections.push_back(CSection());
+    return nSection;
+}
+
+const CAppCache::CSection* CAppCache::FindSection(const std::string& sSection) const
+{
+    std::map<std::string, section_t>::const_iterator it = mapSectionIds.find(NormalizeSection(sSection));
+    if (it == mapSectionIds.end())
+        return NULL;
+    return &vSections[it->second];
+}
+
+void CAppCache::EraseEntry(CSection& section, entry_map_t::iterator it)
+{
+    key_t nKey = it->first;
+    section.setByTime.erase(std::make_pair(it->second.nTimestamp, nKey));
+    section.mapEntries.erase(it);
+    keys.Release(nKey);
+    section.nStamp = ++nStampCounter;
+    nEntries--;
+    // An emptied section gives its memory back and reads as never written
+    if (section.mapEntries.empty())
+        section = CSection();
+}
+
+void CAppCache::WriteEntry(CSection& section, const std::string& sKey, const std::string& sValue, int64_t nTimestamp)
+{
+    key_t nKey = keys.Acquire(sKey);
+    std::pair<entry_map_t::iterator, bool> ret = section.mapEntries.insert(std::make_pair(nKey, CAppCacheEntry()));
+    CAppCacheEntry& entry = ret.first->second;
+    if (ret.second)
+    {
+        nEntries++;
+    }
+    else
+    {
+        keys.Release(nKey);
+        section.setByTime.erase(std::make_pair(entry.nTimestamp, nKey));
+    }
+    if (ret.second || entry.sValue != sValue)
+        section.nStamp = ++nStampCounter;
+    entry.sValue = sValue;
+    entry.nTimestamp = nTimestamp;
+    section.setByTime.insert(std::make_pair(nTimestamp, nKey));
+}
+
+void CAppCache::EraseSection(CSection& section)
+{
+    for (entry_map_t::const_iterator it = section.mapEntries.begin(); it != section.mapEntries.end(); ++it)
+        keys.Release(it->first);
+    nEntries -= section.mapEntries.size();
+    section = CSection();
+}
+
+void CAppCache::MarkDirty(section_t nSection, const std::string& sKey)
+{
+    if (!fJournal)
+        return;
+    key_t nKey = keys.Acquire(sKey);
+    if (!setJournalDirty.insert(std::make_pair(nSection, nKey)).second)
+        keys.Release(nKey);
+}
+
+void CAppCache::ClearJournal()
+{
+    for (std::set<std::pair<section_t, key_t> >::const_iterator it = setJournalDirty.begin(); it != setJournalDirty.end(); ++it)
+        keys.Release(it->second);
+    setJournalCleared.clear();
+    setJournalDirty.clear();
+}
+
+void CAppCache::Write(const std::string& sSection, const std::string& sKey, const std::string& sValue, int64_t nTimestamp)
+{
+    boost::unique_lock<boost::shared_mutex> lock(cs_appcache);
+    section_t nSection = GetSectionId(sSection);
+    WriteEntry(vSections[nSection], sKey, sValue, nTimestamp);
+    MarkDirty(nSection, sKey);
+}
+
+bool CAppCache::Read(const std::string& sSection, const std::string& sKey, CAppCacheEntry& entryRet) const
+{
+    boost::shared_lock<boost::shared_mutex> lock(cs_appcache);
+    const CSection* pSection = FindSection(sSection);
+    key_t nKey;
+    if (!pSection || !keys.Find(sKey, nKey))
+        return false;
+    entry_map_t::const_iterator it = pSection->mapEntries.find(nKey);
+    if (it == pSection->mapEntries.end())
+        return false;
+    entryRet = it->second;
+    return true;
+}
+
+std::string CAppCache::ReadValue(const std::string& sSection, const std::string& sKey) const
+{
+    CAppCacheEntry entry;
+    Read(sSection, sKey, entry);
+    return entry.sValue;
+}
+
+int64_t CAppCache::ReadTimestamp(const std::string& sSection, const std::string& sKey) const
+{
+    CAppCacheEntry entry;
+    Read(sSection, sKey, entry);
+    return entry.nTimestamp;
+}
+
+bool CAppCache::Erase(const std::string& sSection, const std::string& sKey)
+{
+    boost::unique_lock<boost::shared_mutex> lock(cs_appcache);
+    std::map<std::string, section_t>::const_iterator its = mapSectionIds.find(NormalizeSection(sSection));
+    key_t nKey;
+    if (its == mapSectionIds.end() || !keys.Find(sKey, nKey))
+        return false;
+    CSection& section = vSections[its->second];
+    entry_map_t::iterator it = section.mapEntries.find(nKey);
+    if (it == section.mapEntries.end())
+        return false;
+    MarkDirty(its->second, sKey);
+    EraseEntry(section, it);
+    return true;
+}
+
+void CAppCache::ClearSection(const std::string& sSection)
+{
+    boost::unique_lock<boost::shared_mutex> lock(cs_appcache);
+    std::map<std::string, section_t>::const_iterator its = mapSectionIds.find(NormalizeSection(sSection));
+    if (its == mapSectionIds.end() || vSections[its->second].mapEntries.empty())
+        return;
+    if (fJournal)
+        setJournalCleared.insert(its->second);
+    EraseSection(vSections[its->second]);
+}
+
+size_t CAppCache::PurgeSection(const std::string& sSection, int64_t nExpiration)
+{
+    boost::unique_lock<boost::shared_mutex> lock(cs_appcache);
+    std::map<std::string, section_t>::const_iterator its = mapSectionIds.find(NormalizeSection(sSection));
+    if (its == mapSectionIds.end())
+        return 0;
+    CSection& section = vSections[its->second];
+    size_t nPurged = 0;
+    // The time index is ordered by timestamp, so we stop at the first live entry
+    while (!section.setByTime.empty() && section.setByTime.begin()->first < nExpiration)
+    {
+        entry_map_t::iterator it = section.mapEntries.find(section.setByTime.begin()->second);
+        if (fJournal)
+            MarkDirty(its->second, keys.Get(it->first));
+        EraseEntry(section, it);
+        nPurged++;
+    }
+    return nPurged;
+}
+
+static bool CompareItemKey(const CAppCache::item_t& a, const CAppCache::item_t& b)
+{
+    return a.first < b.first;
+}
+
+std::vector<CAppCache::item_t> CAppCache::GetSection(const std::string& sSection) const
+{
+    std::vector<item_t> vItems;
+    {
+        boost::shared_lock<boost::shared_mutex> lock(cs_appcache);
+        const CSection* pSection = FindSection(sSection);
+        if (!pSection)
+            return vItems;
+        vItems.reserve(pSection->mapEntries.size());
+        for (entry_map_t::const_iterator it = pSection->mapEntries.begin(); it != pSection->mapEntries.end(); ++it)
+            vItems.push_back(std::make_pair(keys.Get(it->first), it->second));
+    }
+    // Callers rely on a stable, key ordered walk (the DCC contract is hashed)
+    std::sort(vItems.begin(), vItems.end(), CompareItemKey);
+    return vItems;
+}
+
+std::vector<std::string> CAppCache::GetSectionNames() const
+{
+    boost::shared_lock<boost::shared_mutex> lock(cs_appcache);
+    std::vector<std::string> vNames;
+    for (std::map<std::string, section_t>::const_iterator its = mapSectionIds.begin(); its != mapSectionIds.end(); ++its)
+        if (!vSections[its->second].mapEntries.empty())
+            vNames.push_back(its->first);
+    return vNames;
+}
+
+uint64_t CAppCache::GetSectionStamp(const std::string& sSection) const
+{
+    boost::shared_lock<boost::shared_mutex> lock(cs_appcache);
+    const CSection* pSection = FindSection(sSection);
+    return pSection ? pSection->nStamp : 0;
+}
+
+size_t CAppCache::Size() const
+{
+    boost::shared_lock<boost::shared_mutex> lock(cs_appcache);
+    return nEntries;
+}
+
+size_t CAppCache::KeyCount() const
+{
+    boost::shared_lock<boost::shared_mutex> lock(cs_appcache);
+    return keys.size();
+}
+
+void CAppCache::Clear()
+{
+    boost::unique_lock<boost::shared_mutex> lock(cs_appcache);
+    for (section_t nSection = 0; nSection < vSections.size(); nSection++)
+    {
+        if (vSections[nSection].mapEntries.empty())
+            continue;
+        if (fJournal)
+            setJournalCleared.insert(nSection);
+        EraseSection(vSections[nSection]);
+    }
+}
+
+void CAppCache::Apply(const std::vector<CAppCacheRecord>& vRecords)
+{
+    boost::unique_lock<boost::shared_mutex> lock(cs_appcache);
+    for (std::vector<CAppCacheRecord>::const_iterator itr = vRecords.begin(); itr != vRecords.end(); ++itr)
+    {
+        if (itr->nOp == CAppCacheRecord::WRITE)
+        {
+            WriteEntry(vSections[GetSectionId(itr->sSection)], itr->sKey, itr->sValue, itr->nTimestamp);
+            continue;
+        }
+        std::map<std::string, section_t>::const_iterator its = mapSectionIds.find(NormalizeSection(itr->sSection));
+        if (its == mapSectionIds.end())
+            continue;
+        CSection& section = vSections[its->second];
+        key_t nKey;
+        if (itr->nOp == CAppCacheRecord::CLEAR_SECTION)
+        {
+            EraseSection(section);
+        }
+        else if (itr->nOp == CAppCacheRecord::ERASE && keys.Find(itr->sKey, nKey))
+        {
+            entry_map_t::iterator it = section.mapEntries.find(nKey);
+            if (it != section.mapEntries.end())
+                EraseEntry(section, it);
+        }
+    }
+}
+
+void CAppCache::SetJournal(bool fEnable)
+{
+    boost::unique_lock<boost::shared_mutex> lock(cs_appcache);
+    fJournal = fEnable;
+    ClearJournal();
+}
+
+void CAppCache::TakeJournal(std::vector<CAppCacheRecord>& vRecords)
+{
+    boost::unique_lock<boost::shared_mutex> lock(cs_appcache);
+    vRecords.clear();
+    vRecords.reserve(setJournalCleared.size() + setJournalDirty.size());
+    // Section clears go first; the dirty keys then restore whatever was written since
+    for (std::set<section_t>::const_iterator it = setJournalCleared.begin(); it != setJournalCleared.end(); ++it)
+        vRecords.push_back(CAppCacheRecord(CAppCacheRecord::CLEAR_SECTION, vSectionNames[*it], ""));
+    for (std::set<std::pair<section_t, key_t> >::const_iterator it = setJournalDirty.begin(); it != setJournalDirty.end(); ++it)
+    {
+        const entry_map_t& mapEntries = vSections[it->first].mapEntries;
+        entry_map_t::const_iterator ite = mapEntries.find(it->second);
+        if (ite != mapEntries.end())
+            vRecords.push_back(CAppCacheRecord(CAppCacheRecord::WRITE, vSectionNames[it->first], keys.Get(it->second), ite->second.sValue, ite->second.nTimestamp));
+        else
+            vRecords.push_back(CAppCacheRecord(CAppCacheRecord::ERASE, vSectionNames[it->first], keys.Get(it->second)));
+    }
+    ClearJournal();
+}
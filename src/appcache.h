@@ -0,0 +1,215 @@
+// Copyright (c) 2017-2018 The Biblepay Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_APPCACHE_H
+#define BITCOIN_APPCACHE_H
+
+#include "serialize.h"
+
+#include <map>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <stdint.h>
+
+#include <boost/thread/shared_mutex.hpp>
+#include <boost/unordered_map.hpp>
+
+/**
+ * A single application cache value (prayer, DCC, spork, business object,
+ * IPFS hash, ...) together with the time it was recorded.
+ */
+struct CAppCacheEntry
+{
+    std::string sValue;
+    int64_t nTimestamp;
+
+    CAppCacheEntry() : nTimestamp(0) {}
+    CAppCacheEntry(const std::string& sValueIn, int64_t nTimestampIn) : sValue(sValueIn), nTimestamp(nTimestampIn) {}
+};
+
+/**
+ * One change to the application cache, as persisted in the snapshot file.
+ */
+struct CAppCacheRecord
+{
+    enum Op { WRITE = 1, ERASE = 2, CLEAR_SECTION = 3 };
+
+    unsigned char nOp;
+    std::string sSection;
+    std::string sKey;
+    std::string sValue;
+    int64_t nTimestamp;
+
+    CAppCacheRecord() : nOp(WRITE), nTimestamp(0) {}
+    CAppCacheRecord(unsigned char nOpIn, const std::string& sSectionIn, const std::string& sKeyIn, const std::string& sValueIn = "", int64_t nTimestampIn = 0)
+        : nOp(nOpIn), sSection(sSectionIn), sKey(sKeyIn), sValue(sValueIn), nTimestamp(nTimestampIn) {}
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action, int nType, int nVersion) {
+        READWRITE(nOp);
+        READWRITE(sSection);
+        if (nOp != CLEAR_SECTION)
+            READWRITE(sKey);
+        if (nOp == WRITE) {
+            READWRITE(sValue);
+            READWRITE(nTimestamp);
+        }
+    }
+};
+
+/**
+ * Interned application cache keys. Each distinct key is stored once in an
+ * arena however many sections use it (a CPID is a key of DCC, UTXOWEIGHT,
+ * TASKWEIGHT, UNBANKED and their MATURE copies) and is referred to by a
+ * 32 bit id. Ids are reference counted and reused once released; the arena is
+ * compacted when most of it belongs to released keys. Not thread safe.
+ */
+class CAppCacheKeyPool
+{
+public:
+    typedef uint32_t id_t;
+
+private:
+    struct CSlot
+    {
+        uint32_t nOffset;
+        uint32_t nSize;
+        uint32_t nRefs;
+    };
+
+    std::vector<char> vArena;
+    std::vector<CSlot> vSlots;
+    std::vector<id_t> vFree;
+    //! Hash of a key's bytes to the ids of the keys with that hash
+    boost::unordered_multimap<size_t, id_t> mapIds;
+    //! Arena bytes of released keys
+    size_t nGarbage;
+
+    static size_t Hash(const char* pbegin, const char* pend);
+    void Compact();
+
+public:
+    CAppCacheKeyPool() : nGarbage(0) {}
+
+    /** Id of sKey with one more reference, interning it if needed */
+    id_t Acquire(const std::string& sKey);
+    /** Drop one reference, freeing the key when it was the last */
+    void Release(id_t id);
+    /** Id of sKey, returns false if it is not interned */
+    bool Find(const std::string& sKey, id_t& idRet) const;
+    std::string Get(id_t id) const;
+
+    /** Number of keys held */
+    size_t size() const { return vSlots.size() - vFree.size(); }
+    size_t ArenaSize() const { return vArena.size(); }
+};
+
+/**
+ * Application cache holding every memorized blockchain message.
+ *
+ * Entries are grouped by section (PRAYER, DCC, SPORK, ...). Section names are
+ * interned to small ids and keys to ids of a shared CAppCacheKeyPool, so a
+ * key costs its bytes once plus four bytes per section holding it. Each
+ * section owns a hash table of its keys plus an index ordered by timestamp,
+ * so point lookups are O(1), section scans only touch that section, and
+ * expiry purges are O(expired). Section names are case insensitive; keys are
+ * stored verbatim. Readers share the lock, writers take it exclusively.
+ *
+ * When journaling is enabled the cache remembers which keys and sections
+ * changed, so the snapshot file can be extended with a delta instead of
+ * being rewritten.
+ */
+class CAppCache
+{
+public:
+    typedef std::pair<std::string, CAppCacheEntry> item_t;
+
+private:
+    typedef CAppCacheKeyPool::id_t key_t;
+    typedef uint32_t section_t;
+    typedef boost::unordered_map<key_t, CAppCacheEntry> entry_map_t;
+    typedef std::set<std::pair<int64_t, key_t> > time_index_t;
+
+    struct CSection
+    {
+        entry_map_t mapEntries;
+        time_index_t setByTime;
+        //! Taken from nStampCounter whenever a key is added, removed or gets a new value
+        uint64_t nStamp;
+
+        CSection() : nStamp(0) {}
+    };
+
+    mutable boost::shared_mutex cs_appcache;
+    //! Section ids are never reused: the journal may still refer to an emptied section
+    std::map<std::string, section_t> mapSectionIds;
+    std::vector<std::string> vSectionNames;
+    std::vector<CSection> vSections;
+    CAppCacheKeyPool keys;
+    size_t nEntries;
+    uint64_t nStampCounter;
+
+    bool fJournal;
+    std::set<section_t> setJournalCleared;
+    //! Each dirty key holds a reference in the key pool until the journal is taken
+    std::set<std::pair<section_t, key_t> > setJournalDirty;
+
+    static std::string NormalizeSection(const std::string& sSection);
+    section_t GetSectionId(const std::string& sSection);
+    const CSection* FindSection(const std::string& sSection) const;
+    void EraseEntry(CSection& section, entry_map_t::iterator it);
+    void WriteEntry(CSection& section, const std::string& sKey, const std::string& sValue, int64_t nTimestamp);
+    void EraseSection(CSection& section);
+    void MarkDirty(section_t nSection, const std::string& sKey);
+    void ClearJournal();
+
+public:
+    CAppCache() : nEntries(0), nStampCounter(0), fJournal(false) {}
+
+    /** Insert or replace an entry */
+    void Write(const std::string& sSection, const std::string& sKey, const std::string& sValue, int64_t nTimestamp);
+    /** Look up an entry, returns false if it does not exist */
+    bool Read(const std::string& sSection, const std::string& sKey, CAppCacheEntry& entryRet) const;
+    /** Value of an entry, or an empty string if it does not exist */
+    std::string ReadValue(const std::string& sSection, const std::string& sKey) const;
+    /** Timestamp of an entry, or 0 if it does not exist */
+    int64_t ReadTimestamp(const std::string& sSection, const std::string& sKey) const;
+    /** Remove a single entry */
+    bool Erase(const std::string& sSection, const std::string& sKey);
+    /** Remove every entry of a section */
+    void ClearSection(const std::string& sSection);
+    /** Remove every entry of a section recorded before nExpiration, returns the number removed */
+    size_t PurgeSection(const std::string& sSection, int64_t nExpiration);
+    /** Snapshot of a section, ordered by key */
+    std::vector<item_t> GetSection(const std::string& sSection) const;
+    /** Names of all non-empty sections, ordered */
+    std::vector<std::string> GetSectionNames() const;
+    /**
+     * Version of a section's keys and values (timestamps aside): it changes with
+     * every such change and is 0 for an empty section, so equal stamps mean
+     * equal contents. Lets derived indexes skip rescanning an unchanged section.
+     */
+    uint64_t GetSectionStamp(const std::string& sSection) const;
+
+    size_t Size() const;
+    /** Number of distinct keys held, however many sections share them */
+    size_t KeyCount() const;
+    void Clear();
+
+    /** Apply a batch of records under a single lock, without journaling them */
+    void Apply(const std::vector<CAppCacheRecord>& vRecords);
+    /** Start or stop tracking changes; either way the current journal is discarded */
+    void SetJournal(bool fEnable);
+    /** Turn the journal into records reproducing the current state, and reset it */
+    void TakeJournal(std::vector<CAppCacheRecord>& vRecords);
+};
+
+extern CAppCache appCache;
+
+#endif // BITCOIN_APPCACHE_H
@@ -0,0 +1,248 @@
+// Copyright (c) 2017-2018 The Biblepay Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "appcachedb.h"
+
+#include "appcache.h"
+#include "clientversion.h"
+#include "hash.h"
+#include "streams.h"
+#include "util.h"
+#include "utiltime.h"
+
+#include <boost/filesystem.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+CAppCacheDB appCacheDB;
+
+static const char APPCACHE_FILE_MAGIC[8] = { 'B', 'B', 'P', 'C', 'A', 'C', 'H', 'E' };
+//! Version 2 memorizes IPFS fees as one IPFSFEE record per attachment; older files are rebuilt from the chain
+static const uint32_t APPCACHE_FILE_VERSION = 2;
+static const uint32_t APPCACHE_CHUNK_MAGIC = 0xb1b1e0a1;
+//! Rewrite the file once appended deltas outgrow the base snapshot by this factor
+static const uint64_t APPCACHE_COMPACTION_FACTOR = 2;
+
+enum
+{
+    CHUNK_DELTA = 0,
+    CHUNK_SNAPSHOT = 1
+};
+
+void CAppCacheDB::SetPath(const boost::filesystem::path& pathIn)
+{
+    LOCK(cs);
+    pathDB = pathIn;
+    nBaseSize = 0;
+    nFileSize = 0;
+    fRewrite = true;
+}
+
+bool CAppCacheDB::IsOpen() const
+{
+    LOCK(cs);
+    return !pathDB.empty();
+}
+
+bool CAppCacheDB::HasFile() const
+{
+    LOCK(cs);
+    return !pathDB.empty() && boost::filesystem::exists(pathDB) && boost::filesystem::file_size(pathDB) > 0;
+}
+
+bool CAppCacheDB::WriteChunk(FILE* file, const std::vector<CAppCacheRecord>& vRecords, int nHeight, bool fSnapshot, uint64_t& nBytesRet)
+{
+    CDataStream ssPayload(SER_DISK, CLIENT_VERSION);
+    for (std::vector<CAppCacheRecord>::const_iterator it = vRecords.begin(); it != vRecords.end(); ++it)
+        ssPayload << *it;
+
+    unsigned char nKind = fSnapshot ? CHUNK_SNAPSHOT : CHUNK_DELTA;
+    CDataStream ssChunk(SER_DISK, CLIENT_VERSION);
+    ssChunk << APPCACHE_CHUNK_MAGIC << nKind << (int32_t)nHeight << (uint32_t)vRecords.size() << (uint32_t)ssPayload.size();
+    ssChunk << Hash(ssPayload.begin(), ssPayload.end());
+
+    if (fwrite(&ssChunk[0], 1, ssChunk.size(), file) != ssChunk.size())
+        return false;
+    if (!ssPayload.empty() && fwrite(&ssPayload[0], 1, ssPayload.size(), file) != ssPayload.size())
+        return false;
+    nBytesRet += ssChunk.size() + ssPayload.size();
+    return true;
+}
+
+bool CAppCacheDB::WriteSnapshot(CAppCache& cache, int nHeight)
+{
+    int64_t nStart = GetTimeMillis();
+    // Restart the journal first: anything written while we dump is journaled again for the next delta
+    cache.SetJournal(true);
+
+    boost::filesystem::path pathTmp = pathDB;
+    pathTmp += ".new";
+    FILE* file = fopen(pathTmp.string().c_str(), "wb");
+    if (!file)
+    {
+        fRewrite = true;
+        return error("%s: Failed to open file %s", __func__, pathTmp.string());
+    }
+
+    CDataStream ssHeader(SER_DISK, CLIENT_VERSION);
+    ssHeader << FLATDATA(APPCACHE_FILE_MAGIC) << APPCACHE_FILE_VERSION;
+    bool fOk = fwrite(&ssHeader[0], 1, ssHeader.size(), file) == ssHeader.size();
+    uint64_t nBytes = ssHeader.size();
+
+    // One chunk per section keeps the write buffer bounded
+    std::vector<std::string> vSections = cache.GetSectionNames();
+    std::vector<CAppCacheRecord> vRecords;
+    size_t nRecords = 0;
+    for (unsigned int i = 0; fOk && i < vSections.size(); i++)
+    {
+        const std::string& sSection = vSections[i];
+        bool fMessage = sSection.compare(0, 7, "MESSAGE") == 0;
+        std::vector<CAppCache::item_t> vItems = cache.GetSection(sSection);
+        vRecords.clear();
+        vRecords.reserve(vItems.size());
+        for (unsigned int j = 0; j < vItems.size(); j++)
+        {
+            const CAppCacheEntry& entry = vItems[j].second;
+            if (fMessage && (entry.sValue.empty() || entry.sValue == " "))
+                continue;
+            vRecords.push_back(CAppCacheRecord(CAppCacheRecord::WRITE, sSection, vItems[j].first, entry.sValue, entry.nTimestamp));
+        }
+        fOk = WriteChunk(file, vRecords, nHeight, true, nBytes);
+        nRecords += vRecords.size();
+    }
+    // An empty cache still records the height it was taken at
+    if (fOk && vSections.empty())
+        fOk = WriteChunk(file, std::vector<CAppCacheRecord>(), nHeight, true, nBytes);
+
+    if (fOk)
+        FileCommit(file);
+    fclose(file);
+    if (!fOk || !RenameOver(pathTmp, pathDB))
+    {
+        fRewrite = true;
+        return error("%s: Failed to write %s", __func__, pathDB.string());
+    }
+
+    nBaseSize = nBytes;
+    nFileSize = nBytes;
+    fRewrite = false;
+    LogPrintf("Written application cache snapshot (%u records, height %d) to %s  %dms\n", nRecords, nHeight, pathDB.string(), GetTimeMillis() - nStart);
+    return true;
+}
+
+bool CAppCacheDB::AppendDelta(CAppCache& cache, int nHeight)
+{
+    std::vector<CAppCacheRecord> vRecords;
+    cache.TakeJournal(vRecords);
+    if (vRecords.empty())
+        return true;
+
+    FILE* file = fopen(pathDB.string().c_str(), "ab");
+    uint64_t nBytes = 0;
+    bool fOk = file && WriteChunk(file, vRecords, nHeight, false, nBytes);
+    if (file)
+        fclose(file);
+    if (!fOk)
+    {
+        // The journal is gone, only a full snapshot can bring the file up to date
+        fRewrite = true;
+        return error("%s: Failed to append to %s", __func__, pathDB.string());
+    }
+    nFileSize += nBytes;
+    LogPrint("appcache", "Appended %u application cache changes at height %d\n", vRecords.size(), nHeight);
+    return true;
+}
+
+int CAppCacheDB::Load(CAppCache& cache)
+{
+    LOCK(cs);
+    int64_t nStart = GetTimeMillis();
+    nBaseSize = 0;
+    nFileSize = 0;
+    fRewrite = true;
+    // Bulk loading bypasses the journal; from here on every change is tracked for the next delta
+    cache.SetJournal(true);
+
+    if (pathDB.empty() || !boost::filesystem::exists(pathDB) || boost::filesystem::file_size(pathDB) == 0)
+        return -1;
+
+    int nHeight = -1;
+    size_t nRecords = 0;
+    try
+    {
+        boost::interprocess::file_mapping mapping(pathDB.string().c_str(), boost::interprocess::read_only);
+        boost::interprocess::mapped_region region(mapping, boost::interprocess::read_only);
+        region.advise(boost::interprocess::mapped_region::advice_sequential);
+        const char* pbegin = static_cast<const char*>(region.get_address());
+        CSpanReader reader(pbegin, pbegin + region.get_size(), SER_DISK, CLIENT_VERSION);
+
+        char pchMagic[sizeof(APPCACHE_FILE_MAGIC)];
+        uint32_t nVersion = 0;
+        reader >> FLATDATA(pchMagic) >> nVersion;
+        if (memcmp(pchMagic, APPCACHE_FILE_MAGIC, sizeof(pchMagic)) || nVersion != APPCACHE_FILE_VERSION)
+        {
+            error("%s: %s has an unknown format, ignoring it", __func__, pathDB.string());
+            return -1;
+        }
+
+        std::vector<CAppCacheRecord> vRecords;
+        size_t nGood = reader.GetPos();
+        while (!reader.empty())
+        {
+            uint32_t nMagic = 0, nCount = 0, nPayloadSize = 0;
+            unsigned char nKind = 0;
+            int32_t nChunkHeight = 0;
+            uint256 hashPayload;
+            try {
+                reader >> nMagic >> nKind >> nChunkHeight >> nCount >> nPayloadSize >> hashPayload;
+            } catch (const std::ios_base::failure&) {
+                break;
+            }
+            // A torn append (crash mid write) ends the usable part of the file
+            if (nMagic != APPCACHE_CHUNK_MAGIC || nPayloadSize > reader.size())
+                break;
+            const char* pPayload = reader.skip(nPayloadSize);
+            if (Hash(pPayload, pPayload + nPayloadSize) != hashPayload)
+                break;
+
+            CSpanReader payload(pPayload, pPayload + nPayloadSize, SER_DISK, CLIENT_VERSION);
+            vRecords.clear();
+            vRecords.reserve(std::min((size_t)nCount, (size_t)nPayloadSize));
+            for (uint32_t i = 0; i < nCount; i++)
+            {
+                vRecords.push_back(CAppCacheRecord());
+                payload >> vRecords.back();
+            }
+            cache.Apply(vRecords);
+            nRecords += vRecords.size();
+            if (nChunkHeight > nHeight)
+                nHeight = nChunkHeight;
+            nGood = reader.GetPos();
+            if (nKind == CHUNK_SNAPSHOT)
+                nBaseSize = nGood;
+        }
+        nFileSize = nGood;
+        fRewrite = nBaseSize == 0 || nGood != region.get_size();
+        if (nGood != region.get_size())
+            LogPrintf("%s: %s is truncated after %u bytes, it will be rewritten\n", __func__, pathDB.string(), nGood);
+    }
+    catch (const std::exception& e)
+    {
+        error("%s: Deserialize or I/O error - %s", __func__, e.what());
+        fRewrite = true;
+    }
+
+    LogPrintf("Loaded application cache from %s (%u records, height %d)  %dms\n", pathDB.string(), nRecords, nHeight, GetTimeMillis() - nStart);
+    return nHeight;
+}
+
+bool CAppCacheDB::Flush(CAppCache& cache, int nHeight)
+{
+    LOCK(cs);
+    if (pathDB.empty())
+        return false;
+    if (fRewrite || nFileSize > nBaseSize * APPCACHE_COMPACTION_FACTOR)
+        return WriteSnapshot(cache, nHeight);
+    return AppendDelta(cache, nHeight);
+}
@@ -0,0 +1,62 @@
+// Copyright (c) 2017-2018 The Biblepay Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_APPCACHEDB_H
+#define BITCOIN_APPCACHEDB_H
+
+#include "sync.h"
+
+#include <string>
+#include <vector>
+
+#include <stdint.h>
+
+#include <boost/filesystem/path.hpp>
+
+class CAppCache;
+struct CAppCacheRecord;
+
+/**
+ * Binary snapshot of the application cache (replaces the old prayers2 text dump).
+ *
+ * Layout: a header (magic, format version) followed by chunks.
+ * Each chunk carries the block height it was written at, its record count and
+ * payload size, and a double-SHA256 of the payload; the payload is a list of
+ * length prefixed CAppCacheRecords. A full snapshot is written once, then every
+ * block appends a small delta chunk holding only the journaled changes. The
+ * file is memory mapped on load and records are decoded in place.
+ */
+class CAppCacheDB
+{
+private:
+    mutable CCriticalSection cs;
+    boost::filesystem::path pathDB;
+    uint64_t nBaseSize;
+    uint64_t nFileSize;
+    bool fRewrite;
+
+    bool WriteChunk(FILE* file, const std::vector<CAppCacheRecord>& vRecords, int nHeight, bool fSnapshot, uint64_t& nBytesRet);
+    bool WriteSnapshot(CAppCache& cache, int nHeight);
+    bool AppendDelta(CAppCache& cache, int nHeight);
+
+public:
+    CAppCacheDB() : nBaseSize(0), nFileSize(0), fRewrite(true) {}
+
+    void SetPath(const boost::filesystem::path& pathIn);
+    bool IsOpen() const;
+    /** Whether a snapshot file of any version exists, usable or not */
+    bool HasFile() const;
+
+    /**
+     * Bulk load the snapshot and its deltas into the cache and start journaling.
+     * Returns the highest block height recorded, or -1 if there is no usable file.
+     */
+    int Load(CAppCache& cache);
+    /** Persist the cache as of nHeight: a delta normally, a full rewrite when needed */
+    bool Flush(CAppCache& cache, int nHeight);
+};
+
+extern CAppCacheDB appCacheDB;
+
+#endif // BITCOIN_APPCACHEDB_H
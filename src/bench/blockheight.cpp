@@ -0,0 +1,88 @@
+// Copyright (c) 2017-2018 The Biblepay Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bench.h"
+#include "chain.h"
+#include "main.h"
+
+#include <vector>
+
+static const int BENCH_CHAIN_HEIGHT = 200000;
+
+// A linear chain of block indexes with skip pointers, as LoadBlockIndex leaves it
+static std::vector<CBlockIndex>& GetBenchChain()
+{
+    static std::vector<CBlockIndex> vBlocks(BENCH_CHAIN_HEIGHT + 1);
+    static bool fBuilt = false;
+    if (!fBuilt) {
+        for (int i = 0; i <= BENCH_CHAIN_HEIGHT; i++) {
+            vBlocks[i].nHeight = i;
+            vBlocks[i].pprev = i ? &vBlocks[i - 1] : NULL;
+            vBlocks[i].BuildSkip();
+        }
+        fBuilt = true;
+    }
+    return vBlocks;
+}
+
+static int NextHeight(uint32_t& nState)
+{
+    nState = nState * 1103515245 + 12345;
+    return (nState >> 8) % (BENCH_CHAIN_HEIGHT + 1);
+}
+
+// The previous FindBlockByHeight: walk from the genesis block, the tip or the last result
+static CBlockIndex* FindBlockByHeightWalk(const CChain& chain, CBlockIndex*& pindexLast, int nHeight)
+{
+    CBlockIndex* pindex = nHeight < chain.Height() / 2 ? chain.Genesis() : chain.Tip();
+    if (pindexLast && abs(nHeight - pindex->nHeight) > abs(nHeight - pindexLast->nHeight))
+        pindex = pindexLast;
+    while (pindex->nHeight > nHeight)
+        pindex = pindex->pprev;
+    while (pindex->nHeight < nHeight)
+        pindex = chain.Next(pindex);
+    pindexLast = pindex;
+    return pindex;
+}
+
+static void FindBlockByHeightWalkRandom(benchmark::State& state)
+{
+    CChain chain;
+    chain.SetTip(&GetBenchChain().back());
+    CBlockIndex* pindexLast = NULL;
+    uint32_t nState = 1;
+    while (state.KeepRunning()) {
+        int nHeight = NextHeight(nState);
+        assert(FindBlockByHeightWalk(chain, pindexLast, nHeight)->nHeight == nHeight);
+    }
+}
+
+static void FindBlockByHeightRandom(benchmark::State& state)
+{
+    {
+        LOCK(cs_main);
+        chainActive.SetTip(&GetBenchChain().back());
+    }
+    uint32_t nState = 1;
+    while (state.KeepRunning()) {
+        int nHeight = NextHeight(nState);
+        assert(FindBlockByHeight(nHeight)->nHeight == nHeight);
+    }
+    LOCK(cs_main);
+    chainActive.SetTip(NULL);
+}
+
+static void FindBlockByHeightAncestorRandom(benchmark::State& state)
+{
+    CBlockIndex* pindexTip = &GetBenchChain().back();
+    uint32_t nState = 1;
+    while (state.KeepRunning()) {
+        int nHeight = NextHeight(nState);
+        assert(FindBlockByHeight(nHeight, pindexTip)->nHeight == nHeight);
+    }
+}
+
+BENCHMARK(FindBlockByHeightWalkRandom);
+BENCHMARK(FindBlockByHeightRandom);
+BENCHMARK(FindBlockByHeightAncestorRandom);
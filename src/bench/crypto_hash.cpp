@@ -0,0 +1,142 @@
+// Copyright (c) 2017-2018 The Biblepay Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bench.h"
+
+#include "crypto/common.h"
+#include "crypto/sph_aesni.h"
+#include "crypto/sph_echo.h"
+#include "crypto/sph_groestl.h"
+#include "crypto/sph_shavite.h"
+#include "crypto/x11.h"
+#include "hash.h"
+#include "uint256.h"
+
+#include <assert.h>
+#include <string.h>
+
+//! Nonces hashed per iteration, matching the miner's batch size
+static const unsigned int BENCH_X11_NONCES = X11_MAX_BATCH;
+
+static void InitHeader(unsigned char header[X11_HEADER_SIZE])
+{
+    for (unsigned int i = 0; i < X11_HEADER_SIZE; i++)
+        header[i] = (unsigned char)(i * 37 + 11);
+}
+
+/** The miner's old inner loop: one HashX11 per nonce */
+static void X11Scalar(benchmark::State& state)
+{
+    unsigned char header[X11_HEADER_SIZE];
+    InitHeader(header);
+    uint32_t nNonce = 0;
+    uint256 hash;
+    while (state.KeepRunning()) {
+        for (unsigned int i = 0; i < BENCH_X11_NONCES; i++) {
+            WriteLE32(header + X11_HEADER_SIZE - 4, nNonce++);
+            hash = HashX11(header, header + X11_HEADER_SIZE);
+        }
+    }
+}
+
+/** X11HashHeaders over the same nonces; checks it is bit identical to HashX11 first */
+static void X11Batch(benchmark::State& state)
+{
+    unsigned char header[X11_HEADER_SIZE];
+    unsigned char hashes[32 * BENCH_X11_NONCES];
+    InitHeader(header);
+
+    for (unsigned int nCount = 1; nCount <= BENCH_X11_NONCES; nCount++) {
+        X11HashHeaders(header, 0xfffffff0, nCount, hashes);
+        for (unsigned int i = 0; i < nCount; i++) {
+            unsigned char expected[X11_HEADER_SIZE];
+            memcpy(expected, header, X11_HEADER_SIZE);
+            WriteLE32(expected + X11_HEADER_SIZE - 4, 0xfffffff0 + i);
+            uint256 hash = HashX11(expected, expected + X11_HEADER_SIZE);
+            assert(memcmp(hash.begin(), hashes + 32 * i, 32) == 0);
+        }
+    }
+
+    uint32_t nNonce = 0;
+    while (state.KeepRunning()) {
+        X11HashHeaders(header, nNonce, BENCH_X11_NONCES, hashes);
+        nNonce += BENCH_X11_NONCES;
+    }
+}
+
+/** Full HashX11 of a block header, with whatever kernels this CPU gets */
+static void HashX11Header(benchmark::State& state)
+{
+    unsigned char header[X11_HEADER_SIZE];
+    InitHeader(header);
+    uint256 hash;
+    while (state.KeepRunning()) {
+        hash = HashX11(header, header + X11_HEADER_SIZE);
+        header[0] = hash.begin()[0];
+    }
+}
+
+/** HashX11 with the AES based stages forced onto the portable table code */
+static void HashX11HeaderPortableAES(benchmark::State& state)
+{
+    sph_aesni_enable(0);
+    HashX11Header(state);
+    sph_aesni_enable(1);
+}
+
+/** One of the AES based X11 stages over the 64 bytes X11 feeds it, with or without AES-NI */
+template <typename Context, void (*Init)(void*), void (*Update)(void*, const void*, size_t), void (*Close)(void*, void*)>
+static void BenchSph512(benchmark::State& state, bool fAESNI)
+{
+    unsigned char data[64] = {0};
+    Context ctx;
+    sph_aesni_enable(fAESNI);
+    while (state.KeepRunning()) {
+        Init(&ctx);
+        Update(&ctx, data, sizeof(data));
+        Close(&ctx, data);
+    }
+    sph_aesni_enable(1);
+}
+
+static void Groestl512(benchmark::State& state)
+{
+    BenchSph512<sph_groestl512_context, sph_groestl512_init, sph_groestl512, sph_groestl512_close>(state, true);
+}
+
+static void Groestl512Portable(benchmark::State& state)
+{
+    BenchSph512<sph_groestl512_context, sph_groestl512_init, sph_groestl512, sph_groestl512_close>(state, false);
+}
+
+static void Echo512(benchmark::State& state)
+{
+    BenchSph512<sph_echo512_context, sph_echo512_init, sph_echo512, sph_echo512_close>(state, true);
+}
+
+static void Echo512Portable(benchmark::State& state)
+{
+    BenchSph512<sph_echo512_context, sph_echo512_init, sph_echo512, sph_echo512_close>(state, false);
+}
+
+static void Shavite512(benchmark::State& state)
+{
+    BenchSph512<sph_shavite512_context, sph_shavite512_init, sph_shavite512, sph_shavite512_close>(state, true);
+}
+
+static void Shavite512Portable(benchmark::State& state)
+{
+    BenchSph512<sph_shavite512_context, sph_shavite512_init, sph_shavite512, sph_shavite512_close>(state, false);
+}
+
+BENCHMARK(X11Scalar);
+BENCHMARK(X11Batch);
+BENCHMARK(HashX11Header);
+BENCHMARK(HashX11HeaderPortableAES);
+BENCHMARK(Groestl512);
+BENCHMARK(Groestl512Portable);
+BENCHMARK(Echo512);
+BENCHMARK(Echo512Portable);
+BENCHMARK(Shavite512);
+BENCHMARK(Shavite512Portable);
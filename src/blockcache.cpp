@@ -0,0 +1,212 @@
+// Copyright (c) 2017-2018 The Biblepay Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "blockcache.h"
+
+#include "clientversion.h"
+#include "crypto/common.h"
+#include "main.h"
+#include "serialize.h"
+#include "streams.h"
+#include "util.h"
+
+#include <boost/filesystem.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+CBlockCache blockCache(DEFAULT_BLOCK_CACHE_SIZE << 20);
+CBlockFileCache blockFileCache;
+
+void CBlockCache::EraseEntry(entry_map_t::iterator it)
+{
+    nBytes -= it->second.nSize;
+    listLRU.erase(it->second.itLRU);
+    mapBlocks.erase(it);
+}
+
+void CBlockCache::Trim()
+{
+    while (nBytes > nMaxBytes && !listLRU.empty())
+        EraseEntry(mapBlocks.find(listLRU.back()));
+}
+
+bool CBlockCache::Get(const uint256& hash, bool fPowCheckedRequired, block_ptr& pblockRet)
+{
+    LOCK(cs);
+    entry_map_t::iterator it = mapBlocks.find(hash);
+    if (it == mapBlocks.end() || (fPowCheckedRequired && !it->second.fPowChecked)) {
+        nMisses++;
+        return false;
+    }
+    listLRU.splice(listLRU.begin(), listLRU, it->second.itLRU);
+    pblockRet = it->second.pblock;
+    nHits++;
+    return true;
+}
+
+void CBlockCache::Insert(const uint256& hash, const block_ptr& pblock, size_t nSize, bool fPowChecked)
+{
+    LOCK(cs);
+    entry_map_t::iterator it = mapBlocks.find(hash);
+    if (it != mapBlocks.end()) {
+        it->second.fPowChecked |= fPowChecked;
+        listLRU.splice(listLRU.begin(), listLRU, it->second.itLRU);
+        return;
+    }
+    if (nSize > nMaxBytes)
+        return;
+    CEntry& entry = mapBlocks[hash];
+    entry.pblock = pblock;
+    entry.nSize = nSize;
+    entry.fPowChecked = fPowChecked;
+    entry.itLRU = listLRU.insert(listLRU.begin(), hash);
+    nBytes += nSize;
+    Trim();
+}
+
+void CBlockCache::Erase(const uint256& hash)
+{
+    LOCK(cs);
+    entry_map_t::iterator it = mapBlocks.find(hash);
+    if (it != mapBlocks.end())
+        EraseEntry(it);
+}
+
+void CBlockCache::SetMaxSize(size_t nMaxBytesIn)
+{
+    LOCK(cs);
+    nMaxBytes = nMaxBytesIn;
+    Trim();
+}
+
+void CBlockCache::Clear()
+{
+    LOCK(cs);
+    mapBlocks.clear();
+    listLRU.clear();
+    nBytes = 0;
+}
+
+CBlockCacheStats CBlockCache::GetStats() const
+{
+    LOCK(cs);
+    CBlockCacheStats stats;
+    stats.nBlocks = mapBlocks.size();
+    stats.nBytes = nBytes;
+    stats.nMaxBytes = nMaxBytes;
+    stats.nHits = nHits;
+    stats.nMisses = nMisses;
+    return stats;
+}
+
+struct CBlockFileCache::CMap
+{
+    boost::interprocess::file_mapping mapping;
+    boost::interprocess::mapped_region region;
+
+    explicit CMap(const std::string& sPath) : mapping(sPath.c_str(), boost::interprocess::read_only), region(mapping, boost::interprocess::read_only) {}
+    const char* begin() const { return static_cast<const char*>(region.get_address()); }
+    uint64_t size() const { return region.get_size(); }
+};
+
+CBlockFileCache::map_ptr CBlockFileCache::GetMap(int nFile, uint64_t nEnd)
+{
+    LOCK(cs);
+    std::list<CHandle>::iterator it = listHandles.begin();
+    while (it != listHandles.end() && it->nFile != nFile)
+        ++it;
+    if (it != listHandles.end()) {
+        listHandles.splice(listHandles.begin(), listHandles, it);
+        if (it->pmap->size() < nEnd)
+            it->pmap.reset();
+    } else {
+        listHandles.push_front(CHandle(nFile, map_ptr()));
+        // Dropped maps are unmapped once their last reader is done with them
+        if (listHandles.size() > MAX_OPEN_BLOCK_FILES)
+            listHandles.pop_back();
+    }
+    CHandle& handle = listHandles.front();
+    if (!handle.pmap) {
+        boost::filesystem::path path = GetBlockPosFilename(CDiskBlockPos(nFile, 0), "blk");
+        try {
+            handle.pmap.reset(new CMap(path.string()));
+        } catch (const boost::interprocess::interprocess_exception& e) {
+            listHandles.pop_front();
+            LogPrintf("Unable to map file %s: %s\n", path.string(), e.what());
+            return map_ptr();
+        }
+        handle.fSequential = false;
+        nOpens++;
+    }
+    if (handle.fSequential != (nScans > 0)) {
+        handle.fSequential = nScans > 0;
+        handle.pmap->region.advise(handle.fSequential ? boost::interprocess::mapped_region::advice_sequential : boost::interprocess::mapped_region::advice_normal);
+    }
+    if (handle.pmap->size() < nEnd)
+        return map_ptr();
+    nReads++;
+    return handle.pmap;
+}
+
+bool CBlockFileCache::ReadBlock(const CDiskBlockPos& pos, CBlock& block, size_t& nSizeRet)
+{
+    // Blocks are stored as message start, size, block; pos points at the block
+    if (pos.IsNull() || pos.nPos < 4)
+        return false;
+    map_ptr pmap = GetMap(pos.nFile, pos.nPos);
+    if (!pmap)
+        return error("%s: Unable to read the size of the block at %s", __func__, pos.ToString());
+    uint32_t nSize = ReadLE32((const unsigned char*)pmap->begin() + pos.nPos - 4);
+    if (nSize > MAX_SIZE)
+        return error("%s: Block at %s is too large (%u bytes)", __func__, pos.ToString(), nSize);
+    if (pmap->size() < (uint64_t)pos.nPos + nSize && !(pmap = GetMap(pos.nFile, (uint64_t)pos.nPos + nSize)))
+        return error("%s: Block at %s runs past the end of its file", __func__, pos.ToString());
+
+    try {
+        CSpanReader filein(pmap->begin() + pos.nPos, pmap->begin() + pos.nPos + nSize, SER_DISK, CLIENT_VERSION);
+        filein >> block;
+    }
+    catch (const std::exception& e) {
+        return error("%s: Deserialize or I/O error - %s at %s", __func__, e.what(), pos.ToString());
+    }
+    nSizeRet = nSize;
+    return true;
+}
+
+void CBlockFileCache::Close(int nFile)
+{
+    LOCK(cs);
+    for (std::list<CHandle>::iterator it = listHandles.begin(); it != listHandles.end(); ++it) {
+        if (it->nFile == nFile) {
+            listHandles.erase(it);
+            return;
+        }
+    }
+}
+
+void CBlockFileCache::CloseAll()
+{
+    LOCK(cs);
+    listHandles.clear();
+}
+
+void CBlockFileCache::BeginScan()
+{
+    LOCK(cs);
+    nScans++;
+}
+
+void CBlockFileCache::EndScan()
+{
+    LOCK(cs);
+    nScans--;
+}
+
+void CBlockFileCache::GetStats(size_t& nOpenRet, uint64_t& nOpensRet, uint64_t& nReadsRet) const
+{
+    LOCK(cs);
+    nOpenRet = listHandles.size();
+    nOpensRet = nOpens;
+    nReadsRet = nReads;
+}
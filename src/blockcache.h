@@ -0,0 +1,150 @@
+// Copyright (c) 2017-2018 The Biblepay Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_BLOCKCACHE_H
+#define BITCOIN_BLOCKCACHE_H
+
+#include "primitives/block.h"
+#include "sync.h"
+#include "uint256.h"
+
+#include <list>
+#include <utility>
+#include <vector>
+
+#include <stdint.h>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/unordered_map.hpp>
+
+struct CDiskBlockPos;
+
+/** Default for -blockcachesize, in megabytes */
+static const int64_t DEFAULT_BLOCK_CACHE_SIZE = 16;
+/** Number of blk?????.dat files kept mapped for reading */
+static const size_t MAX_OPEN_BLOCK_FILES = 8;
+
+struct CBlockCacheStats
+{
+    size_t nBlocks;
+    size_t nBytes;
+    size_t nMaxBytes;
+    uint64_t nHits;
+    uint64_t nMisses;
+};
+
+/**
+ * Recently read blocks, shared by everything reading blocks from disk (message
+ * memorization, magnitude reports, RPC, REST, ZMQ). Blocks are immutable and
+ * held through shared pointers keyed by hash; the cache is bounded by the
+ * memory the deserialized blocks use and the least recently used go first. Each block remembers
+ * whether its proof of work was checked when it was read. Thread safe.
+ */
+class CBlockCache
+{
+public:
+    typedef boost::shared_ptr<const CBlock> block_ptr;
+
+private:
+    struct CBlockHasher
+    {
+        size_t operator()(const uint256& hash) const { return hash.GetCheapHash(); }
+    };
+
+    typedef std::list<uint256> lru_list_t;
+
+    struct CEntry
+    {
+        block_ptr pblock;
+        size_t nSize;
+        bool fPowChecked;
+        lru_list_t::iterator itLRU;
+    };
+
+    typedef boost::unordered_map<uint256, CEntry, CBlockHasher> entry_map_t;
+
+    mutable CCriticalSection cs;
+    entry_map_t mapBlocks;
+    //! Most recently used first
+    lru_list_t listLRU;
+    size_t nBytes;
+    size_t nMaxBytes;
+    uint64_t nHits;
+    uint64_t nMisses;
+
+    void EraseEntry(entry_map_t::iterator it);
+    void Trim();
+
+public:
+    explicit CBlockCache(size_t nMaxBytesIn) : nBytes(0), nMaxBytes(nMaxBytesIn), nHits(0), nMisses(0) {}
+
+    /** Look up a block; a block whose proof of work was not checked is only returned when fPowCheckedRequired is false */
+    bool Get(const uint256& hash, bool fPowCheckedRequired, block_ptr& pblockRet);
+    /** Add a block using nSize bytes of memory, or note that its proof of work is checked now */
+    void Insert(const uint256& hash, const block_ptr& pblock, size_t nSize, bool fPowChecked);
+    /** Drop a block, e.g. when it is disconnected */
+    void Erase(const uint256& hash);
+    void SetMaxSize(size_t nMaxBytesIn);
+    void Clear();
+    CBlockCacheStats GetStats() const;
+};
+
+/**
+ * Read-only memory maps of the blk?????.dat files. A block is deserialized
+ * straight from the mapped file, so reading one costs no system call once its
+ * file is mapped. The most recently used MAX_OPEN_BLOCK_FILES files stay
+ * mapped, and a file that grew past its map is mapped again. While a
+ * CBlockFileScan is alive the maps are advised for sequential access. Thread
+ * safe.
+ */
+class CBlockFileCache
+{
+private:
+    struct CMap;
+    typedef boost::shared_ptr<CMap> map_ptr;
+
+    struct CHandle
+    {
+        int nFile;
+        map_ptr pmap;
+        bool fSequential;
+
+        CHandle(int nFileIn, const map_ptr& pmapIn) : nFile(nFileIn), pmap(pmapIn), fSequential(false) {}
+    };
+
+    mutable CCriticalSection cs;
+    //! Most recently used first
+    std::list<CHandle> listHandles;
+    int nScans;
+    uint64_t nOpens;
+    uint64_t nReads;
+
+    /** A map of nFile covering at least nEnd bytes */
+    map_ptr GetMap(int nFile, uint64_t nEnd);
+
+public:
+    CBlockFileCache() : nScans(0), nOpens(0), nReads(0) {}
+
+    /** Deserialize the block at pos (its size is taken from the record header in front of it) */
+    bool ReadBlock(const CDiskBlockPos& pos, CBlock& block, size_t& nSizeRet);
+    /** Unmap a file, e.g. before it is pruned */
+    void Close(int nFile);
+    void CloseAll();
+    void BeginScan();
+    void EndScan();
+    void GetStats(size_t& nOpenRet, uint64_t& nOpensRet, uint64_t& nReadsRet) const;
+};
+
+extern CBlockCache blockCache;
+extern CBlockFileCache blockFileCache;
+
+/** Marks a walk over many blocks in chain order (rescans, VerifyDB, message memorization) for the read ahead of the block file maps */
+class CBlockFileScan
+{
+public:
+    CBlockFileScan() { blockFileCache.BeginScan(); }
+    ~CBlockFileScan() { blockFileCache.EndScan(); }
+};
+
+#endif // BITCOIN_BLOCKCACHE_H
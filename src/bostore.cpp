@@ -0,0 +1,391 @@
+// Copyright (c) 2017-2018 The Biblepay Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bostore.h"
+
+#include "appcache.h"
+#include "base58.h"
+#include "crypto/sha256.h"
+#include "podc.h"
+#include "util.h"
+#include "utilstrencodings.h"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+#include <math.h>
+#include <string.h>
+
+#include <boost/algorithm/string/case_conv.hpp>
+#include <boost/bind.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/thread.hpp>
+
+CBusinessObjectStore::CBusinessObjectStore(const std::string& sDirectoryIn, const BusinessObjectFetcher& fnFetchIn)
+    : sDirectory(sDirectoryIn), fnFetch(fnFetchIn)
+{
+    try {
+        boost::filesystem::create_directories(sDirectory);
+    } catch (const boost::filesystem::filesystem_error& e) {
+        LogPrintf("CBusinessObjectStore: unable to create %s: %s\n", sDirectory, e.what());
+    }
+}
+
+bool CBusinessObjectStore::IsValidHash(const std::string& sHash)
+{
+    if (sHash.empty() || sHash.size() > 128)
+        return false;
+    for (unsigned int i = 0; i < sHash.size(); i++) {
+        char c = sHash[i];
+        if (!((c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z')))
+            return false;
+    }
+    return true;
+}
+
+static void WriteVarInt(std::string& s, uint64_t n)
+{
+    while (n >= 0x80) {
+        s += (char)((n & 0x7f) | 0x80);
+        n >>= 7;
+    }
+    s += (char)n;
+}
+
+/** The dag-pb node ipfs add makes of a file that fits in one chunk */
+static std::string GetUnixFSNode(const std::string& sData)
+{
+    std::string sUnixFS("\x08\x02\x12", 3);
+    WriteVarInt(sUnixFS, sData.size());
+    sUnixFS += sData;
+    sUnixFS += '\x18';
+    WriteVarInt(sUnixFS, sData.size());
+    std::string sNode("\x0a", 1);
+    WriteVarInt(sNode, sUnixFS.size());
+    return sNode + sUnixFS;
+}
+
+static bool IsSHA256Of(const unsigned char* pDigest, const std::string& sData)
+{
+    unsigned char hash[CSHA256::OUTPUT_SIZE];
+    CSHA256().Write((const unsigned char*)sData.data(), sData.size()).Finalize(hash);
+    return memcmp(hash, pDigest, sizeof(hash)) == 0;
+}
+
+bool CBusinessObjectStore::CheckContent(const std::string& sHash, const std::string& sData)
+{
+    static const size_t MAX_SINGLE_BLOCK = 256 * 1024;
+    if (sData.empty())
+        return false;
+
+    // CIDv0 is a base58 sha2-256 multihash of a dag-pb node; CIDv1 in base32 adds a version and codec
+    std::vector<unsigned char> vch;
+    unsigned char nCodec = 0x70;
+    if (sHash.size() == 46 && sHash.compare(0, 2, "Qm") == 0) {
+        if (!DecodeBase58(sHash, vch) || vch.size() != 34)
+            return true;
+    } else if (sHash.size() > 1 && sHash[0] == 'b') {
+        vch = DecodeBase32(sHash.c_str() + 1);
+        if (vch.size() != 36 || vch[0] != 0x01)
+            return true;
+        nCodec = vch[1];
+        vch.erase(vch.begin(), vch.begin() + 2);
+    } else {
+        return true;
+    }
+    if (vch[0] != 0x12 || vch[1] != 0x20)
+        return true;
+    const unsigned char* pDigest = &vch[2];
+    if (nCodec == 0x55)
+        return IsSHA256Of(pDigest, sData);
+    if (nCodec != 0x70 || sData.size() > MAX_SINGLE_BLOCK)
+        return true;
+    return IsSHA256Of(pDigest, GetUnixFSNode(sData));
+}
+
+std::string CBusinessObjectStore::GetPath(const std::string& sHash) const
+{
+    return (boost::filesystem::path(sDirectory) / sHash).string();
+}
+
+bool CBusinessObjectStore::Have(const std::string& sHash) const
+{
+    return IsValidHash(sHash) && boost::filesystem::exists(GetPath(sHash));
+}
+
+bool CBusinessObjectStore::Put(const std::string& sHash, const std::string& sData)
+{
+    if (!IsValidHash(sHash))
+        return false;
+    if (Have(sHash))
+        return true;
+    boost::filesystem::path pathTmp = boost::filesystem::path(sDirectory) / boost::filesystem::unique_path(sHash + ".%%%%-%%%%.tmp");
+    {
+        std::ofstream stream(pathTmp.string().c_str(), std::ios::binary);
+        stream.write(sData.data(), sData.size());
+        if (!stream.good()) {
+            stream.close();
+            boost::filesystem::remove(pathTmp);
+            return error("CBusinessObjectStore::Put: unable to write %s", pathTmp.string());
+        }
+    }
+    // Racing writers of one hash write identical bytes, so whichever rename lands last is fine
+    if (!RenameOver(pathTmp, GetPath(sHash))) {
+        boost::filesystem::remove(pathTmp);
+        return error("CBusinessObjectStore::Put: unable to store %s", sHash);
+    }
+    return true;
+}
+
+bool CBusinessObjectStore::Fetch(const std::string& sHash)
+{
+    boost::filesystem::path pathTmp = boost::filesystem::path(sDirectory) / boost::filesystem::unique_path(sHash + ".%%%%-%%%%.tmp");
+    bool fOk = fnFetch && fnFetch(sHash, pathTmp.string());
+    if (fOk) {
+        // Whatever is stored is served for good, so a truncated or wrong response must not get in
+        std::ifstream stream(pathTmp.string().c_str(), std::ios::binary);
+        std::stringstream ss;
+        ss << stream.rdbuf();
+        if (!stream || !CheckContent(sHash, ss.str())) {
+            LogPrintf("CBusinessObjectStore::Fetch: download of %s does not match its hash\n", sHash);
+            fOk = false;
+        }
+    }
+    try {
+        if (fOk && Have(sHash))
+            boost::filesystem::remove(pathTmp);
+        else if (fOk)
+            fOk = RenameOver(pathTmp, GetPath(sHash));
+        else
+            boost::filesystem::remove(pathTmp);
+    } catch (const boost::filesystem::filesystem_error& e) {
+        return error("CBusinessObjectStore::Fetch: %s", e.what());
+    }
+    return fOk;
+}
+
+bool CBusinessObjectStore::Read(const std::string& sHash, std::string& sData, std::string& sError)
+{
+    if (!IsValidHash(sHash)) {
+        sError = "Invalid IPFS hash.";
+        return false;
+    }
+    if (!Have(sHash) && !Fetch(sHash)) {
+        sError = "IPFS Download error.";
+        return false;
+    }
+    std::ifstream stream(GetPath(sHash).c_str(), std::ios::binary);
+    if (!stream) {
+        sError = "FileSystem Error.";
+        return false;
+    }
+    std::stringstream ss;
+    ss << stream.rdbuf();
+    sData = ss.str();
+    return true;
+}
+
+bool CBusinessObjectStore::Get(const std::string& sHash, UniValue& o, std::string& sError)
+{
+    {
+        LOCK(cs_bostore);
+        std::map<std::string, UniValue>::const_iterator it = mapParsed.find(sHash);
+        if (it != mapParsed.end()) {
+            o = it->second;
+            return true;
+        }
+    }
+
+    std::string sData;
+    if (!Read(sHash, sData, sError))
+        return false;
+    UniValue oParsed(UniValue::VOBJ);
+    if (!oParsed.read(sData)) {
+        sError = "Error parsing JSON business object";
+        return false;
+    }
+
+    LOCK(cs_bostore);
+    if (mapParsed.size() >= MAX_PARSED_OBJECTS)
+        mapParsed.clear();
+    mapParsed[sHash] = oParsed;
+    o = oParsed;
+    return true;
+}
+
+void CBusinessObjectStore::FetchThread(const std::vector<std::string>* pvHashes, size_t* pnNext)
+{
+    while (true) {
+        size_t nIndex;
+        {
+            LOCK(cs_bostore);
+            nIndex = (*pnNext)++;
+        }
+        if (nIndex >= pvHashes->size())
+            return;
+        if (!Fetch((*pvHashes)[nIndex]))
+            LogPrint("ipfs", "CBusinessObjectStore::Prefetch: unable to download %s\n", (*pvHashes)[nIndex]);
+    }
+}
+
+void CBusinessObjectStore::Prefetch(const std::vector<std::string>& vHashes, int nThreads)
+{
+    std::vector<std::string> vMissing;
+    std::set<std::string> setSeen;
+    for (unsigned int i = 0; i < vHashes.size(); i++) {
+        if (IsValidHash(vHashes[i]) && setSeen.insert(vHashes[i]).second && !Have(vHashes[i]))
+            vMissing.push_back(vHashes[i]);
+    }
+    if (vMissing.empty())
+        return;
+
+    size_t nNext = 0;
+    int nWorkers = std::max(1, std::min(nThreads, (int)vMissing.size()));
+    boost::thread_group threadGroup;
+    for (int i = 0; i < nWorkers; i++)
+        threadGroup.create_thread(boost::bind(&CBusinessObjectStore::FetchThread, this, &vMissing, &nNext));
+    threadGroup.join_all();
+}
+
+CBusinessObjectIndex::CBusinessObjectIndex(const CAppCache& cacheIn, const BusinessObjectLoader& fnLoadIn, const BusinessObjectPrefetcher& fnPrefetchIn)
+    : cache(cacheIn), fnLoad(fnLoadIn), fnPrefetch(fnPrefetchIn)
+{
+}
+
+static int64_t ToHundredths(const std::string& sValue)
+{
+    return (int64_t)llround(cdbl(sValue, 2) * 100);
+}
+
+void CBusinessObjectIndex::RemoveEntry(CTypeIndex& index, const std::string& sPrimaryKey)
+{
+    std::map<std::string, CEntry>::iterator it = index.mapEntries.find(sPrimaryKey);
+    if (it == index.mapEntries.end())
+        return;
+    const CEntry& entry = it->second;
+    if (entry.fLive) {
+        index.nLive--;
+        for (std::map<std::string, std::string>::const_iterator itv = entry.mapValues.begin(); itv != entry.mapValues.end(); ++itv) {
+            int nIndexType = index.mapFields[itv->first];
+            if (nIndexType & BO_INDEX_EQUAL) {
+                std::map<std::string, std::set<std::string> >& mapValues = index.mapEqual[itv->first];
+                std::string sValue = boost::to_upper_copy(itv->second);
+                mapValues[sValue].erase(sPrimaryKey);
+                if (mapValues[sValue].empty())
+                    mapValues.erase(sValue);
+            }
+            if (nIndexType & BO_INDEX_SUM)
+                index.mapSums[itv->first] -= ToHundredths(itv->second);
+        }
+    }
+    index.setPending.erase(sPrimaryKey);
+    index.mapEntries.erase(it);
+}
+
+void CBusinessObjectIndex::LoadEntry(CTypeIndex& index, const std::string& sType, const std::string& sPrimaryKey, const std::string& sHash)
+{
+    RemoveEntry(index, sPrimaryKey);
+    CEntry& entry = index.mapEntries[sPrimaryKey];
+    entry.sHash = sHash;
+    UniValue o(UniValue::VOBJ);
+    if (!fnLoad(sType, sPrimaryKey, o)) {
+        index.setPending.insert(sPrimaryKey);
+        return;
+    }
+    if (o["deleted"].getValStr() == "1")
+        return;
+
+    entry.fLive = true;
+    index.nLive++;
+    for (std::map<std::string, int>::const_iterator itf = index.mapFields.begin(); itf != index.mapFields.end(); ++itf) {
+        std::string sValue = o[itf->first].getValStr();
+        entry.mapValues[itf->first] = sValue;
+        if (itf->second & BO_INDEX_EQUAL)
+            index.mapEqual[itf->first][boost::to_upper_copy(sValue)].insert(sPrimaryKey);
+        if (itf->second & BO_INDEX_SUM)
+            index.mapSums[itf->first] += ToHundredths(sValue);
+    }
+}
+
+CBusinessObjectIndex::CTypeIndex& CBusinessObjectIndex::Sync(const std::string& sType, const std::string& sField, int nIndexType)
+{
+    AssertLockHeld(cs_boindex);
+    CTypeIndex& index = mapTypes[sType];
+    int& nFieldIndexType = index.mapFields[sField];
+    if ((nFieldIndexType | nIndexType) != nFieldIndexType) {
+        // A new index needs every object again
+        nFieldIndexType |= nIndexType;
+        std::map<std::string, int> mapFields = index.mapFields;
+        index = CTypeIndex();
+        index.mapFields = mapFields;
+    }
+
+    // Objects that failed to load are tried again, whether or not anything changed
+    std::set<std::string> setRetry = index.setPending;
+    uint64_t nStamp = cache.GetSectionStamp(sType);
+    if (!index.fBuilt || nStamp != index.nStamp) {
+        std::vector<CAppCache::item_t> vItems = cache.GetSection(sType);
+        std::set<std::string> setKeys;
+        std::vector<std::pair<std::string, std::string> > vChanged;
+        for (unsigned int i = 0; i < vItems.size(); i++) {
+            setKeys.insert(vItems[i].first);
+            std::map<std::string, CEntry>::const_iterator it = index.mapEntries.find(vItems[i].first);
+            if (it == index.mapEntries.end() || it->second.sHash != vItems[i].second.sValue)
+                vChanged.push_back(std::make_pair(vItems[i].first, vItems[i].second.sValue));
+        }
+        std::vector<std::string> vRemoved;
+        for (std::map<std::string, CEntry>::const_iterator it = index.mapEntries.begin(); it != index.mapEntries.end(); ++it)
+            if (!setKeys.count(it->first))
+                vRemoved.push_back(it->first);
+        for (unsigned int i = 0; i < vRemoved.size(); i++) {
+            RemoveEntry(index, vRemoved[i]);
+            setRetry.erase(vRemoved[i]);
+        }
+
+        if (fnPrefetch && !vChanged.empty()) {
+            std::vector<std::string> vHashes;
+            for (unsigned int i = 0; i < vChanged.size(); i++)
+                vHashes.push_back(vChanged[i].second);
+            fnPrefetch(vHashes);
+        }
+        for (unsigned int i = 0; i < vChanged.size(); i++) {
+            LoadEntry(index, sType, vChanged[i].first, vChanged[i].second);
+            setRetry.erase(vChanged[i].first);
+        }
+        index.nStamp = nStamp;
+        index.fBuilt = true;
+    }
+    for (std::set<std::string>::const_iterator it = setRetry.begin(); it != setRetry.end(); ++it)
+        LoadEntry(index, sType, *it, index.mapEntries[*it].sHash);
+    return index;
+}
+
+void CBusinessObjectIndex::Declare(const std::string& sType, const std::string& sField, int nIndexType)
+{
+    LOCK(cs_boindex);
+    CTypeIndex& index = mapTypes[boost::to_upper_copy(sType)];
+    if (!index.fBuilt)
+        index.mapFields[sField] |= nIndexType;
+}
+
+bool CBusinessObjectIndex::FindFirst(const std::string& sType, const std::string& sField, const std::string& sValue, std::string& sPrimaryKeyRet)
+{
+    LOCK(cs_boindex);
+    CTypeIndex& index = Sync(boost::to_upper_copy(sType), sField, BO_INDEX_EQUAL);
+    std::map<std::string, std::set<std::string> >& mapValues = index.mapEqual[sField];
+    std::map<std::string, std::set<std::string> >::const_iterator it = mapValues.find(boost::to_upper_copy(sValue));
+    if (it == mapValues.end() || it->second.empty())
+        return false;
+    sPrimaryKeyRet = *it->second.begin();
+    return true;
+}
+
+double CBusinessObjectIndex::GetSum(const std::string& sType, const std::string& sField, int64_t& nCountRet)
+{
+    LOCK(cs_boindex);
+    CTypeIndex& index = Sync(boost::to_upper_copy(sType), sField, BO_INDEX_SUM);
+    nCountRet = index.nLive;
+    return index.mapSums[sField] / 100.0;
+}
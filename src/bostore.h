@@ -0,0 +1,152 @@
+// Copyright (c) 2017-2018 The Biblepay Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_BOSTORE_H
+#define BITCOIN_BOSTORE_H
+
+#include "sync.h"
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <stdint.h>
+
+#include <univalue.h>
+
+#include <boost/function.hpp>
+
+class CAppCache;
+
+/** Downloads the object with the given IPFS hash into sPath; true on success */
+typedef boost::function<bool (const std::string& sHash, const std::string& sPath)> BusinessObjectFetcher;
+
+/**
+ * Local store of business objects keyed by their IPFS hash.
+ *
+ * IPFS content never changes under its hash, so an object is downloaded once
+ * into its own file and kept: a download goes to a private temporary file and
+ * is renamed into place, and an existing file is never overwritten. Parsed
+ * objects are kept in memory as well, so listing a section of N objects costs
+ * N lookups once the objects are local. Prefetch() downloads the missing ones
+ * of a batch concurrently.
+ */
+class CBusinessObjectStore
+{
+private:
+    static const size_t MAX_PARSED_OBJECTS = 10000;
+
+    mutable CCriticalSection cs_bostore;
+    std::string sDirectory;
+    BusinessObjectFetcher fnFetch;
+    std::map<std::string, UniValue> mapParsed;
+
+    std::string GetPath(const std::string& sHash) const;
+    bool Fetch(const std::string& sHash);
+    void FetchThread(const std::vector<std::string>* pvHashes, size_t* pnNext);
+
+    CBusinessObjectStore(const CBusinessObjectStore&);
+    void operator=(const CBusinessObjectStore&);
+
+public:
+    CBusinessObjectStore(const std::string& sDirectoryIn, const BusinessObjectFetcher& fnFetchIn);
+
+    /** IPFS hashes are base58 or base32; anything else cannot name a file in the store */
+    static bool IsValidHash(const std::string& sHash);
+    /**
+     * Whether a download may be stored as sHash: it must not be empty, and if
+     * sHash is a sha2-256 CID of a single block object (raw, or a UnixFS file
+     * of up to one default chunk) the data must hash to it.
+     */
+    static bool CheckContent(const std::string& sHash, const std::string& sData);
+
+    /** Whether the object is stored locally */
+    bool Have(const std::string& sHash) const;
+    /** Store an object (a no-op if it is already stored) */
+    bool Put(const std::string& sHash, const std::string& sData);
+    /** Raw object data, downloading it if necessary */
+    bool Read(const std::string& sHash, std::string& sData, std::string& sError);
+    /** Parsed JSON object, downloading it if necessary */
+    bool Get(const std::string& sHash, UniValue& o, std::string& sError);
+    /** Download the objects of vHashes that are not stored yet, using up to nThreads connections */
+    void Prefetch(const std::vector<std::string>& vHashes, int nThreads);
+};
+
+/** Secondary indexes a business object field can have */
+enum BusinessObjectIndexType
+{
+    //! Upper case field value -> primary keys
+    BO_INDEX_EQUAL = 1,
+    //! Sum of the field, rounded to 2 places, over the live objects
+    BO_INDEX_SUM = 2,
+};
+
+/** Loads a business object by type and primary key; false if it is not available (yet) */
+typedef boost::function<bool (const std::string& sType, const std::string& sPrimaryKey, UniValue& o)> BusinessObjectLoader;
+/** Makes a batch of objects available before they are loaded one by one */
+typedef boost::function<void (const std::vector<std::string>& vHashes)> BusinessObjectPrefetcher;
+
+/**
+ * Secondary indexes over the business objects of the application cache, where
+ * each section (object type) maps primary keys to IPFS hashes.
+ *
+ * Indexes are declared per type and field. A type is indexed on first use and
+ * then kept in step with the application cache: when the section stamp shows
+ * new, changed or removed keys, only those objects are loaded again, so
+ * ingesting objects costs one load each and lookups and totals on an
+ * unchanged type cost no loads at all. Deleted objects ("deleted" = "1") are
+ * left out; objects that fail to load are retried on the next query.
+ */
+class CBusinessObjectIndex
+{
+private:
+    struct CEntry
+    {
+        std::string sHash;
+        //! Loaded and not deleted
+        bool fLive;
+        //! Indexed field -> value
+        std::map<std::string, std::string> mapValues;
+
+        CEntry() : fLive(false) {}
+    };
+
+    struct CTypeIndex
+    {
+        uint64_t nStamp;
+        bool fBuilt;
+        std::map<std::string, int> mapFields;
+        std::map<std::string, CEntry> mapEntries;
+        std::set<std::string> setPending;
+        std::map<std::string, std::map<std::string, std::set<std::string> > > mapEqual;
+        //! In hundredths, so removing an object restores the exact sum
+        std::map<std::string, int64_t> mapSums;
+        int64_t nLive;
+
+        CTypeIndex() : nStamp(0), fBuilt(false), nLive(0) {}
+    };
+
+    CCriticalSection cs_boindex;
+    const CAppCache& cache;
+    BusinessObjectLoader fnLoad;
+    BusinessObjectPrefetcher fnPrefetch;
+    std::map<std::string, CTypeIndex> mapTypes;
+
+    void RemoveEntry(CTypeIndex& index, const std::string& sPrimaryKey);
+    void LoadEntry(CTypeIndex& index, const std::string& sType, const std::string& sPrimaryKey, const std::string& sHash);
+    CTypeIndex& Sync(const std::string& sType, const std::string& sField, int nIndexType);
+
+public:
+    CBusinessObjectIndex(const CAppCache& cacheIn, const BusinessObjectLoader& fnLoadIn, const BusinessObjectPrefetcher& fnPrefetchIn = BusinessObjectPrefetcher());
+
+    /** Index sField of sType; queries declare what they use, so this only saves a rebuild */
+    void Declare(const std::string& sType, const std::string& sField, int nIndexType);
+    /** First live object of sType (in key order) whose sField equals sValue, ignoring case */
+    bool FindFirst(const std::string& sType, const std::string& sField, const std::string& sValue, std::string& sPrimaryKeyRet);
+    /** Sum of sField over the live objects of sType, and their number */
+    double GetSum(const std::string& sType, const std::string& sField, int64_t& nCountRet);
+};
+
+#endif // BITCOIN_BOSTORE_H
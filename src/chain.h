@@ -142,6 +142,7 @@ public:
     unsigned int nTime;
     unsigned int nBits;
     unsigned int nNonce;
+	//! BibleHash of this header, filled in once it passed CheckProofOfWork (null if unknown)
 	uint256 hashBibleHash;
 	std::string sBlockMessage;
 
@@ -168,6 +169,7 @@ public:
         nTime          = 0;
         nBits          = 0;
         nNonce         = 0;
+		hashBibleHash  = uint256();
 		sBlockMessage  = "";
     }
 
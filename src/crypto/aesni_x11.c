@@ -0,0 +1,435 @@
+/* Copyright (c) 2017-2018 The Biblepay Core developers
+ * Distributed under the MIT software license, see the accompanying
+ * file COPYING or http://www.opensource.org/licenses/mit-license.php.
+ */
+
+/*
+ * AES-NI kernels for Groestl-512, ECHO-512 and SHAvite-512, see sph_aesni.h.
+ * This file is compiled with -maes -mssse3; nothing here may run before
+ * sph_aesni_get() has checked the CPU.
+ *
+ * All three work on the little-endian byte layout the sph code keeps its
+ * state in, so a 128-bit load of a state word gives exactly the AES state
+ * the portable AES_ROUND_LE macros operate on.
+ */
+
+#ifdef ENABLE_AESNI
+
+#include <stddef.h>
+#include <string.h>
+
+#include <emmintrin.h>
+#include <tmmintrin.h>
+#include <wmmintrin.h>
+
+#include "sph_aesni.h"
+
+#define LOAD(p)       _mm_loadu_si128((const __m128i *)(const void *)(p))
+#define STORE(p, x)   _mm_storeu_si128((__m128i *)(void *)(p), x)
+
+/* Multiplication by x in GF(2^8) (modulo x^8 + x^4 + x^3 + x + 1), bytewise */
+static inline __m128i
+mul2(__m128i a)
+{
+	__m128i top = _mm_cmpgt_epi8(_mm_setzero_si128(), a);
+
+	return _mm_xor_si128(_mm_add_epi8(a, a),
+		_mm_and_si128(top, _mm_set1_epi8(0x1B)));
+}
+
+/* ======================================================================
+ * Groestl-512
+ *
+ * The 8x16 byte state is kept as eight row vectors. A round is
+ * AddRoundConstant, then for each row a byte shuffle and AESENCLAST with a
+ * zero key (SubBytes), then MixBytes computed on whole rows.
+ */
+
+/*
+ * AESENCLAST applies ShiftRows along with SubBytes; these shuffles undo it
+ * and rotate the row left by ShiftBytes' amount at the same time.
+ */
+#define SHUF_ROW(s)   _mm_setr_epi8( \
+		(0 + s) & 15, (13 + s) & 15, (10 + s) & 15, (7 + s) & 15, \
+		(4 + s) & 15, (1 + s) & 15, (14 + s) & 15, (11 + s) & 15, \
+		(8 + s) & 15, (5 + s) & 15, (2 + s) & 15, (15 + s) & 15, \
+		(12 + s) & 15, (9 + s) & 15, (6 + s) & 15, (3 + s) & 15)
+
+/* Byte j of row 0 (P) or row 7 (Q) gets j << 4, xored with the round */
+#define GROESTL_RC_BASE   _mm_setr_epi8(0x00, 0x10, 0x20, 0x30, \
+		0x40, 0x50, 0x60, 0x70, (char)0x80, (char)0x90, (char)0xA0, \
+		(char)0xB0, (char)0xC0, (char)0xD0, (char)0xE0, (char)0xF0)
+
+/*
+ * MixBytes: row i of the circulant matrix (02 02 03 04 05 03 05 07),
+ * factored to need only two doublings per row:
+ *   t_i = a_i + a_{i+1}, y_i = t_i + t_{i+2} + a_{i+6},
+ *   w_i = 2 (t_i + t_{i+3}) + y_{i+4}, b_i = 2 w_{i+3} + y_{i+4}
+ */
+#define GROESTL_MIX_BYTES(a0, a1, a2, a3, a4, a5, a6, a7)   do { \
+		__m128i t0, t1, t2, t3, t4, t5, t6, t7; \
+		__m128i y0, y1, y2, y3, y4, y5, y6, y7; \
+		__m128i w0, w1, w2, w3, w4, w5, w6, w7; \
+		t0 = _mm_xor_si128(a0, a1); \
+		t1 = _mm_xor_si128(a1, a2); \
+		t2 = _mm_xor_si128(a2, a3); \
+		t3 = _mm_xor_si128(a3, a4); \
+		t4 = _mm_xor_si128(a4, a5); \
+		t5 = _mm_xor_si128(a5, a6); \
+		t6 = _mm_xor_si128(a6, a7); \
+		t7 = _mm_xor_si128(a7, a0); \
+		y0 = _mm_xor_si128(_mm_xor_si128(t0, t2), a6); \
+		y1 = _mm_xor_si128(_mm_xor_si128(t1, t3), a7); \
+		y2 = _mm_xor_si128(_mm_xor_si128(t2, t4), a0); \
+		y3 = _mm_xor_si128(_mm_xor_si128(t3, t5), a1); \
+		y4 = _mm_xor_si128(_mm_xor_si128(t4, t6), a2); \
+		y5 = _mm_xor_si128(_mm_xor_si128(t5, t7), a3); \
+		y6 = _mm_xor_si128(_mm_xor_si128(t6, t0), a4); \
+		y7 = _mm_xor_si128(_mm_xor_si128(t7, t1), a5); \
+		w0 = _mm_xor_si128(mul2(_mm_xor_si128(t0, t3)), y4); \
+		w1 = _mm_xor_si128(mul2(_mm_xor_si128(t1, t4)), y5); \
+		w2 = _mm_xor_si128(mul2(_mm_xor_si128(t2, t5)), y6); \
+		w3 = _mm_xor_si128(mul2(_mm_xor_si128(t3, t6)), y7); \
+		w4 = _mm_xor_si128(mul2(_mm_xor_si128(t4, t7)), y0); \
+		w5 = _mm_xor_si128(mul2(_mm_xor_si128(t5, t0)), y1); \
+		w6 = _mm_xor_si128(mul2(_mm_xor_si128(t6, t1)), y2); \
+		w7 = _mm_xor_si128(mul2(_mm_xor_si128(t7, t2)), y3); \
+		a0 = _mm_xor_si128(mul2(w3), y4); \
+		a1 = _mm_xor_si128(mul2(w4), y5); \
+		a2 = _mm_xor_si128(mul2(w5), y6); \
+		a3 = _mm_xor_si128(mul2(w6), y7); \
+		a4 = _mm_xor_si128(mul2(w7), y0); \
+		a5 = _mm_xor_si128(mul2(w0), y1); \
+		a6 = _mm_xor_si128(mul2(w1), y2); \
+		a7 = _mm_xor_si128(mul2(w2), y3); \
+	} while (0)
+
+/* SubBytes and ShiftBytes of one row, shifted left by s columns */
+#define GROESTL_SUB_SHIFT(x, s) \
+	_mm_aesenclast_si128(_mm_shuffle_epi8(x, SHUF_ROW(s)), _mm_setzero_si128())
+
+/* One round of P on p0..p7, or of Q on q0..q7 */
+#define GROESTL_ROUND_P(round)   do { \
+		p0 = _mm_xor_si128(p0, \
+			_mm_xor_si128(rc, _mm_set1_epi8((char)(round)))); \
+		p0 = GROESTL_SUB_SHIFT(p0, 0); \
+		p1 = GROESTL_SUB_SHIFT(p1, 1); \
+		p2 = GROESTL_SUB_SHIFT(p2, 2); \
+		p3 = GROESTL_SUB_SHIFT(p3, 3); \
+		p4 = GROESTL_SUB_SHIFT(p4, 4); \
+		p5 = GROESTL_SUB_SHIFT(p5, 5); \
+		p6 = GROESTL_SUB_SHIFT(p6, 6); \
+		p7 = GROESTL_SUB_SHIFT(p7, 11); \
+		GROESTL_MIX_BYTES(p0, p1, p2, p3, p4, p5, p6, p7); \
+	} while (0)
+
+#define GROESTL_ROUND_Q(round)   do { \
+		q7 = _mm_xor_si128(q7, \
+			_mm_xor_si128(rc, _mm_set1_epi8((char)((round) ^ 0xFF)))); \
+		q0 = GROESTL_SUB_SHIFT(_mm_xor_si128(q0, ones), 1); \
+		q1 = GROESTL_SUB_SHIFT(_mm_xor_si128(q1, ones), 3); \
+		q2 = GROESTL_SUB_SHIFT(_mm_xor_si128(q2, ones), 5); \
+		q3 = GROESTL_SUB_SHIFT(_mm_xor_si128(q3, ones), 11); \
+		q4 = GROESTL_SUB_SHIFT(_mm_xor_si128(q4, ones), 0); \
+		q5 = GROESTL_SUB_SHIFT(_mm_xor_si128(q5, ones), 2); \
+		q6 = GROESTL_SUB_SHIFT(_mm_xor_si128(q6, ones), 4); \
+		q7 = GROESTL_SUB_SHIFT(q7, 6); \
+		GROESTL_MIX_BYTES(q0, q1, q2, q3, q4, q5, q6, q7); \
+	} while (0)
+
+/* P(g) and Q(m) side by side: the two AESENCLAST chains hide each other's latency */
+static void
+groestl_perm_pq(__m128i *g, __m128i *m)
+{
+	const __m128i rc = GROESTL_RC_BASE;
+	const __m128i ones = _mm_set1_epi8((char)0xFF);
+	__m128i p0 = g[0], p1 = g[1], p2 = g[2], p3 = g[3];
+	__m128i p4 = g[4], p5 = g[5], p6 = g[6], p7 = g[7];
+	__m128i q0 = m[0], q1 = m[1], q2 = m[2], q3 = m[3];
+	__m128i q4 = m[4], q5 = m[5], q6 = m[6], q7 = m[7];
+	int round;
+
+	for (round = 0; round < 14; round ++) {
+		GROESTL_ROUND_P(round);
+		GROESTL_ROUND_Q(round);
+	}
+	g[0] = p0; g[1] = p1; g[2] = p2; g[3] = p3;
+	g[4] = p4; g[5] = p5; g[6] = p6; g[7] = p7;
+	m[0] = q0; m[1] = q1; m[2] = q2; m[3] = q3;
+	m[4] = q4; m[5] = q5; m[6] = q6; m[7] = q7;
+}
+
+static void
+groestl_perm_p(__m128i *g)
+{
+	const __m128i rc = GROESTL_RC_BASE;
+	__m128i p0 = g[0], p1 = g[1], p2 = g[2], p3 = g[3];
+	__m128i p4 = g[4], p5 = g[5], p6 = g[6], p7 = g[7];
+	int round;
+
+	for (round = 0; round < 14; round ++)
+		GROESTL_ROUND_P(round);
+	g[0] = p0; g[1] = p1; g[2] = p2; g[3] = p3;
+	g[4] = p4; g[5] = p5; g[6] = p6; g[7] = p7;
+}
+
+/*
+ * Column bytes (the sph layout: byte 8 * column + row) to row vectors.
+ * Pairs of columns are interleaved into 16-bit lanes, then an 8x8
+ * transpose of those lanes gathers each row.
+ */
+static inline void
+transpose_8x8_epi16(__m128i *x)
+{
+	__m128i t0, t1, t2, t3, t4, t5, t6, t7;
+	__m128i u0, u1, u2, u3, u4, u5, u6, u7;
+
+	t0 = _mm_unpacklo_epi16(x[0], x[1]);
+	t1 = _mm_unpackhi_epi16(x[0], x[1]);
+	t2 = _mm_unpacklo_epi16(x[2], x[3]);
+	t3 = _mm_unpackhi_epi16(x[2], x[3]);
+	t4 = _mm_unpacklo_epi16(x[4], x[5]);
+	t5 = _mm_unpackhi_epi16(x[4], x[5]);
+	t6 = _mm_unpacklo_epi16(x[6], x[7]);
+	t7 = _mm_unpackhi_epi16(x[6], x[7]);
+	u0 = _mm_unpacklo_epi32(t0, t2);
+	u1 = _mm_unpackhi_epi32(t0, t2);
+	u2 = _mm_unpacklo_epi32(t1, t3);
+	u3 = _mm_unpackhi_epi32(t1, t3);
+	u4 = _mm_unpacklo_epi32(t4, t6);
+	u5 = _mm_unpackhi_epi32(t4, t6);
+	u6 = _mm_unpacklo_epi32(t5, t7);
+	u7 = _mm_unpackhi_epi32(t5, t7);
+	x[0] = _mm_unpacklo_epi64(u0, u4);
+	x[1] = _mm_unpackhi_epi64(u0, u4);
+	x[2] = _mm_unpacklo_epi64(u1, u5);
+	x[3] = _mm_unpackhi_epi64(u1, u5);
+	x[4] = _mm_unpacklo_epi64(u2, u6);
+	x[5] = _mm_unpackhi_epi64(u2, u6);
+	x[6] = _mm_unpacklo_epi64(u3, u7);
+	x[7] = _mm_unpackhi_epi64(u3, u7);
+}
+
+static inline void
+groestl_to_rows(__m128i *r, const unsigned char *src)
+{
+	const __m128i interleave = _mm_setr_epi8(
+		0, 8, 1, 9, 2, 10, 3, 11, 4, 12, 5, 13, 6, 14, 7, 15);
+	int i;
+
+	for (i = 0; i < 8; i ++)
+		r[i] = _mm_shuffle_epi8(LOAD(src + 16 * i), interleave);
+	transpose_8x8_epi16(r);
+}
+
+static inline void
+groestl_from_rows(unsigned char *dst, __m128i *r)
+{
+	const __m128i deinterleave = _mm_setr_epi8(
+		0, 2, 4, 6, 8, 10, 12, 14, 1, 3, 5, 7, 9, 11, 13, 15);
+	int i;
+
+	transpose_8x8_epi16(r);
+	for (i = 0; i < 8; i ++)
+		STORE(dst + 16 * i, _mm_shuffle_epi8(r[i], deinterleave));
+}
+
+/* H ^= P(H ^ m) ^ Q(m) */
+static void
+aesni_groestl_big_compress(void *H, const unsigned char *buf)
+{
+	__m128i h[8], g[8], m[8];
+	int i;
+
+	groestl_to_rows(h, (const unsigned char *)H);
+	groestl_to_rows(m, buf);
+	for (i = 0; i < 8; i ++)
+		g[i] = _mm_xor_si128(h[i], m[i]);
+	groestl_perm_pq(g, m);
+	for (i = 0; i < 8; i ++)
+		h[i] = _mm_xor_si128(h[i], _mm_xor_si128(g[i], m[i]));
+	groestl_from_rows((unsigned char *)H, h);
+}
+
+/* H ^= P(H) */
+static void
+aesni_groestl_big_final(void *H)
+{
+	__m128i h[8], x[8];
+	int i;
+
+	groestl_to_rows(h, (const unsigned char *)H);
+	memcpy(x, h, sizeof x);
+	groestl_perm_p(x);
+	for (i = 0; i < 8; i ++)
+		h[i] = _mm_xor_si128(h[i], x[i]);
+	groestl_from_rows((unsigned char *)H, h);
+}
+
+/* ======================================================================
+ * ECHO-512: 16 AES states, each through two AES rounds per round (the
+ * first keyed with the running 128-bit counter), then the word
+ * ShiftRows and MixColumns.
+ */
+
+static inline void
+echo_mix_column(__m128i *w, int ia, int ib, int ic, int id)
+{
+	__m128i a = w[ia], b = w[ib], c = w[ic], d = w[id];
+	__m128i ab = _mm_xor_si128(a, b);
+	__m128i bc = _mm_xor_si128(b, c);
+	__m128i cd = _mm_xor_si128(c, d);
+	__m128i abx = mul2(ab);
+	__m128i bcx = mul2(bc);
+	__m128i cdx = mul2(cd);
+
+	w[ia] = _mm_xor_si128(abx, _mm_xor_si128(bc, d));
+	w[ib] = _mm_xor_si128(bcx, _mm_xor_si128(a, cd));
+	w[ic] = _mm_xor_si128(cdx, _mm_xor_si128(ab, d));
+	w[id] = _mm_xor_si128(_mm_xor_si128(abx, bcx),
+		_mm_xor_si128(cdx, _mm_xor_si128(ab, c)));
+}
+
+static void
+aesni_echo_big_compress(sph_echo_big_context *sc)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const unsigned char *V = (const unsigned char *)&sc->u;
+	__m128i w[16], t;
+	unsigned long long klo, khi;
+	int round, n;
+
+	for (n = 0; n < 8; n ++) {
+		w[n] = LOAD(V + 16 * n);
+		w[n + 8] = LOAD(sc->buf + 16 * n);
+	}
+	klo = (unsigned long long)sc->C0 | ((unsigned long long)sc->C1 << 32);
+	khi = (unsigned long long)sc->C2 | ((unsigned long long)sc->C3 << 32);
+
+	for (round = 0; round < 10; round ++) {
+		for (n = 0; n < 16; n ++) {
+			__m128i k = _mm_set_epi64x((long long)khi, (long long)klo);
+
+			w[n] = _mm_aesenc_si128(_mm_aesenc_si128(w[n], k), zero);
+			if (++ klo == 0)
+				khi ++;
+		}
+
+		/* ShiftRows on the 4x4 matrix of words (column-major) */
+		t = w[1]; w[1] = w[5]; w[5] = w[9]; w[9] = w[13]; w[13] = t;
+		t = w[2]; w[2] = w[10]; w[10] = t;
+		t = w[6]; w[6] = w[14]; w[14] = t;
+		t = w[15]; w[15] = w[11]; w[11] = w[7]; w[7] = w[3]; w[3] = t;
+
+		echo_mix_column(w, 0, 1, 2, 3);
+		echo_mix_column(w, 4, 5, 6, 7);
+		echo_mix_column(w, 8, 9, 10, 11);
+		echo_mix_column(w, 12, 13, 14, 15);
+	}
+
+	for (n = 0; n < 8; n ++) {
+		t = _mm_xor_si128(LOAD(V + 16 * n), LOAD(sc->buf + 16 * n));
+		t = _mm_xor_si128(t, _mm_xor_si128(w[n], w[n + 8]));
+		STORE((unsigned char *)&sc->u + 16 * n, t);
+	}
+}
+
+/* ======================================================================
+ * SHAvite-512: a 14 round Feistel-like structure over four 128-bit words,
+ * with 448 words of round keys expanded from the message and the counter.
+ */
+
+static void
+aesni_shavite_big_compress(sph_shavite_big_context *sc, const void *msg)
+{
+	const __m128i zero = _mm_setzero_si128();
+	__m128i rk[112];
+	__m128i p0, p1, p2, p3, t;
+	size_t u;
+	int r, s;
+
+	for (u = 0; u < 8; u ++)
+		rk[u] = LOAD((const unsigned char *)msg + 16 * u);
+
+	/*
+	 * Same schedule as c512(): the non-linear step is one key-less AES
+	 * round of the previous-but-seven word rotated by one 32-bit lane,
+	 * xored with the previous word; the counter goes in at four places.
+	 */
+	u = 8;
+	for (;;) {
+		for (s = 0; s < 4; s ++) {
+			t = _mm_aesenc_si128(_mm_shuffle_epi32(rk[u - 8], 0x39), zero);
+			rk[u] = _mm_xor_si128(t, rk[u - 1]);
+			if (u == 8)
+				rk[u] = _mm_xor_si128(rk[u], _mm_setr_epi32(
+					(int)sc->count0, (int)sc->count1,
+					(int)sc->count2, (int)~sc->count3));
+			else if (u == 110)
+				rk[u] = _mm_xor_si128(rk[u], _mm_setr_epi32(
+					(int)sc->count1, (int)sc->count0,
+					(int)sc->count3, (int)~sc->count2));
+			u ++;
+
+			t = _mm_aesenc_si128(_mm_shuffle_epi32(rk[u - 8], 0x39), zero);
+			rk[u] = _mm_xor_si128(t, rk[u - 1]);
+			if (u == 41)
+				rk[u] = _mm_xor_si128(rk[u], _mm_setr_epi32(
+					(int)sc->count3, (int)sc->count2,
+					(int)sc->count1, (int)~sc->count0));
+			else if (u == 79)
+				rk[u] = _mm_xor_si128(rk[u], _mm_setr_epi32(
+					(int)sc->count2, (int)sc->count3,
+					(int)sc->count0, (int)~sc->count1));
+			u ++;
+		}
+		if (u == 112)
+			break;
+		/* Linear step: rk[u] ^ (the four words starting 7 words back) */
+		for (s = 0; s < 8; s ++) {
+			rk[u] = _mm_xor_si128(rk[u - 8],
+				_mm_alignr_epi8(rk[u - 1], rk[u - 2], 4));
+			u ++;
+		}
+	}
+
+	p0 = LOAD(sc->h);
+	p1 = LOAD(sc->h + 4);
+	p2 = LOAD(sc->h + 8);
+	p3 = LOAD(sc->h + 12);
+	u = 0;
+	for (r = 0; r < 14; r ++) {
+		t = _mm_xor_si128(p1, rk[u]);
+		t = _mm_aesenc_si128(t, rk[u + 1]);
+		t = _mm_aesenc_si128(t, rk[u + 2]);
+		t = _mm_aesenc_si128(t, rk[u + 3]);
+		p0 = _mm_xor_si128(p0, _mm_aesenc_si128(t, zero));
+
+		t = _mm_xor_si128(p3, rk[u + 4]);
+		t = _mm_aesenc_si128(t, rk[u + 5]);
+		t = _mm_aesenc_si128(t, rk[u + 6]);
+		t = _mm_aesenc_si128(t, rk[u + 7]);
+		p2 = _mm_xor_si128(p2, _mm_aesenc_si128(t, zero));
+		u += 8;
+
+		/* (p0, p1, p2, p3) <- (p3, p0, p1, p2) */
+		t = p3;
+		p3 = p2;
+		p2 = p1;
+		p1 = p0;
+		p0 = t;
+	}
+	STORE(sc->h, _mm_xor_si128(LOAD(sc->h), p0));
+	STORE(sc->h + 4, _mm_xor_si128(LOAD(sc->h + 4), p1));
+	STORE(sc->h + 8, _mm_xor_si128(LOAD(sc->h + 8), p2));
+	STORE(sc->h + 12, _mm_xor_si128(LOAD(sc->h + 12), p3));
+}
+
+const sph_aesni_kernels sph_aesni_x11_kernels = {
+	aesni_groestl_big_compress,
+	aesni_groestl_big_final,
+	aesni_echo_big_compress,
+	aesni_shavite_big_compress
+};
+
+#endif /* ENABLE_AESNI */
@@ -35,6 +35,7 @@
 #include <limits.h>
 
 #include "sph_echo.h"
+#include "sph_aesni.h"
 
 #ifdef __cplusplus
 extern "C"{
@@ -723,7 +724,12 @@ static void
 echo_big_compress(sph_echo_big_context *sc)
 {
 	DECL_STATE_BIG
+	const sph_aesni_kernels *aesni = sph_aesni_get();
 
+	if (aesni != NULL) {
+		aesni->echo_big_compress(sc);
+		return;
+	}
 	COMPRESS_BIG(sc);
 }
 
@@ -34,6 +34,7 @@
 #include <string.h>
 
 #include "sph_groestl.h"
+#include "sph_aesni.h"
 
 #ifdef __cplusplus
 extern "C"{
@@ -2908,6 +2909,7 @@ groestl_big_core(sph_groestl_big_context *sc, const void *data, size_t len)
 {
 	unsigned char *buf;
 	size_t ptr;
+	const sph_aesni_kernels *aesni = sph_aesni_get();
 	DECL_STATE_BIG
 
 	buf = sc->buf;
@@ -2931,6 +2933,11 @@ groestl_big_core(sph_groestl_big_context *sc, const void *data, size_t len)
 		data = (const unsigned char *)data + clen;
 		len -= clen;
 		if (ptr == sizeof sc->buf) {
+#if USE_LE
+			if (aesni != NULL)
+				aesni->groestl_big_compress(H, buf);
+			else
+#endif
 			COMPRESS_BIG;
 #if SPH_64
 			sc->count ++;
@@ -2958,6 +2965,7 @@ groestl_big_close(sph_groestl_big_context *sc,
 	sph_u32 count_high, count_low;
 #endif
 	unsigned z;
+	const sph_aesni_kernels *aesni = sph_aesni_get();
 	DECL_STATE_BIG
 
 	buf = sc->buf;
@@ -2994,6 +3002,11 @@ groestl_big_close(sph_groestl_big_context *sc,
 #endif
 	groestl_big_core(sc, pad, pad_len);
 	READ_STATE_BIG(sc);
+#if USE_LE
+	if (aesni != NULL)
+		aesni->groestl_big_final(H);
+	else
+#endif
 	FINAL_BIG;
 #if SPH_GROESTL_64
 	for (u = 0; u < 8; u ++)
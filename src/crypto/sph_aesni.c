@@ -0,0 +1,63 @@
+/* Copyright (c) 2017-2018 The Biblepay Core developers
+ * Distributed under the MIT software license, see the accompanying
+ * file COPYING or http://www.opensource.org/licenses/mit-license.php.
+ */
+
+#if defined(HAVE_CONFIG_H)
+#include "config/biblepay-config.h"
+#endif
+
+#include <stddef.h>
+
+#include "sph_aesni.h"
+
+#if defined(ENABLE_AESNI) && (defined(__x86_64__) || defined(__i386__))
+#include <cpuid.h>
+#define SPH_HAVE_AESNI   1
+
+/* Defined in aesni_x11.c, which is built with the AES-NI compiler flags */
+extern const sph_aesni_kernels sph_aesni_x11_kernels;
+#endif
+
+/* -1 until the CPU was probed; probing twice is harmless */
+static volatile int aesni_supported = -1;
+static volatile int aesni_enabled = 1;
+
+static int
+aesni_probe(void)
+{
+#ifdef SPH_HAVE_AESNI
+	unsigned int eax, ebx, ecx, edx;
+
+	if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+		return 0;
+	/* AES (bit 25) and SSSE3 (bit 9) */
+	return ((ecx >> 25) & 1) && ((ecx >> 9) & 1);
+#else
+	return 0;
+#endif
+}
+
+int
+sph_aesni_available(void)
+{
+	if (aesni_supported < 0)
+		aesni_supported = aesni_probe();
+	return aesni_supported;
+}
+
+void
+sph_aesni_enable(int enable)
+{
+	aesni_enabled = enable != 0;
+}
+
+const sph_aesni_kernels *
+sph_aesni_get(void)
+{
+#ifdef SPH_HAVE_AESNI
+	if (aesni_enabled && sph_aesni_available())
+		return &sph_aesni_x11_kernels;
+#endif
+	return NULL;
+}
@@ -0,0 +1,61 @@
+/* Copyright (c) 2017-2018 The Biblepay Core developers
+ * Distributed under the MIT software license, see the accompanying
+ * file COPYING or http://www.opensource.org/licenses/mit-license.php.
+ */
+
+/**
+ * AES-NI compression functions for the AES based X11 stages (Groestl-512,
+ * ECHO-512 and SHAvite-512).
+ *
+ * The sph_* implementations ask sph_aesni_get() for the kernels on every
+ * compression and fall back to their portable table code when it returns
+ * NULL, so callers keep using the plain sph_* API. The kernels are only
+ * built when the compiler supports AES-NI (ENABLE_AESNI) and only used when
+ * CPUID reports AES and SSSE3. Besides being faster they avoid the
+ * secret-dependent table lookups of the portable code.
+ *
+ * @file     sph_aesni.h
+ */
+
+#ifndef SPH_AESNI_H__
+#define SPH_AESNI_H__
+
+#include "sph_echo.h"
+#include "sph_shavite.h"
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+typedef struct {
+	/* H is the 1024-bit Groestl chaining value, in its byte order (column after column) */
+	void (*groestl_big_compress)(void *H, const unsigned char *buf);
+	void (*groestl_big_final)(void *H);
+	void (*echo_big_compress)(sph_echo_big_context *sc);
+	void (*shavite_big_compress)(sph_shavite_big_context *sc, const void *msg);
+} sph_aesni_kernels;
+
+/**
+ * Returns the AES-NI kernels, or NULL when they were not built, the CPU
+ * lacks AES-NI, or they were switched off with sph_aesni_enable().
+ */
+const sph_aesni_kernels *sph_aesni_get(void);
+
+/**
+ * Non-zero when the AES-NI kernels were built and the CPU supports them
+ * (regardless of sph_aesni_enable()).
+ */
+int sph_aesni_available(void);
+
+/**
+ * Switches the AES-NI kernels on (the default) or off, for benchmarks and
+ * tests comparing them with the portable code. Not meant to be called
+ * while other threads are hashing.
+ */
+void sph_aesni_enable(int enable);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
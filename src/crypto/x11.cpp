@@ -0,0 +1,198 @@
+// Copyright (c) 2017-2018 The Biblepay Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "crypto/x11.h"
+
+#include "crypto/common.h"
+#include "crypto/sph_blake.h"
+#include "crypto/sph_bmw.h"
+#include "crypto/sph_groestl.h"
+#include "crypto/sph_jh.h"
+#include "crypto/sph_keccak.h"
+#include "crypto/sph_skein.h"
+#include "crypto/sph_luffa.h"
+#include "crypto/sph_cubehash.h"
+#include "crypto/sph_shavite.h"
+#include "crypto/sph_simd.h"
+#include "crypto/sph_echo.h"
+
+#include <string.h>
+
+#if defined(ENABLE_AVX2) && (defined(__x86_64__) || defined(__i386__))
+#include <cpuid.h>
+
+namespace x11_avx2 {
+void Blake512_80_4way(const unsigned char* const in[4], unsigned char* const out[4]);
+void Skein512_64_4way(const unsigned char* const in[4], unsigned char* const out[4]);
+void Keccak512_64_4way(const unsigned char* const in[4], unsigned char* const out[4]);
+}
+#define X11_HAVE_AVX2_LANES 1
+#endif
+
+namespace {
+
+//! Lanes per pass; the AVX2 kernels work on four 64-bit words at once
+const unsigned int X11_LANES = 4;
+
+typedef void (*lanes_fn)(const unsigned char* const in[X11_LANES], unsigned char* const out[X11_LANES]);
+
+/** The multi-lane kernels chosen for this CPU, NULL means run the stage lane by lane */
+struct X11Kernels
+{
+    lanes_fn blake;
+    lanes_fn skein;
+    lanes_fn keccak;
+    std::string strName;
+
+    X11Kernels() : blake(NULL), skein(NULL), keccak(NULL), strName("scalar")
+    {
+#ifdef X11_HAVE_AVX2_LANES
+        uint32_t eax, ebx, ecx, edx;
+        if (__get_cpuid(1, &eax, &ebx, &ecx, &edx) && (ecx >> 27) & 1) {
+            // OSXSAVE is set: make sure the OS saves the ymm registers
+            uint32_t xcr0_lo, xcr0_hi;
+            __asm__ ("xgetbv" : "=a"(xcr0_lo), "=d"(xcr0_hi) : "c"(0));
+            if ((xcr0_lo & 6) == 6 && __get_cpuid_max(0, NULL) >= 7) {
+                __cpuid_count(7, 0, eax, ebx, ecx, edx);
+                if ((ebx >> 5) & 1) {
+                    blake = x11_avx2::Blake512_80_4way;
+                    skein = x11_avx2::Skein512_64_4way;
+                    keccak = x11_avx2::Keccak512_64_4way;
+                    strName = "avx2 4-way (blake, skein, keccak)";
+                }
+            }
+        }
+#endif
+    }
+};
+
+const X11Kernels& GetKernels()
+{
+    static const X11Kernels kernels;
+    return kernels;
+}
+
+/** Freshly initialized contexts, copied per lane instead of re-running every init */
+struct X11Contexts
+{
+    sph_blake512_context blake;
+    sph_bmw512_context bmw;
+    sph_groestl512_context groestl;
+    sph_skein512_context skein;
+    sph_jh512_context jh;
+    sph_keccak512_context keccak;
+    sph_luffa512_context luffa;
+    sph_cubehash512_context cubehash;
+    sph_shavite512_context shavite;
+    sph_simd512_context simd;
+    sph_echo512_context echo;
+
+    X11Contexts()
+    {
+        sph_blake512_init(&blake);
+        sph_bmw512_init(&bmw);
+        sph_groestl512_init(&groestl);
+        sph_skein512_init(&skein);
+        sph_jh512_init(&jh);
+        sph_keccak512_init(&keccak);
+        sph_luffa512_init(&luffa);
+        sph_cubehash512_init(&cubehash);
+        sph_shavite512_init(&shavite);
+        sph_simd512_init(&simd);
+        sph_echo512_init(&echo);
+    }
+};
+
+const X11Contexts& GetContexts()
+{
+    static const X11Contexts contexts;
+    return contexts;
+}
+
+#define X11_SCALAR_STAGE(name, in, out) \
+    do { \
+        sph_##name##512_context ctx = GetContexts().name; \
+        sph_##name##512(&ctx, in, 64); \
+        sph_##name##512_close(&ctx, out); \
+    } while (0)
+
+/** Runs X11 on X11_LANES 80 byte inputs, leaving the 64 byte digests in out */
+void HashLanes(const X11Kernels& kernels, unsigned char in[X11_LANES][X11_HEADER_SIZE], unsigned char out[X11_LANES][64])
+{
+    unsigned char buf[X11_LANES][64];
+    const unsigned char* pin[X11_LANES];
+    unsigned char* pbuf[X11_LANES];
+    unsigned char* pout[X11_LANES];
+    const unsigned char* poutc[X11_LANES];
+    for (unsigned int i = 0; i < X11_LANES; i++) {
+        pin[i] = in[i];
+        pbuf[i] = buf[i];
+        pout[i] = out[i];
+        poutc[i] = out[i];
+    }
+
+    // blake512 (80 bytes): in -> out
+    if (kernels.blake) {
+        kernels.blake(pin, pout);
+    } else {
+        for (unsigned int i = 0; i < X11_LANES; i++) {
+            sph_blake512_context ctx = GetContexts().blake;
+            sph_blake512(&ctx, in[i], X11_HEADER_SIZE);
+            sph_blake512_close(&ctx, out[i]);
+        }
+    }
+    for (unsigned int i = 0; i < X11_LANES; i++) {
+        X11_SCALAR_STAGE(bmw, out[i], buf[i]);
+        X11_SCALAR_STAGE(groestl, buf[i], out[i]);
+    }
+    if (kernels.skein) {
+        kernels.skein(poutc, pbuf);
+    } else {
+        for (unsigned int i = 0; i < X11_LANES; i++)
+            X11_SCALAR_STAGE(skein, out[i], buf[i]);
+    }
+    for (unsigned int i = 0; i < X11_LANES; i++)
+        X11_SCALAR_STAGE(jh, buf[i], out[i]);
+    if (kernels.keccak) {
+        kernels.keccak(poutc, pbuf);
+    } else {
+        for (unsigned int i = 0; i < X11_LANES; i++)
+            X11_SCALAR_STAGE(keccak, out[i], buf[i]);
+    }
+    for (unsigned int i = 0; i < X11_LANES; i++) {
+        X11_SCALAR_STAGE(luffa, buf[i], out[i]);
+        X11_SCALAR_STAGE(cubehash, out[i], buf[i]);
+        X11_SCALAR_STAGE(shavite, buf[i], out[i]);
+        X11_SCALAR_STAGE(simd, out[i], buf[i]);
+        X11_SCALAR_STAGE(echo, buf[i], out[i]);
+    }
+}
+
+#undef X11_SCALAR_STAGE
+
+} // namespace
+
+void X11HashHeaders(const unsigned char header[X11_HEADER_SIZE], uint32_t nNonceStart, unsigned int nCount, unsigned char* pout)
+{
+    const X11Kernels& kernels = GetKernels();
+    unsigned char in[X11_LANES][X11_HEADER_SIZE];
+    unsigned char out[X11_LANES][64];
+    for (unsigned int i = 0; i < X11_LANES; i++)
+        memcpy(in[i], header, X11_HEADER_SIZE);
+
+    for (unsigned int nDone = 0; nDone < nCount; nDone += X11_LANES) {
+        unsigned int nLanes = nCount - nDone < X11_LANES ? nCount - nDone : X11_LANES;
+        // Idle lanes of a short pass just repeat the last nonce
+        for (unsigned int i = 0; i < X11_LANES; i++)
+            WriteLE32(in[i] + X11_HEADER_SIZE - 4, nNonceStart + nDone + (i < nLanes ? i : nLanes - 1));
+        HashLanes(kernels, in, out);
+        for (unsigned int i = 0; i < nLanes; i++)
+            memcpy(pout + 32 * (nDone + i), out[i], 32);
+    }
+}
+
+std::string X11BatchImplementation()
+{
+    return GetKernels().strName;
+}
@@ -0,0 +1,31 @@
+// Copyright (c) 2017-2018 The Biblepay Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_CRYPTO_X11_H
+#define BITCOIN_CRYPTO_X11_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string>
+
+/** Size of a serialized block header, the nonce is its last 4 bytes */
+static const size_t X11_HEADER_SIZE = 80;
+/** Largest number of nonces X11HashHeaders hashes per call */
+static const unsigned int X11_MAX_BATCH = 8;
+
+/**
+ * Batched X11 for the miner's nonce loop.
+ *
+ * Hashes nCount copies of an 80 byte block header whose nonces run from
+ * nNonceStart, writing nCount 32 byte hashes (the same bytes HashX11
+ * produces) to pout. Stages with a multi-lane kernel for the running CPU
+ * hash several nonces at once; the others run lane by lane from a
+ * pre-initialized context.
+ */
+void X11HashHeaders(const unsigned char header[X11_HEADER_SIZE], uint32_t nNonceStart, unsigned int nCount, unsigned char* pout);
+
+/** Describes the kernels X11HashHeaders selected at runtime */
+std::string X11BatchImplementation();
+
+#endif // BITCOIN_CRYPTO_X11_H
@@ -0,0 +1,284 @@
+// Copyright (c) 2017-2018 The Biblepay Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+// 4-way AVX2 kernels for the 64-bit stages of X11 (blake512, skein512,
+// keccak512), specialized to the fixed input sizes X11 feeds them: each
+// 256-bit register holds the same state word of four independent hashes.
+
+#ifdef ENABLE_AVX2
+
+#include <stdint.h>
+#include <immintrin.h>
+
+#include "crypto/common.h"
+
+namespace x11_avx2 {
+namespace {
+
+inline __m256i K(uint64_t x) { return _mm256_set1_epi64x((long long)x); }
+inline __m256i Add(__m256i x, __m256i y) { return _mm256_add_epi64(x, y); }
+inline __m256i Xor(__m256i x, __m256i y) { return _mm256_xor_si256(x, y); }
+inline __m256i RotL(__m256i x, int n) { return _mm256_or_si256(_mm256_slli_epi64(x, n), _mm256_srli_epi64(x, 64 - n)); }
+inline __m256i RotR(__m256i x, int n) { return _mm256_or_si256(_mm256_srli_epi64(x, n), _mm256_slli_epi64(x, 64 - n)); }
+inline __m256i RotR32(__m256i x) { return _mm256_shuffle_epi32(x, 0xB1); }
+
+inline __m256i LoadLE(const unsigned char* const in[4], int nOffset)
+{
+    return _mm256_set_epi64x(ReadLE64(in[3] + nOffset), ReadLE64(in[2] + nOffset), ReadLE64(in[1] + nOffset), ReadLE64(in[0] + nOffset));
+}
+
+inline __m256i LoadBE(const unsigned char* const in[4], int nOffset)
+{
+    return _mm256_set_epi64x(ReadBE64(in[3] + nOffset), ReadBE64(in[2] + nOffset), ReadBE64(in[1] + nOffset), ReadBE64(in[0] + nOffset));
+}
+
+inline void StoreLE(unsigned char* const out[4], int nOffset, __m256i x)
+{
+    uint64_t v[4];
+    _mm256_storeu_si256((__m256i*)v, x);
+    for (int i = 0; i < 4; i++)
+        WriteLE64(out[i] + nOffset, v[i]);
+}
+
+inline void StoreBE(unsigned char* const out[4], int nOffset, __m256i x)
+{
+    uint64_t v[4];
+    _mm256_storeu_si256((__m256i*)v, x);
+    for (int i = 0; i < 4; i++)
+        WriteBE64(out[i] + nOffset, v[i]);
+}
+
+/* BLAKE-512 */
+
+const uint64_t BLAKE512_IV[8] = {
+    0x6A09E667F3BCC908ULL, 0xBB67AE8584CAA73BULL, 0x3C6EF372FE94F82BULL, 0xA54FF53A5F1D36F1ULL,
+    0x510E527FADE682D1ULL, 0x9B05688C2B3E6C1FULL, 0x1F83D9ABFB41BD6BULL, 0x5BE0CD19137E2179ULL
+};
+
+const uint64_t BLAKE512_CB[16] = {
+    0x243F6A8885A308D3ULL, 0x13198A2E03707344ULL, 0xA4093822299F31D0ULL, 0x082EFA98EC4E6C89ULL,
+    0x452821E638D01377ULL, 0xBE5466CF34E90C6CULL, 0xC0AC29B7C97C50DDULL, 0x3F84D5B5B5470917ULL,
+    0x9216D5D98979FB1BULL, 0xD1310BA698DFB5ACULL, 0x2FFD72DBD01ADFB7ULL, 0xB8E1AFED6A267E96ULL,
+    0xBA7C9045F12C7F99ULL, 0x24A19947B3916CF7ULL, 0x0801F2E2858EFC16ULL, 0x636920D871574E69ULL
+};
+
+const unsigned char BLAKE_SIGMA[16][16] = {
+    {  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14, 15 },
+    { 14, 10,  4,  8,  9, 15, 13,  6,  1, 12,  0,  2, 11,  7,  5,  3 },
+    { 11,  8, 12,  0,  5,  2, 15, 13, 10, 14,  3,  6,  7,  1,  9,  4 },
+    {  7,  9,  3,  1, 13, 12, 11, 14,  2,  6,  5, 10,  4,  0, 15,  8 },
+    {  9,  0,  5,  7,  2,  4, 10, 15, 14,  1, 11, 12,  6,  8,  3, 13 },
+    {  2, 12,  6, 10,  0, 11,  8,  3,  4, 13,  7,  5, 15, 14,  1,  9 },
+    { 12,  5,  1, 15, 14, 13,  4, 10,  0,  7,  6,  3,  9,  2,  8, 11 },
+    { 13, 11,  7, 14, 12,  1,  3,  9,  5,  0, 15,  4,  8,  6,  2, 10 },
+    {  6, 15, 14,  9, 11,  3,  0,  8, 12,  2, 13,  7,  1,  4, 10,  5 },
+    { 10,  2,  8,  4,  7,  6,  1,  5, 15, 11,  9, 14,  3, 12, 13,  0 },
+    {  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14, 15 },
+    { 14, 10,  4,  8,  9, 15, 13,  6,  1, 12,  0,  2, 11,  7,  5,  3 },
+    { 11,  8, 12,  0,  5,  2, 15, 13, 10, 14,  3,  6,  7,  1,  9,  4 },
+    {  7,  9,  3,  1, 13, 12, 11, 14,  2,  6,  5, 10,  4,  0, 15,  8 },
+    {  9,  0,  5,  7,  2,  4, 10, 15, 14,  1, 11, 12,  6,  8,  3, 13 },
+    {  2, 12,  6, 10,  0, 11,  8,  3,  4, 13,  7,  5, 15, 14,  1,  9 }
+};
+
+inline void BlakeG(const __m256i* M, const unsigned char* s, int i, __m256i& a, __m256i& b, __m256i& c, __m256i& d)
+{
+    a = Add(Add(a, b), Xor(M[s[2 * i]], K(BLAKE512_CB[s[2 * i + 1]])));
+    d = RotR32(Xor(d, a));
+    c = Add(c, d);
+    b = RotR(Xor(b, c), 25);
+    a = Add(Add(a, b), Xor(M[s[2 * i + 1]], K(BLAKE512_CB[s[2 * i]])));
+    d = RotR(Xor(d, a), 16);
+    c = Add(c, d);
+    b = RotR(Xor(b, c), 11);
+}
+
+/* Skein-512 (Threefish-512 in UBI mode) */
+
+const uint64_t SKEIN512_IV[8] = {
+    0x4903ADFF749C51CEULL, 0x0D95DE399746DF03ULL, 0x8FD1934127C79BCEULL, 0x9A255629FF352CB1ULL,
+    0x5DB62599DF6CA7B0ULL, 0xEABE394CA9D5C3F4ULL, 0x991112C71A75B523ULL, 0xAE18A40B660FCC33ULL
+};
+
+inline void SkeinMix(__m256i& x0, __m256i& x1, int rc)
+{
+    x0 = Add(x0, x1);
+    x1 = Xor(RotL(x1, rc), x0);
+}
+
+inline void SkeinMix8(__m256i& w0, __m256i& w1, __m256i& w2, __m256i& w3, __m256i& w4, __m256i& w5, __m256i& w6, __m256i& w7,
+    int rc0, int rc1, int rc2, int rc3)
+{
+    SkeinMix(w0, w1, rc0);
+    SkeinMix(w2, w3, rc1);
+    SkeinMix(w4, w5, rc2);
+    SkeinMix(w6, w7, rc3);
+}
+
+inline void SkeinAddKey(__m256i* p, const __m256i* k, const uint64_t* t, int s)
+{
+    for (int i = 0; i < 8; i++)
+        p[i] = Add(p[i], k[(s + i) % 9]);
+    p[5] = Add(p[5], K(t[s % 3]));
+    p[6] = Add(p[6], K(t[(s + 1) % 3]));
+    p[7] = Add(p[7], K((uint64_t)s));
+}
+
+/** One UBI block: h = E(h, tweak)(m) ^ m */
+void SkeinUBI(__m256i* h, const __m256i* m, uint64_t t0, uint64_t t1)
+{
+    __m256i k[9];
+    __m256i p[8];
+    uint64_t t[3] = { t0, t1, t0 ^ t1 };
+    k[8] = K(0x1BD11BDAA9FC1A22ULL);
+    for (int i = 0; i < 8; i++) {
+        k[i] = h[i];
+        k[8] = Xor(k[8], h[i]);
+        p[i] = m[i];
+    }
+    for (int s = 0; s < 18; s += 2) {
+        SkeinAddKey(p, k, t, s);
+        SkeinMix8(p[0], p[1], p[2], p[3], p[4], p[5], p[6], p[7], 46, 36, 19, 37);
+        SkeinMix8(p[2], p[1], p[4], p[7], p[6], p[5], p[0], p[3], 33, 27, 14, 42);
+        SkeinMix8(p[4], p[1], p[6], p[3], p[0], p[5], p[2], p[7], 17, 49, 36, 39);
+        SkeinMix8(p[6], p[1], p[0], p[7], p[2], p[5], p[4], p[3], 44,  9, 54, 56);
+        SkeinAddKey(p, k, t, s + 1);
+        SkeinMix8(p[0], p[1], p[2], p[3], p[4], p[5], p[6], p[7], 39, 30, 34, 24);
+        SkeinMix8(p[2], p[1], p[4], p[7], p[6], p[5], p[0], p[3], 13, 50, 10, 17);
+        SkeinMix8(p[4], p[1], p[6], p[3], p[0], p[5], p[2], p[7], 25, 29, 39, 43);
+        SkeinMix8(p[6], p[1], p[0], p[7], p[2], p[5], p[4], p[3],  8, 35, 56, 22);
+    }
+    SkeinAddKey(p, k, t, 18);
+    for (int i = 0; i < 8; i++)
+        h[i] = Xor(m[i], p[i]);
+}
+
+/* Keccak-512 (the original Keccak padding, as in sph_keccak) */
+
+const uint64_t KECCAK_RC[24] = {
+    0x0000000000000001ULL, 0x0000000000008082ULL, 0x800000000000808AULL, 0x8000000080008000ULL,
+    0x000000000000808BULL, 0x0000000080000001ULL, 0x8000000080008081ULL, 0x8000000000008009ULL,
+    0x000000000000008AULL, 0x0000000000000088ULL, 0x0000000080008009ULL, 0x000000008000000AULL,
+    0x000000008000808BULL, 0x800000000000008BULL, 0x8000000000008089ULL, 0x8000000000008003ULL,
+    0x8000000000008002ULL, 0x8000000000000080ULL, 0x000000000000800AULL, 0x800000008000000AULL,
+    0x8000000080008081ULL, 0x8000000000008080ULL, 0x0000000080000001ULL, 0x8000000080008008ULL
+};
+
+//! Rotation of lane x + 5 * y
+const int KECCAK_RHO[25] = {
+     0,  1, 62, 28, 27,
+    36, 44,  6, 55, 20,
+     3, 10, 43, 25, 39,
+    41, 45, 15, 21,  8,
+    18,  2, 61, 56, 14
+};
+
+void KeccakF(__m256i* A)
+{
+    __m256i B[25];
+    __m256i C[5];
+    for (int r = 0; r < 24; r++) {
+        for (int x = 0; x < 5; x++)
+            C[x] = Xor(Xor(Xor(A[x], A[x + 5]), Xor(A[x + 10], A[x + 15])), A[x + 20]);
+        for (int x = 0; x < 5; x++) {
+            __m256i D = Xor(C[(x + 4) % 5], RotL(C[(x + 1) % 5], 1));
+            for (int y = 0; y < 25; y += 5)
+                A[x + y] = Xor(A[x + y], D);
+        }
+        // rho and pi: lane (x, y) moves to (y, 2x + 3y)
+        for (int x = 0; x < 5; x++) {
+            for (int y = 0; y < 5; y++) {
+                int i = x + 5 * y;
+                __m256i v = KECCAK_RHO[i] ? RotL(A[i], KECCAK_RHO[i]) : A[i];
+                B[y + 5 * ((2 * x + 3 * y) % 5)] = v;
+            }
+        }
+        // chi
+        for (int y = 0; y < 25; y += 5) {
+            for (int x = 0; x < 5; x++)
+                A[x + y] = Xor(B[x + y], _mm256_andnot_si256(B[(x + 1) % 5 + y], B[(x + 2) % 5 + y]));
+        }
+        A[0] = Xor(A[0], K(KECCAK_RC[r]));
+    }
+}
+
+} // namespace
+
+/** BLAKE-512 of four 80 byte messages (one compression, the padding is fixed) */
+void Blake512_80_4way(const unsigned char* const in[4], unsigned char* const out[4])
+{
+    __m256i M[16];
+    for (int i = 0; i < 10; i++)
+        M[i] = LoadBE(in, 8 * i);
+    M[10] = K(0x8000000000000000ULL);
+    M[11] = K(0);
+    M[12] = K(0);
+    M[13] = K(1);
+    M[14] = K(0);
+    M[15] = K(640);
+
+    __m256i V[16];
+    for (int i = 0; i < 8; i++)
+        V[i] = K(BLAKE512_IV[i]);
+    V[8] = K(BLAKE512_CB[0]);
+    V[9] = K(BLAKE512_CB[1]);
+    V[10] = K(BLAKE512_CB[2]);
+    V[11] = K(BLAKE512_CB[3]);
+    V[12] = K(640 ^ BLAKE512_CB[4]);
+    V[13] = K(640 ^ BLAKE512_CB[5]);
+    V[14] = K(BLAKE512_CB[6]);
+    V[15] = K(BLAKE512_CB[7]);
+
+    for (int r = 0; r < 16; r++) {
+        const unsigned char* s = BLAKE_SIGMA[r];
+        BlakeG(M, s, 0, V[0], V[4], V[8], V[12]);
+        BlakeG(M, s, 1, V[1], V[5], V[9], V[13]);
+        BlakeG(M, s, 2, V[2], V[6], V[10], V[14]);
+        BlakeG(M, s, 3, V[3], V[7], V[11], V[15]);
+        BlakeG(M, s, 4, V[0], V[5], V[10], V[15]);
+        BlakeG(M, s, 5, V[1], V[6], V[11], V[12]);
+        BlakeG(M, s, 6, V[2], V[7], V[8], V[13]);
+        BlakeG(M, s, 7, V[3], V[4], V[9], V[14]);
+    }
+
+    for (int i = 0; i < 8; i++)
+        StoreBE(out, 8 * i, Xor(K(BLAKE512_IV[i]), Xor(V[i], V[i + 8])));
+}
+
+/** Skein-512-512 of four 64 byte messages: one message block and the output block */
+void Skein512_64_4way(const unsigned char* const in[4], unsigned char* const out[4])
+{
+    __m256i h[8];
+    __m256i m[8];
+    for (int i = 0; i < 8; i++) {
+        h[i] = K(SKEIN512_IV[i]);
+        m[i] = LoadLE(in, 8 * i);
+    }
+    // Message block: first | final | type msg, 64 bytes
+    SkeinUBI(h, m, 64, 0xF000000000000000ULL);
+    // Output block: first | final | type out, the 8 byte counter 0
+    for (int i = 0; i < 8; i++)
+        m[i] = K(0);
+    SkeinUBI(h, m, 8, 0xFF00000000000000ULL);
+    for (int i = 0; i < 8; i++)
+        StoreLE(out, 8 * i, h[i]);
+}
+
+/** Keccak-512 of four 64 byte messages (fits in one 72 byte block) */
+void Keccak512_64_4way(const unsigned char* const in[4], unsigned char* const out[4])
+{
+    __m256i A[25];
+    for (int i = 0; i < 8; i++)
+        A[i] = LoadLE(in, 8 * i);
+    A[8] = K(0x8000000000000001ULL);
+    for (int i = 9; i < 25; i++)
+        A[i] = K(0);
+    KeccakF(A);
+    for (int i = 0; i < 8; i++)
+        StoreLE(out, 8 * i, A[i]);
+}
+
+} // namespace x11_avx2
+
+#endif // ENABLE_AVX2
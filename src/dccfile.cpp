@@ -0,0 +1,225 @@
+// Copyright (c) 2017-2018 The Biblepay Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "dccfile.h"
+
+#include "podc.h"
+#include "util.h"
+
+#include <string.h>
+
+#include <boost/algorithm/string/case_conv.hpp>
+
+CDCCLineReader::CDCCLineReader(const std::string& sPath, size_t nBufferSize) : vBuffer(nBufferSize), nBegin(0), nEnd(0), fEOF(false), nLines(0)
+{
+    file = fopen(sPath.c_str(), "rb");
+}
+
+CDCCLineReader::~CDCCLineReader()
+{
+    if (file)
+        fclose(file);
+}
+
+bool CDCCLineReader::Fill()
+{
+    if (fEOF)
+        return false;
+    // Keep the unfinished line, growing the buffer if a single line fills it
+    if (nBegin > 0) {
+        memmove(&vBuffer[0], &vBuffer[nBegin], nEnd - nBegin);
+        nEnd -= nBegin;
+        nBegin = 0;
+    }
+    if (nEnd == vBuffer.size())
+        vBuffer.resize(vBuffer.size() * 2);
+    size_t nRead = fread(&vBuffer[nEnd], 1, vBuffer.size() - nEnd, file);
+    if (nRead == 0) {
+        fEOF = true;
+        return false;
+    }
+    nEnd += nRead;
+    return true;
+}
+
+bool CDCCLineReader::ReadLine(std::string& sLine)
+{
+    if (!file)
+        return false;
+    size_t nScanned = nBegin;
+    while (true) {
+        const char* pBegin = &vBuffer[0] + nBegin;
+        const char* pNewLine = (const char*)memchr(&vBuffer[0] + nScanned, '\n', nEnd - nScanned);
+        if (pNewLine) {
+            sLine.assign(pBegin, pNewLine - pBegin);
+            nBegin = pNewLine - &vBuffer[0] + 1;
+            nLines++;
+            return true;
+        }
+        nScanned = nEnd - nBegin;
+        if (!Fill()) {
+            // Last line without a terminating newline
+            if (nEnd == nBegin)
+                return false;
+            sLine.assign(&vBuffer[0] + nBegin, nEnd - nBegin);
+            nBegin = nEnd;
+            nLines++;
+            return true;
+        }
+    }
+}
+
+void CDCCUserRecord::Reset()
+{
+    fRoot = false;
+    vLines.clear();
+}
+
+void CDCCUserRecord::AddLine(const std::string& sLine)
+{
+    if (sLine == "<user>") {
+        fRoot = true;
+        vLines.clear();
+    } else if (fRoot && sLine.find("</user>") == std::string::npos) {
+        vLines.push_back(sLine);
+    }
+}
+
+std::string CDCCUserRecord::Format(const std::string& sExtra) const
+{
+    if (!fRoot)
+        return "";
+    // FilterBoincData walks its rows backwards, starting with the empty row after the last <ROW>
+    std::string sOut = "<user>\r\n\r\n";
+    for (std::vector<std::string>::const_reverse_iterator it = vLines.rbegin(); it != vLines.rend(); ++it)
+        sOut += *it + "\r\n";
+    sOut += sExtra + "\r\n</user>\r\n";
+    return sOut;
+}
+
+bool FilterDCCUserFile(const std::string& sSourcePath, const std::string& sTargetPath, const DCCResearcherMap& mapResearchers,
+    boost::function<std::string (const std::string& sCPID)> fnExtra)
+{
+    CDCCLineReader reader(sSourcePath);
+    if (!reader.IsOpen())
+        return false;
+    FILE* outFile = fopen(sTargetPath.c_str(), "w");
+    if (!outFile)
+        return error("FilterDCCUserFile: unable to open %s", sTargetPath);
+
+    CDCCUserRecord record;
+    std::string line;
+    while (reader.ReadLine(line)) {
+        record.AddLine(line);
+        if (reader.GetLineCount() % 2000000 == 0)
+            LogPrintf(" Processing DCC Line %f ", (double)reader.GetLineCount());
+        size_t nStart = line.find("<cpid>");
+        if (nStart == std::string::npos)
+            continue;
+        size_t nStop = line.find("</cpid>", nStart + 3);
+        if (nStop == std::string::npos || nStop <= nStart + 6)
+            continue;
+        std::string sCPID = boost::to_upper_copy(line.substr(nStart + 6, nStop - nStart - 6));
+        DCCResearcherMap::const_iterator it = mapResearchers.find(sCPID);
+        if (it == mapResearchers.end()) {
+            record.Reset();
+            continue;
+        }
+        // Every DCC entry naming the CPID takes two more lines (user url and team), as FilterPhase1 always did
+        std::string sExtra = fnExtra(sCPID);
+        for (int i = 0; i < it->second; i++) {
+            for (int z = 0; z < 2; z++) {
+                if (reader.ReadLine(line))
+                    record.AddLine(line);
+            }
+            std::string sData = record.Format(sExtra);
+            fwrite(sData.data(), 1, sData.size(), outFile);
+            record.Reset();
+        }
+    }
+    fclose(outFile);
+    return true;
+}
+
+bool FilterDCCTeamFile(const std::string& sSourcePath, const std::string& sTargetPath, double dTargetTeam)
+{
+    CDCCLineReader reader(sSourcePath);
+    if (!reader.IsOpen())
+        return false;
+    FILE* outFile = fopen(sTargetPath.c_str(), "w");
+    if (!outFile)
+        return error("FilterDCCTeamFile: unable to open %s", sTargetPath);
+
+    std::string sBuffer;
+    std::string line;
+    while (reader.ReadLine(line)) {
+        // Only the tail can complete a "</user>" that was not there before
+        size_t nFrom = sBuffer.size() > 6 ? sBuffer.size() - 6 : 0;
+        sBuffer += line;
+        if (sBuffer.find("</user>", nFrom) == std::string::npos)
+            continue;
+        double dTeamID = cdbl(ExtractXML(sBuffer, "<teamid>", "</teamid>"), 0);
+        if (dTargetTeam == dTeamID) {
+            std::string sCpid = ExtractXML(sBuffer, "<cpid>", "</cpid>");
+            double dRac = cdbl(ExtractXML(sBuffer, "<expavg_credit>", "</expavg_credit>"), 0);
+            double dTotalRAC = cdbl(ExtractXML(sBuffer, "<total_credit>", "</total_credit>"), 0);
+            double dCreated = cdbl(ExtractXML(sBuffer, "<create_time>", "</create_time>"), 0);
+            std::string sName = ExtractXML(sBuffer, "<name>", "</name>");
+            std::string sRow = sCpid + "," + RoundToString(dTeamID, 0) + "," + RoundToString(dRac, 0) + "," + RoundToString(dTotalRAC, 0) + ","
+                + RoundToString(dCreated, 0) + "," + sName + "\r\n";
+            fwrite(sRow.data(), 1, sRow.size(), outFile);
+        }
+        sBuffer.clear();
+    }
+    fclose(outFile);
+    return true;
+}
+
+const std::vector<unsigned int> CDCCTable::vNoRows;
+
+void CDCCTable::Clear()
+{
+    vCPID.clear();
+    vTeam.clear();
+    vUTXOWeight.clear();
+    vTaskWeight.clear();
+    vUnbanked.clear();
+    vCredit.clear();
+    vCreditTotal.clear();
+    mapRows.clear();
+}
+
+bool CDCCTable::Load(const std::string& sPath)
+{
+    Clear();
+    CDCCLineReader reader(sPath);
+    if (!reader.IsOpen())
+        return false;
+
+    std::string sUser;
+    std::string line;
+    while (reader.ReadLine(line)) {
+        sUser += line;
+        if (line.find("</user>") == std::string::npos)
+            continue;
+        std::string sCPID = boost::to_upper_copy(ExtractXML(sUser, "<cpid>", "</cpid>"));
+        std::string sCredit = ExtractXML(sUser, "<expavg_credit>", "</expavg_credit>");
+        mapRows[sCPID].push_back(vCPID.size());
+        vCPID.push_back(sCPID);
+        vTeam.push_back(cdbl(ExtractXML(sUser, "<teamid>", "</teamid>"), 0));
+        vUTXOWeight.push_back(cdbl(ExtractXML(sUser, "<utxoweight>", "</utxoweight>"), 0));
+        vTaskWeight.push_back(cdbl(ExtractXML(sUser, "<taskweight>", "</taskweight>"), 0));
+        vUnbanked.push_back(cdbl(ExtractXML(sUser, "<unbanked>", "</unbanked>"), 0));
+        vCredit.push_back(cdbl(sCredit, 4));
+        vCreditTotal.push_back(cdbl(sCredit, 2));
+        sUser.clear();
+    }
+    return true;
+}
+
+const std::vector<unsigned int>& CDCCTable::GetRows(const std::string& sCPID) const
+{
+    boost::unordered_map<std::string, std::vector<unsigned int> >::const_iterator it = mapRows.find(sCPID);
+    return it == mapRows.end() ? vNoRows : it->second;
+}
@@ -0,0 +1,117 @@
+// Copyright (c) 2017-2018 The Biblepay Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_DCCFILE_H
+#define BITCOIN_DCCFILE_H
+
+#include <string>
+#include <vector>
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <boost/function.hpp>
+#include <boost/unordered_map.hpp>
+
+/**
+ * Buffered line reader for the BOINC exports (user, user2), which run to
+ * hundreds of MB. Lines come back as std::getline returns them: without the
+ * '\n', but keeping a trailing '\r'.
+ */
+class CDCCLineReader
+{
+private:
+    FILE* file;
+    std::vector<char> vBuffer;
+    size_t nBegin;
+    size_t nEnd;
+    bool fEOF;
+    int64_t nLines;
+
+    bool Fill();
+
+    CDCCLineReader(const CDCCLineReader&);
+    void operator=(const CDCCLineReader&);
+
+public:
+    explicit CDCCLineReader(const std::string& sPath, size_t nBufferSize = 1 << 20);
+    ~CDCCLineReader();
+
+    bool IsOpen() const { return file != NULL; }
+    bool ReadLine(std::string& sLine);
+    int64_t GetLineCount() const { return nLines; }
+};
+
+/**
+ * The part of a BOINC <user> record that FilterBoincData(sBuffer, "<user>",
+ * "</user>", sExtra) keeps: the lines after the last "<user>" line, minus the
+ * ones holding "</user>". Lines before a "<user>" line are never kept, so the
+ * memory used is bounded by the longest record.
+ */
+class CDCCUserRecord
+{
+private:
+    bool fRoot;
+    std::vector<std::string> vLines;
+
+public:
+    CDCCUserRecord() : fRoot(false) {}
+
+    void Reset();
+    void AddLine(const std::string& sLine);
+    /** The record text exactly as FilterBoincData formats it (empty without a "<user>" line) */
+    std::string Format(const std::string& sExtra) const;
+};
+
+/** Upper case CPID -> number of DCC entries naming it */
+typedef boost::unordered_map<std::string, int> DCCResearcherMap;
+
+/**
+ * Streams a BOINC user export into sTargetPath keeping the records of the
+ * researchers in mapResearchers (FilterPhase1). A kept record takes the two
+ * lines after its <cpid> line as well, gets the text fnExtra returns for its
+ * CPID appended, and is written out as soon as it is complete.
+ */
+bool FilterDCCUserFile(const std::string& sSourcePath, const std::string& sTargetPath, const DCCResearcherMap& mapResearchers,
+    boost::function<std::string (const std::string& sCPID)> fnExtra);
+
+/**
+ * Streams a BOINC user export into sTargetPath as one
+ * "cpid,teamid,expavg_credit,total_credit,create_time,name" row per member
+ * of team dTargetTeam (FilterPhase2).
+ */
+bool FilterDCCTeamFile(const std::string& sSourcePath, const std::string& sTargetPath, double dTargetTeam);
+
+/**
+ * A filtered DCC file (FilterPhase1 output) loaded into columns, one row per
+ * <user> record in file order, with an index from upper case CPID to its rows.
+ * The magnitude pass queries it instead of re-reading the file per researcher.
+ */
+class CDCCTable
+{
+public:
+    std::vector<std::string> vCPID;
+    std::vector<double> vTeam;
+    std::vector<double> vUTXOWeight;
+    std::vector<double> vTaskWeight;
+    std::vector<double> vUnbanked;
+    //! expavg_credit rounded to 4 places (per researcher magnitude) and to 2 places (project totals)
+    std::vector<double> vCredit;
+    std::vector<double> vCreditTotal;
+
+private:
+    boost::unordered_map<std::string, std::vector<unsigned int> > mapRows;
+    static const std::vector<unsigned int> vNoRows;
+
+public:
+    /** Replaces the contents with the records of sPath; false (and empty) if it cannot be read */
+    bool Load(const std::string& sPath);
+    void Clear();
+
+    size_t size() const { return vCPID.size(); }
+    /** Rows of the given upper case CPID, in file order */
+    const std::vector<unsigned int>& GetRows(const std::string& sCPID) const;
+};
+
+#endif // BITCOIN_DCCFILE_H
@@ -0,0 +1,302 @@
+// Copyright (c) 2017-2018 The Biblepay Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#if defined(HAVE_CONFIG_H)
+#include "config/biblepay-config.h"
+#endif
+
+#include "httpsclient.h"
+
+#include "compat.h"
+#include "util.h"
+#include "utilstrencodings.h"
+#include "utiltime.h"
+
+#include <boost/algorithm/string/case_conv.hpp>
+
+#include <openssl/err.h>
+
+namespace {
+
+/** Reads what the connection has next into sData; false on EOF, error, timeout or past nDeadline */
+bool ReadMore(BIO* bio, std::string& sData, int64_t nDeadline)
+{
+    if (GetTimeMillis() > nDeadline)
+        return false;
+    char buf[16384];
+    int nRead = BIO_read(bio, buf, sizeof(buf));
+    if (nRead <= 0)
+        return false;
+    sData.append(buf, nRead);
+    return true;
+}
+
+/** Value of a response header, headers lower case and starting with "\r\n"; "" if absent */
+std::string GetHeader(const std::string& sHeaders, const std::string& sName)
+{
+    size_t nPos = sHeaders.find("\r\n" + sName + ":");
+    if (nPos == std::string::npos)
+        return "";
+    nPos += sName.size() + 3;
+    size_t nEnd = sHeaders.find("\r\n", nPos);
+    std::string sValue = sHeaders.substr(nPos, nEnd == std::string::npos ? std::string::npos : nEnd - nPos);
+    size_t nFirst = sValue.find_first_not_of(" \t");
+    size_t nLast = sValue.find_last_not_of(" \t");
+    return nFirst == std::string::npos ? "" : sValue.substr(nFirst, nLast - nFirst + 1);
+}
+
+/**
+ * Reads one response. Returns true when it ended where the connection can be
+ * used for the next request.
+ */
+bool ReadResponse(BIO* bio, int64_t nDeadline, int nMaxSize, const HTTPSCompletionCheck& fnComplete, std::string& sData)
+{
+    size_t nHeaderEnd;
+    while ((nHeaderEnd = sData.find("\r\n\r\n")) == std::string::npos) {
+        if ((int)sData.size() >= nMaxSize || !ReadMore(bio, sData, nDeadline))
+            return false;
+    }
+    size_t nBodyStart = nHeaderEnd + 4;
+    std::string sHeaders = boost::to_lower_copy("\r\n" + sData.substr(0, nHeaderEnd));
+    bool fKeepAlive = GetHeader(sHeaders, "connection") != "close" && sHeaders.compare(2, 8, "http/1.0") != 0;
+
+    if (GetHeader(sHeaders, "transfer-encoding").find("chunked") != std::string::npos) {
+        std::string sRaw = sData.substr(nBodyStart);
+        sData.resize(nBodyStart);
+        while (true) {
+            size_t nLineEnd;
+            while ((nLineEnd = sRaw.find("\r\n")) == std::string::npos) {
+                if (!ReadMore(bio, sRaw, nDeadline))
+                    return false;
+            }
+            std::string sSize = sRaw.substr(0, nLineEnd);
+            size_t nExtension = sSize.find(';');
+            if (nExtension != std::string::npos)
+                sSize.resize(nExtension);
+            if (sSize.empty() || !IsHex(sSize.size() % 2 ? "0" + sSize : sSize) || sSize.size() > 8)
+                return false;
+            uint64_t nChunk = strtoull(sSize.c_str(), NULL, 16);
+            if (sData.size() + nChunk > (uint64_t)nMaxSize)
+                return false;
+            if (nChunk == 0) {
+                // Trailers, if any, end with an empty line
+                while (sRaw.find("\r\n\r\n", nLineEnd) == std::string::npos) {
+                    if (!ReadMore(bio, sRaw, nDeadline))
+                        return false;
+                }
+                return fKeepAlive;
+            }
+            while (sRaw.size() < nLineEnd + 2 + nChunk + 2) {
+                if (!ReadMore(bio, sRaw, nDeadline))
+                    return false;
+            }
+            sData.append(sRaw, nLineEnd + 2, nChunk);
+            sRaw.erase(0, nLineEnd + 2 + nChunk + 2);
+        }
+    }
+
+    std::string sLength = GetHeader(sHeaders, "content-length");
+    if (!sLength.empty()) {
+        size_t nEnd = nBodyStart + (size_t)atoi64(sLength);
+        while (sData.size() < nEnd) {
+            if (!ReadMore(bio, sData, nDeadline))
+                return false;
+        }
+        // More than announced leaves the connection out of step
+        return fKeepAlive && sData.size() == nEnd;
+    }
+
+    // Delimited by the server closing the connection
+    while ((int)sData.size() < nMaxSize && !(fnComplete && fnComplete(sData))) {
+        if (!ReadMore(bio, sData, nDeadline))
+            break;
+    }
+    return false;
+}
+
+void SetTimeouts(BIO* bio, int nTimeoutSecs)
+{
+    int fd = -1;
+    if (BIO_get_fd(bio, &fd) < 0 || fd < 0)
+        return;
+#ifdef WIN32
+    DWORD nTimeout = nTimeoutSecs * 1000;
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, (const char*)&nTimeout, sizeof(nTimeout));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, (const char*)&nTimeout, sizeof(nTimeout));
+#else
+    struct timeval timeout;
+    timeout.tv_sec = nTimeoutSecs;
+    timeout.tv_usec = 0;
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, (void*)&timeout, sizeof(timeout));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, (void*)&timeout, sizeof(timeout));
+#endif
+}
+
+} // namespace
+
+CHTTPSClient::CHTTPSClient() : nConnects(0), nResumed(0)
+{
+    SSL_library_init();
+    SSL_load_error_strings();
+    ctx = SSL_CTX_new(SSLv23_client_method());
+    if (ctx)
+        SSL_CTX_set_mode(ctx, SSL_MODE_AUTO_RETRY);
+}
+
+CHTTPSClient::~CHTTPSClient()
+{
+    Clear();
+    if (ctx)
+        SSL_CTX_free(ctx);
+}
+
+BIO* CHTTPSClient::Connect(const std::string& sHost, int nPort, std::string& sError)
+{
+    std::string sHostPort = sHost + ":" + itostr(nPort);
+    if (!ctx) {
+        sError = "CTX_IS_NULL";
+        return NULL;
+    }
+    BIO* bio = BIO_new_ssl_connect(ctx);
+    if (!bio) {
+        sError = "CTX_IS_NULL";
+        return NULL;
+    }
+    SSL* ssl = NULL;
+    BIO_get_ssl(bio, &ssl);
+    SSL_set_tlsext_host_name(ssl, sHost.c_str());
+    BIO_set_conn_hostname(bio, sHostPort.c_str());
+    {
+        LOCK(cs_https);
+        std::map<std::string, SSL_SESSION*>::const_iterator it = mapSessions.find(sHostPort);
+        if (it != mapSessions.end())
+            SSL_set_session(ssl, it->second);
+    }
+    if (BIO_do_connect(bio) <= 0) {
+        BIO_free_all(bio);
+        sError = "Failed connection to " + sHostPort;
+        return NULL;
+    }
+    LOCK(cs_https);
+    nConnects++;
+    if (SSL_session_reused(ssl))
+        nResumed++;
+    return bio;
+}
+
+BIO* CHTTPSClient::Acquire(const std::string& sHostPort)
+{
+    LOCK(cs_https);
+    std::map<std::string, std::vector<CIdleConnection> >::iterator it = mapIdle.find(sHostPort);
+    if (it == mapIdle.end())
+        return NULL;
+    BIO* bio = NULL;
+    int64_t nNow = GetTime();
+    while (!it->second.empty() && !bio) {
+        CIdleConnection conn = it->second.back();
+        it->second.pop_back();
+        if (nNow - conn.nLastUsed < IDLE_TIMEOUT_SECONDS)
+            bio = conn.bio;
+        else
+            BIO_free_all(conn.bio);
+    }
+    if (it->second.empty())
+        mapIdle.erase(it);
+    return bio;
+}
+
+void CHTTPSClient::Release(const std::string& sHostPort, BIO* bio, bool fKeepAlive)
+{
+    SSL* ssl = NULL;
+    BIO_get_ssl(bio, &ssl);
+    // TLS 1.3 tickets arrive with the response, so the session is taken now rather than after the handshake
+    SSL_SESSION* session = ssl ? SSL_get1_session(ssl) : NULL;
+#if OPENSSL_VERSION_NUMBER >= 0x10101000L
+    if (session && !SSL_SESSION_is_resumable(session)) {
+        SSL_SESSION_free(session);
+        session = NULL;
+    }
+#endif
+    LOCK(cs_https);
+    if (session) {
+        std::map<std::string, SSL_SESSION*>::iterator it = mapSessions.find(sHostPort);
+        if (it != mapSessions.end())
+            SSL_SESSION_free(it->second);
+        mapSessions[sHostPort] = session;
+    }
+    std::vector<CIdleConnection>& vIdle = mapIdle[sHostPort];
+    if (fKeepAlive && vIdle.size() < MAX_IDLE_PER_HOST) {
+        CIdleConnection conn;
+        conn.bio = bio;
+        conn.nLastUsed = GetTime();
+        vIdle.push_back(conn);
+    } else {
+        BIO_free_all(bio);
+    }
+    if (vIdle.empty())
+        mapIdle.erase(sHostPort);
+}
+
+std::string CHTTPSClient::Request(const std::string& sHost, int nPort, const std::string& sRequest, int nTimeoutSecs, int nMaxSize,
+    const HTTPSCompletionCheck& fnComplete, std::string& sError)
+{
+    std::string sHostPort = sHost + ":" + itostr(nPort);
+    int64_t nDeadline = GetTimeMillis() + nTimeoutSecs * 1000;
+    while (true) {
+        BIO* bio = Acquire(sHostPort);
+        bool fPooled = bio != NULL;
+        if (!bio)
+            bio = Connect(sHost, nPort, sError);
+        if (!bio)
+            return "";
+        SetTimeouts(bio, nTimeoutSecs);
+
+        std::string sData;
+        bool fSent = BIO_write(bio, sRequest.data(), sRequest.size()) == (int)sRequest.size();
+        bool fKeepAlive = fSent && ReadResponse(bio, nDeadline, nMaxSize, fnComplete, sData);
+        if (fPooled && sData.empty()) {
+            // The server closed the idle connection; use a new one
+            BIO_free_all(bio);
+            continue;
+        }
+        if (!fSent) {
+            BIO_free_all(bio);
+            sError = "FAILED_HTTPS_POST";
+            return "";
+        }
+        Release(sHostPort, bio, fKeepAlive);
+        return sData;
+    }
+}
+
+void CHTTPSClient::Clear()
+{
+    LOCK(cs_https);
+    for (std::map<std::string, std::vector<CIdleConnection> >::iterator it = mapIdle.begin(); it != mapIdle.end(); ++it)
+        for (unsigned int i = 0; i < it->second.size(); i++)
+            BIO_free_all(it->second[i].bio);
+    mapIdle.clear();
+    for (std::map<std::string, SSL_SESSION*>::iterator it = mapSessions.begin(); it != mapSessions.end(); ++it)
+        SSL_SESSION_free(it->second);
+    mapSessions.clear();
+}
+
+uint64_t CHTTPSClient::GetConnectCount()
+{
+    LOCK(cs_https);
+    return nConnects;
+}
+
+uint64_t CHTTPSClient::GetResumedCount()
+{
+    LOCK(cs_https);
+    return nResumed;
+}
+
+CHTTPSClient& GetHTTPSClient()
+{
+    // Constructed on first use, after OpenSSL registered its own exit handler, so it is destroyed before that runs
+    static CHTTPSClient client;
+    return client;
+}
@@ -0,0 +1,85 @@
+// Copyright (c) 2017-2018 The Biblepay Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_HTTPSCLIENT_H
+#define BITCOIN_HTTPSCLIENT_H
+
+#include "sync.h"
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <stdint.h>
+
+#include <boost/function.hpp>
+
+#include <openssl/ssl.h>
+
+/** Tells whether a response that is only delimited by the server closing the connection is complete */
+typedef boost::function<bool (const std::string& sData)> HTTPSCompletionCheck;
+
+/**
+ * Keep-alive HTTPS client shared by the pool miner, PODC and IPFS calls.
+ *
+ * The TLS context is set up once per process. Connections are kept per
+ * host:port after a response that is delimited by Content-Length or chunked
+ * encoding and not followed by "Connection: close", and the TLS session of a
+ * host is offered again when a new connection to it is opened, so repeated
+ * requests skip the TCP and TLS handshakes or at least the full handshake.
+ * A request on a pooled connection the server has meanwhile closed is sent
+ * again on a fresh one.
+ */
+class CHTTPSClient
+{
+private:
+    static const unsigned int MAX_IDLE_PER_HOST = 4;
+    static const int64_t IDLE_TIMEOUT_SECONDS = 60;
+
+    struct CIdleConnection
+    {
+        BIO* bio;
+        int64_t nLastUsed;
+    };
+
+    CCriticalSection cs_https;
+    SSL_CTX* ctx;
+    std::map<std::string, std::vector<CIdleConnection> > mapIdle;
+    std::map<std::string, SSL_SESSION*> mapSessions;
+    uint64_t nConnects;
+    uint64_t nResumed;
+
+    BIO* Connect(const std::string& sHost, int nPort, std::string& sError);
+    BIO* Acquire(const std::string& sHostPort);
+    void Release(const std::string& sHostPort, BIO* bio, bool fKeepAlive);
+
+    CHTTPSClient(const CHTTPSClient&);
+    void operator=(const CHTTPSClient&);
+
+public:
+    CHTTPSClient();
+    ~CHTTPSClient();
+
+    /**
+     * Sends sRequest (a complete HTTP/1.1 request) to sHost:nPort and returns the
+     * response headers and body, with chunked bodies decoded. A Content-Length
+     * body is read in full; a chunked one up to nMaxSize; otherwise the response
+     * is read until the server closes, fnComplete accepts it, it reaches nMaxSize
+     * or nTimeoutSecs pass. On failure sError is set and "" returned.
+     */
+    std::string Request(const std::string& sHost, int nPort, const std::string& sRequest, int nTimeoutSecs, int nMaxSize,
+        const HTTPSCompletionCheck& fnComplete, std::string& sError);
+
+    /** Close the pooled connections and forget the TLS sessions */
+    void Clear();
+
+    /** Connections opened so far, and how many of them resumed a TLS session */
+    uint64_t GetConnectCount();
+    uint64_t GetResumedCount();
+};
+
+/** The process wide client */
+CHTTPSClient& GetHTTPSClient();
+
+#endif // BITCOIN_HTTPSCLIENT_H
@@ -0,0 +1,398 @@
+// Copyright (c) 2017-2018 The Biblepay Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#if defined(HAVE_CONFIG_H)
+#include "config/biblepay-config.h"
+#endif
+
+#include "ipfsclient.h"
+
+#include "compat.h"
+#include "crypto/sha256.h"
+#include "netbase.h"
+#include "sync.h"
+#include "util.h"
+#include "utilstrencodings.h"
+#include "utiltime.h"
+
+#include <boost/algorithm/string/case_conv.hpp>
+#include <boost/bind.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/thread.hpp>
+
+#include <stdio.h>
+
+namespace {
+
+static const size_t RECEIVE_BUFFER_SIZE = 65536;
+static const size_t MAX_HEADER_SIZE = 65536;
+
+/** Waits for data until nDeadline; returns the bytes read, 0 when the server closed, -1 on error or timeout */
+int ReceiveSome(SOCKET hSocket, char* pch, size_t nMax, int64_t nDeadline)
+{
+    while (true) {
+        int64_t nWait = nDeadline - GetTimeMillis();
+        if (nWait <= 0)
+            return -1;
+        struct timeval timeout = MillisToTimeval(std::min(nWait, (int64_t)1000));
+        fd_set fdset;
+        FD_ZERO(&fdset);
+        FD_SET(hSocket, &fdset);
+        int nRet = select(hSocket + 1, &fdset, NULL, NULL, &timeout);
+        if (nRet == SOCKET_ERROR)
+            return -1;
+        if (nRet == 0)
+            continue;
+        int nRead = recv(hSocket, pch, nMax, 0);
+        if (nRead >= 0)
+            return nRead;
+        int nErr = WSAGetLastError();
+        if (nErr != WSAEWOULDBLOCK && nErr != WSAEINTR && nErr != WSAEINPROGRESS)
+            return -1;
+    }
+}
+
+bool SendAll(SOCKET hSocket, const std::string& sData, int64_t nDeadline)
+{
+    size_t nSent = 0;
+    while (nSent < sData.size()) {
+        int nRet = send(hSocket, sData.data() + nSent, sData.size() - nSent, MSG_NOSIGNAL);
+        if (nRet > 0) {
+            nSent += nRet;
+            continue;
+        }
+        int nErr = WSAGetLastError();
+        if (nRet == 0 || (nErr != WSAEWOULDBLOCK && nErr != WSAEINTR && nErr != WSAEINPROGRESS) || GetTimeMillis() > nDeadline)
+            return false;
+        struct timeval timeout = MillisToTimeval(100);
+        fd_set fdset;
+        FD_ZERO(&fdset);
+        FD_SET(hSocket, &fdset);
+        select(hSocket + 1, NULL, &fdset, NULL, &timeout);
+    }
+    return true;
+}
+
+/** Value of a response header, headers lower case and starting with "\r\n"; "" if absent */
+std::string GetHeader(const std::string& sHeaders, const std::string& sName)
+{
+    size_t nPos = sHeaders.find("\r\n" + sName + ":");
+    if (nPos == std::string::npos)
+        return "";
+    nPos += sName.size() + 3;
+    size_t nEnd = sHeaders.find("\r\n", nPos);
+    std::string sValue = sHeaders.substr(nPos, nEnd == std::string::npos ? std::string::npos : nEnd - nPos);
+    size_t nFirst = sValue.find_first_not_of(" \t");
+    size_t nLast = sValue.find_last_not_of(" \t");
+    return nFirst == std::string::npos ? "" : sValue.substr(nFirst, nLast - nFirst + 1);
+}
+
+/** Decodes a response body as it arrives and passes it on, skipping what was not asked for */
+class CBodyDecoder
+{
+public:
+    enum State { CHUNK_SIZE, CHUNK_DATA, CHUNK_END, TRAILER, DATA, DONE, FAILED };
+
+    State state;
+    bool fSinkFailed;
+    bool fLength;
+    uint64_t nRemaining;
+    uint64_t nSkip;
+    std::string sLine;
+    const IPFSBodySink& sink;
+    CSHA256* pHasher;
+
+    CBodyDecoder(const IPFSBodySink& sinkIn, CSHA256* pHasherIn) : state(DATA), fSinkFailed(false), fLength(false), nRemaining(0), nSkip(0), sink(sinkIn), pHasher(pHasherIn) {}
+
+    bool Deliver(const char* pch, size_t nLen)
+    {
+        size_t nSkipNow = std::min((uint64_t)nLen, nSkip);
+        nSkip -= nSkipNow;
+        pch += nSkipNow;
+        nLen -= nSkipNow;
+        if (nLen == 0)
+            return true;
+        if (pHasher)
+            pHasher->Write((const unsigned char*)pch, nLen);
+        if (sink && !sink(pch, nLen)) {
+            fSinkFailed = true;
+            state = FAILED;
+            return false;
+        }
+        return true;
+    }
+
+    /** Takes the next received bytes; false once done or failed */
+    bool Feed(const char* pch, size_t nLen)
+    {
+        while (nLen > 0 && state != DONE && state != FAILED) {
+            if (state == DATA) {
+                size_t nTake = fLength ? std::min((uint64_t)nLen, nRemaining) : nLen;
+                if (!Deliver(pch, nTake))
+                    return false;
+                pch += nTake;
+                nLen -= nTake;
+                if (fLength && (nRemaining -= nTake) == 0)
+                    state = DONE;
+            } else if (state == CHUNK_DATA) {
+                size_t nTake = std::min((uint64_t)nLen, nRemaining);
+                if (!Deliver(pch, nTake))
+                    return false;
+                pch += nTake;
+                nLen -= nTake;
+                if ((nRemaining -= nTake) == 0)
+                    state = CHUNK_END;
+            } else {
+                // Line based: chunk size, the CRLF after the data, trailers
+                const char* pEnd = (const char*)memchr(pch, '\n', nLen);
+                size_t nTake = pEnd ? pEnd - pch + 1 : nLen;
+                sLine.append(pch, nTake);
+                pch += nTake;
+                nLen -= nTake;
+                if (sLine.size() > 1024) {
+                    state = FAILED;
+                    return false;
+                }
+                if (!pEnd)
+                    continue;
+                std::string sValue = sLine.substr(0, sLine.find_first_of(";\r\n"));
+                sLine.clear();
+                if (state == CHUNK_END) {
+                    state = sValue.empty() ? CHUNK_SIZE : FAILED;
+                } else if (state == TRAILER) {
+                    if (sValue.empty())
+                        state = DONE;
+                } else {
+                    if (sValue.empty() || sValue.size() > 15 || sValue.find_first_not_of("0123456789abcdefABCDEF") != std::string::npos) {
+                        state = FAILED;
+                        return false;
+                    }
+                    nRemaining = strtoull(sValue.c_str(), NULL, 16);
+                    state = nRemaining ? CHUNK_DATA : TRAILER;
+                }
+            }
+        }
+        return state != DONE && state != FAILED;
+    }
+
+    /** Whether the body is complete, given the server has closed the connection (if it has) */
+    bool IsComplete(bool fClosed) const
+    {
+        if (state == FAILED)
+            return false;
+        return state == DONE || (fClosed && state == DATA && !fLength);
+    }
+};
+
+void GetAllThread(const std::vector<CIPFSRequest>* pvRequests, std::vector<int>* pvStatus, size_t* pnNext, CCriticalSection* pcs)
+{
+    while (true) {
+        size_t i;
+        {
+            LOCK(*pcs);
+            if (*pnNext >= pvRequests->size())
+                return;
+            i = (*pnNext)++;
+        }
+        (*pvStatus)[i] = IPFSGet((*pvRequests)[i]);
+    }
+}
+
+bool AppendToString(std::string* psData, size_t nMaxSize, const char* pch, size_t nLen)
+{
+    if (psData->size() + nLen > nMaxSize)
+        return false;
+    psData->append(pch, nLen);
+    return true;
+}
+
+/** Writes a download to its file, hashing the whole file (including a resumed part) on the way */
+class CFileSink
+{
+public:
+    FILE* file;
+    CSHA256* pHasher;
+
+    bool Write(const char* pch, size_t nLen)
+    {
+        if (pHasher)
+            pHasher->Write((const unsigned char*)pch, nLen);
+        return fwrite(pch, 1, nLen, file) == nLen;
+    }
+};
+
+} // namespace
+
+bool ParseHTTPURL(const std::string& sURL, std::string& sHostRet, int& nPortRet, std::string& sPathRet)
+{
+    std::string sRest = sURL;
+    if (sRest.compare(0, 7, "http://") == 0)
+        sRest = sRest.substr(7);
+    else if (sRest.find("://") != std::string::npos)
+        return false;
+    size_t nSlash = sRest.find('/');
+    std::string sHostPort = sRest.substr(0, nSlash);
+    sPathRet = nSlash == std::string::npos ? "/" : sRest.substr(nSlash);
+    size_t nFragment = sPathRet.find('#');
+    if (nFragment != std::string::npos)
+        sPathRet.resize(nFragment);
+    nPortRet = 80;
+    SplitHostPort(sHostPort, nPortRet, sHostRet);
+    return !sHostRet.empty() && nPortRet > 0 && nPortRet < 65536;
+}
+
+int IPFSGet(const CIPFSRequest& req)
+{
+    std::string sHost;
+    std::string sPath;
+    int nPort;
+    if (!ParseHTTPURL(req.sURL, sHost, nPort, sPath))
+        return IPFS_BAD_ADDRESS;
+    CService addrConnect(sHost, nPort, true);
+    if (!addrConnect.IsValid())
+        return IPFS_BAD_ADDRESS;
+    int64_t nDeadline = GetTimeMillis() + (int64_t)(req.dTimeoutSecs * 1000);
+    SOCKET hSocket = INVALID_SOCKET;
+    bool fProxyConnectionFailed = false;
+    if (!ConnectSocket(addrConnect, hSocket, req.dTimeoutSecs * 1000, &fProxyConnectionFailed))
+        return IPFS_CONNECT_FAILED;
+
+    std::string sRequest = "GET " + sPath + " HTTP/1.1\r\nHost: " + sHost + "\r\nConnection: close\r\n";
+    if (req.nOffset > 0)
+        sRequest += strprintf("Range: bytes=%d-\r\n", req.nOffset);
+    sRequest += "\r\n";
+    if (!SendAll(hSocket, sRequest, nDeadline)) {
+        CloseSocket(hSocket);
+        return IPFS_CONNECT_FAILED;
+    }
+
+    CSHA256 hasher;
+    CBodyDecoder decoder(req.sink, req.sExpectedSHA256.empty() ? NULL : &hasher);
+    std::vector<char> vBuffer(RECEIVE_BUFFER_SIZE);
+    std::string sHeader;
+    bool fHeader = false;
+    bool fClosed = false;
+    int nStatus = IPFS_INCOMPLETE;
+    while (true) {
+        int nRead = ReceiveSome(hSocket, &vBuffer[0], vBuffer.size(), nDeadline);
+        if (nRead <= 0) {
+            fClosed = nRead == 0;
+            break;
+        }
+        if (fHeader) {
+            if (!decoder.Feed(&vBuffer[0], nRead))
+                break;
+            continue;
+        }
+        sHeader.append(&vBuffer[0], nRead);
+        size_t nHeaderEnd = sHeader.find("\r\n\r\n");
+        if (nHeaderEnd == std::string::npos) {
+            if (sHeader.size() > MAX_HEADER_SIZE)
+                break;
+            continue;
+        }
+        fHeader = true;
+        std::string sHeaders = boost::to_lower_copy("\r\n" + sHeader.substr(0, nHeaderEnd));
+        int nCode = sHeader.size() > 12 ? atoi(sHeader.substr(9, 3)) : 0;
+        if (nCode == 416 && req.nOffset > 0) {
+            // Nothing beyond the offset: the partial download was already complete
+            nStatus = IPFS_OK;
+            break;
+        }
+        if (nCode != 200 && nCode != 206) {
+            nStatus = IPFS_HTTP_ERROR;
+            break;
+        }
+        // A server that ignores the range sends it all; skip what is there already
+        if (nCode == 200)
+            decoder.nSkip = req.nOffset;
+        if (GetHeader(sHeaders, "transfer-encoding").find("chunked") != std::string::npos) {
+            decoder.state = CBodyDecoder::CHUNK_SIZE;
+        } else if (!GetHeader(sHeaders, "content-length").empty()) {
+            decoder.fLength = true;
+            decoder.nRemaining = atoi64(GetHeader(sHeaders, "content-length"));
+            if (decoder.nRemaining == 0)
+                decoder.state = CBodyDecoder::DONE;
+        }
+        if (sHeader.size() > nHeaderEnd + 4 && !decoder.Feed(sHeader.data() + nHeaderEnd + 4, sHeader.size() - nHeaderEnd - 4))
+            break;
+        if (decoder.state == CBodyDecoder::DONE)
+            break;
+    }
+    CloseSocket(hSocket);
+
+    if (nStatus != IPFS_INCOMPLETE || !fHeader)
+        return nStatus;
+    if (!decoder.IsComplete(fClosed))
+        return decoder.fSinkFailed ? IPFS_FILE_ERROR : IPFS_INCOMPLETE;
+    if (!req.sExpectedSHA256.empty()) {
+        unsigned char hash[CSHA256::OUTPUT_SIZE];
+        hasher.Finalize(hash);
+        if (HexStr(hash, hash + sizeof(hash)) != boost::to_lower_copy(req.sExpectedSHA256))
+            return IPFS_HASH_MISMATCH;
+    }
+    return IPFS_OK;
+}
+
+std::vector<int> IPFSGetAll(const std::vector<CIPFSRequest>& vRequests, int nThreads)
+{
+    std::vector<int> vStatus(vRequests.size(), IPFS_INCOMPLETE);
+    size_t nNext = 0;
+    CCriticalSection cs;
+    boost::thread_group threads;
+    nThreads = std::max(1, std::min(nThreads, (int)vRequests.size()));
+    for (int i = 0; i < nThreads; i++)
+        threads.create_thread(boost::bind(&GetAllThread, &vRequests, &vStatus, &nNext, &cs));
+    threads.join_all();
+    return vStatus;
+}
+
+int IPFSGetString(const std::string& sURL, double dTimeoutSecs, size_t nMaxSize, std::string& sDataRet)
+{
+    sDataRet.clear();
+    CIPFSRequest req;
+    req.sURL = sURL;
+    req.dTimeoutSecs = dTimeoutSecs;
+    req.sink = boost::bind(&AppendToString, &sDataRet, nMaxSize, _1, _2);
+    return IPFSGet(req);
+}
+
+int IPFSDownloadFile(const std::string& sURL, const std::string& sPath, double dTimeoutSecs, bool fResume, const std::string& sExpectedSHA256)
+{
+    CIPFSRequest req;
+    req.sURL = sURL;
+    req.dTimeoutSecs = dTimeoutSecs;
+    boost::system::error_code ec;
+    if (fResume && boost::filesystem::exists(sPath, ec))
+        req.nOffset = boost::filesystem::file_size(sPath, ec);
+    if (ec)
+        req.nOffset = 0;
+
+    CSHA256 hasher;
+    CFileSink sink;
+    sink.pHasher = sExpectedSHA256.empty() ? NULL : &hasher;
+    sink.file = fopen(sPath.c_str(), req.nOffset > 0 ? "a+b" : "wb");
+    if (!sink.file)
+        return IPFS_FILE_ERROR;
+    if (sink.pHasher && req.nOffset > 0) {
+        std::vector<char> vBuffer(RECEIVE_BUFFER_SIZE);
+        size_t nRead;
+        while ((nRead = fread(&vBuffer[0], 1, vBuffer.size(), sink.file)) > 0)
+            hasher.Write((const unsigned char*)&vBuffer[0], nRead);
+    }
+    req.sink = boost::bind(&CFileSink::Write, &sink, _1, _2);
+    int nStatus = IPFSGet(req);
+    if (fclose(sink.file) != 0 && nStatus == IPFS_OK)
+        nStatus = IPFS_FILE_ERROR;
+
+    if (nStatus == IPFS_OK && sink.pHasher) {
+        unsigned char hash[CSHA256::OUTPUT_SIZE];
+        hasher.Finalize(hash);
+        if (HexStr(hash, hash + sizeof(hash)) != boost::to_lower_copy(sExpectedSHA256)) {
+            boost::filesystem::remove(sPath, ec);
+            return IPFS_HASH_MISMATCH;
+        }
+    }
+    return nStatus;
+}
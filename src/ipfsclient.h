@@ -0,0 +1,67 @@
+// Copyright (c) 2017-2018 The Biblepay Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_IPFSCLIENT_H
+#define BITCOIN_IPFSCLIENT_H
+
+#include <string>
+#include <vector>
+
+#include <stdint.h>
+
+#include <boost/function.hpp>
+
+/** Results of an IPFS gateway request; IPFS_OK is 1 and failures are negative, as ipfs_download always returned */
+enum IPFSStatus
+{
+    IPFS_OK = 1,
+    IPFS_FILE_ERROR = -1,
+    IPFS_INCOMPLETE = -2,
+    IPFS_CONNECT_FAILED = -3,
+    IPFS_BAD_ADDRESS = -4,
+    IPFS_HASH_MISMATCH = -5,
+    IPFS_HTTP_ERROR = -6,
+};
+
+/** Receives the body as it arrives; returning false aborts the request */
+typedef boost::function<bool (const char* pch, size_t nLen)> IPFSBodySink;
+
+/** One GET request against an IPFS gateway (plain HTTP) */
+struct CIPFSRequest
+{
+    std::string sURL;
+    double dTimeoutSecs;
+    //! Ask for the body from this offset on (HTTP Range), to resume a partial download
+    uint64_t nOffset;
+    //! Hex SHA256 the body from nOffset on must have; checked as it streams, empty to skip
+    std::string sExpectedSHA256;
+    IPFSBodySink sink;
+
+    CIPFSRequest() : dTimeoutSecs(15), nOffset(0) {}
+};
+
+/** Splits an http:// URL; the port defaults to 80 */
+bool ParseHTTPURL(const std::string& sURL, std::string& sHostRet, int& nPortRet, std::string& sPathRet);
+
+/**
+ * Performs the request, handing the body to its sink as it arrives, without
+ * buffering it or writing it anywhere. Content-Length, chunked and
+ * close-delimited bodies are accepted; a body is only IPFS_OK once it arrived
+ * complete (and matched sExpectedSHA256).
+ */
+int IPFSGet(const CIPFSRequest& req);
+
+/** Runs the requests on up to nThreads connections at a time; returns their results in order */
+std::vector<int> IPFSGetAll(const std::vector<CIPFSRequest>& vRequests, int nThreads);
+
+/** Reads the body into memory, failing beyond nMaxSize bytes */
+int IPFSGetString(const std::string& sURL, double dTimeoutSecs, size_t nMaxSize, std::string& sDataRet);
+
+/**
+ * Streams the body into sPath. With fResume an existing partial file is
+ * continued from its end rather than downloaded again.
+ */
+int IPFSDownloadFile(const std::string& sURL, const std::string& sPath, double dTimeoutSecs, bool fResume = false, const std::string& sExpectedSHA256 = "");
+
+#endif // BITCOIN_IPFSCLIENT_H
@@ -0,0 +1,101 @@
+// Copyright (c) 2017-2018 The Biblepay Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "keyset.h"
+
+#include "base58.h"
+#include "utilstrencodings.h"
+
+#include <boost/variant/get.hpp>
+
+static bool DecodeCPID(const std::string& sCPID, unsigned char* pkey)
+{
+    if (sCPID.size() != 32 || !IsHex(sCPID))
+        return false;
+    std::vector<unsigned char> vch = ParseHex(sCPID);
+    memcpy(pkey, &vch[0], 16);
+    return true;
+}
+
+CCPIDSet::CCPIDSet(const std::string& sList)
+{
+    size_t nStart = 0;
+    while (nStart < sList.size()) {
+        size_t nComma = sList.find(',', nStart);
+        size_t nStop = nComma == std::string::npos ? sList.size() : nComma;
+        if (nStop > nStart)
+            Insert(sList.substr(nStart, nStop - nStart));
+        nStart = nStop + 1;
+    }
+}
+
+void CCPIDSet::Insert(const std::string& sCPID)
+{
+    unsigned char key[16];
+    if (DecodeCPID(sCPID, key))
+        setKeys.Insert(key);
+    else if (!sCPID.empty())
+        setOther.insert(sCPID);
+}
+
+bool CCPIDSet::Contains(const std::string& sCPID) const
+{
+    unsigned char key[16];
+    if (DecodeCPID(sCPID, key))
+        return setKeys.Contains(key);
+    return !setOther.empty() && setOther.count(sCPID);
+}
+
+static bool DecodeAddress(const std::string& sAddress, unsigned char* pkey)
+{
+    CBitcoinAddress address(sAddress);
+    if (!address.IsValid())
+        return false;
+    CTxDestination dest = address.Get();
+    if (const CKeyID* pkeyID = boost::get<CKeyID>(&dest)) {
+        pkey[0] = 1;
+        memcpy(pkey + 1, pkeyID->begin(), 20);
+    } else if (const CScriptID* pscriptID = boost::get<CScriptID>(&dest)) {
+        pkey[0] = 2;
+        memcpy(pkey + 1, pscriptID->begin(), 20);
+    } else {
+        return false;
+    }
+    return true;
+}
+
+CAddressKey::CAddressKey(const std::string& sAddress)
+{
+    if (!DecodeAddress(sAddress, vch))
+        memset(vch, 0, sizeof(vch));
+}
+
+CAddressSet::CAddressSet(const std::string& sList)
+{
+    static const std::string DELIMITERS = "|;, ";
+    size_t nStart = 0;
+    while (nStart < sList.size()) {
+        size_t nStop = sList.find_first_of(DELIMITERS, nStart);
+        if (nStop == std::string::npos)
+            nStop = sList.size();
+        if (nStop > nStart)
+            Insert(sList.substr(nStart, nStop - nStart));
+        nStart = nStop + 1;
+    }
+}
+
+bool CAddressSet::Insert(const std::string& sAddress)
+{
+    unsigned char key[21];
+    if (!DecodeAddress(sAddress, key))
+        return false;
+    setKeys.Insert(key);
+    return true;
+}
+
+bool CAddressSet::Contains(const std::string& sAddress) const
+{
+    unsigned char key[21];
+    return setKeys.size() > 0 && DecodeAddress(sAddress, key) && setKeys.Contains(key);
+}
@@ -0,0 +1,154 @@
+// Copyright (c) 2017-2018 The Biblepay Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_KEYSET_H
+#define BITCOIN_KEYSET_H
+
+#include "crypto/common.h"
+
+#include <set>
+#include <string>
+#include <vector>
+
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * Open addressing hash set of fixed width binary keys that are hash outputs
+ * already (MD5 CPIDs, address hashes), so the leading bytes of a key serve as
+ * its hash. Slots are probed linearly and the table doubles at half load.
+ */
+template <unsigned int WIDTH>
+class CFixedKeySet
+{
+private:
+    //! nMask + 1 slots of WIDTH bytes each, and whether each slot is taken
+    std::vector<unsigned char> vKeys;
+    std::vector<bool> vUsed;
+    size_t nSize;
+    size_t nMask;
+
+    size_t Hash(const unsigned char* pkey) const
+    {
+        unsigned char buf[8] = {0};
+        memcpy(buf, pkey, WIDTH < 8 ? WIDTH : 8);
+        return (size_t)ReadLE64(buf);
+    }
+
+    //! The slot holding pkey, or the empty slot where it belongs
+    size_t Find(const unsigned char* pkey) const
+    {
+        size_t nSlot = Hash(pkey) & nMask;
+        while (vUsed[nSlot] && memcmp(&vKeys[nSlot * WIDTH], pkey, WIDTH) != 0)
+            nSlot = (nSlot + 1) & nMask;
+        return nSlot;
+    }
+
+    void Resize(size_t nSlots)
+    {
+        std::vector<unsigned char> vOldKeys;
+        std::vector<bool> vOldUsed;
+        vOldKeys.swap(vKeys);
+        vOldUsed.swap(vUsed);
+        vKeys.resize(nSlots * WIDTH);
+        vUsed.assign(nSlots, false);
+        nMask = nSlots - 1;
+        for (size_t i = 0; i < vOldUsed.size(); i++) {
+            if (!vOldUsed[i])
+                continue;
+            size_t nSlot = Find(&vOldKeys[i * WIDTH]);
+            memcpy(&vKeys[nSlot * WIDTH], &vOldKeys[i * WIDTH], WIDTH);
+            vUsed[nSlot] = true;
+        }
+    }
+
+public:
+    CFixedKeySet() : nSize(0), nMask(0) {}
+
+    /** Adds the WIDTH bytes at pkey; false if they were present already */
+    bool Insert(const unsigned char* pkey)
+    {
+        if (2 * (nSize + 1) > vUsed.size())
+            Resize(vUsed.empty() ? 16 : 2 * vUsed.size());
+        size_t nSlot = Find(pkey);
+        if (vUsed[nSlot])
+            return false;
+        memcpy(&vKeys[nSlot * WIDTH], pkey, WIDTH);
+        vUsed[nSlot] = true;
+        nSize++;
+        return true;
+    }
+
+    bool Contains(const unsigned char* pkey) const
+    {
+        return nSize > 0 && vUsed[Find(pkey)];
+    }
+
+    size_t size() const { return nSize; }
+
+    void clear()
+    {
+        vKeys.clear();
+        vUsed.clear();
+        nSize = 0;
+        nMask = 0;
+    }
+};
+
+/**
+ * Set of researcher CPIDs (32 hex digits, any case) held as 16 byte binary
+ * keys. Membership is exact: unlike Contains() on a comma joined list, a
+ * blank or partial CPID is never found. Entries that are not CPIDs are kept
+ * as strings, so they still match themselves.
+ */
+class CCPIDSet
+{
+private:
+    CFixedKeySet<16> setKeys;
+    std::set<std::string> setOther;
+
+public:
+    CCPIDSet() {}
+    /** The entries of a comma separated list */
+    explicit CCPIDSet(const std::string& sList);
+
+    void Insert(const std::string& sCPID);
+    bool Contains(const std::string& sCPID) const;
+    size_t size() const { return setKeys.size() + setOther.size(); }
+};
+
+/** A decoded BiblePay address: its type (1 key hash, 2 script hash) and hash, or all zeros if it was not a valid address */
+struct CAddressKey
+{
+    unsigned char vch[21];
+
+    CAddressKey() { memset(vch, 0, sizeof(vch)); }
+    explicit CAddressKey(const std::string& sAddress);
+
+    bool IsNull() const { return vch[0] == 0; }
+};
+
+/**
+ * Set of BiblePay addresses held as their decoded type and hash (21 byte
+ * keys). Membership is exact, and strings that are not valid addresses are
+ * neither added nor found. Addresses that are probed often should be decoded
+ * once into a CAddressKey.
+ */
+class CAddressSet
+{
+private:
+    CFixedKeySet<21> setKeys;
+
+public:
+    CAddressSet() {}
+    /** The addresses of a list delimited by '|', ';', ',' or spaces, as GetMyPublicKeys and the RPCs give them */
+    explicit CAddressSet(const std::string& sList);
+
+    bool Insert(const std::string& sAddress);
+    bool Contains(const std::string& sAddress) const;
+    bool Contains(const CAddressKey& key) const { return setKeys.size() > 0 && !key.IsNull() && setKeys.Contains(key.vch); }
+    size_t size() const { return setKeys.size(); }
+};
+
+#endif // BITCOIN_KEYSET_H
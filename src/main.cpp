@@ -8,15 +8,19 @@
 
 #include "addrman.h"
 #include "alert.h"
+#include "appcache.h"
 #include "arith_uint256.h"
+#include "blockcache.h"
 #include "chainparams.h"
 #include "checkpoints.h"
 #include "checkqueue.h"
 #include "consensus/consensus.h"
 #include "consensus/merkle.h"
 #include "consensus/validation.h"
+#include "core_memusage.h"
 #include "hash.h"
 #include "init.h"
+#include "keyset.h"
 #include "podc.h"
 #include "merkleblock.h"
 #include "net.h"
@@ -30,6 +34,7 @@
 #include "tinyformat.h"
 #include "txdb.h"
 #include "txmempool.h"
+#include "txmessage.h"
 #include "ui_interface.h"
 #include "undo.h"
 #include "util.h"
@@ -146,8 +151,6 @@ std::string ExecuteDistributedComputingSanctuaryQuorumProcess();
 int iPrayerIndex = 0;
 std::string sOS = "";
 
-std::map<std::string, std::string> mvApplicationCache;
-std::map<std::string, int64_t> mvApplicationCacheTimestamp;
 std::map<int64_t, std::string> mapDebug;
 
 bool fPoolMiningMode = false;
@@ -196,6 +199,7 @@ bool fTxIndex = true;
 bool fAddressIndex = false;
 bool fTimestampIndex = false;
 bool fSpentIndex = false;
+bool fBlockSummaryIndex = DEFAULT_BLOCKSUMMARYINDEX;
 bool fHavePruned = false;
 bool fPruneMode = false;
 bool fIsBareMultisigStd = DEFAULT_PERMIT_BAREMULTISIG;
@@ -768,6 +772,7 @@ CBlockIndex* FindForkInGlobalIndex(const CChain& chain, const CBlockLocator& loc
 
 CCoinsViewCache *pcoinsTip = NULL;
 CBlockTreeDB *pblocktree = NULL;
+CBibleHashDB *pbiblehashdb = NULL;
 
 //////////////////////////////////////////////////////////////////////////////
 //
@@ -2015,6 +2020,114 @@ bool GetAddressUnspent(uint160 addressHash, int type,
     return true;
 }
 
+/** In-memory copy of the superblock payment index, by height (protected by cs_main) */
+static std::map<int, CSuperblockPayments> mapSuperblockPayments;
+
+static bool IsSuperblockPaymentHeight(int nHeight)
+{
+    return nHeight > Params().GetConsensus().nDCCSuperblockStartBlock && CSuperblock::IsDCCSuperblock(nHeight);
+}
+
+static bool WriteSuperblockPaymentIndex(const CBlock& block, const CBlockIndex* pindex)
+{
+    CSuperblockPayments payments;
+    payments.hashBlock = pindex->GetBlockHash();
+    payments.nTime = block.GetBlockTime();
+    payments.nBudget = CSuperblock::GetPaymentsLimit(pindex->nHeight);
+    for (unsigned int i = 1; i < block.vtx[0].vout.size(); i++)
+        payments.vPayments.push_back(std::make_pair(PubKeyToAddress(block.vtx[0].vout[i].scriptPubKey), block.vtx[0].vout[i].nValue));
+
+    if (!pblocktree->WriteSuperblockPayments(pindex->nHeight, payments))
+        return false;
+    payments.DecodeAddresses();
+    mapSuperblockPayments[pindex->nHeight] = payments;
+    return true;
+}
+
+static bool EraseSuperblockPaymentIndex(int nHeight)
+{
+    if (!pblocktree->EraseSuperblockPayments(nHeight))
+        return false;
+    mapSuperblockPayments.erase(nHeight);
+    return true;
+}
+
+bool LoadSuperblockPaymentIndex(const Consensus::Params& consensusParams)
+{
+    LOCK(cs_main);
+    mapSuperblockPayments.clear();
+    if (!pblocktree->ReadSuperblockPayments(mapSuperblockPayments))
+        return error("%s: unable to read superblock payment index", __func__);
+
+    std::vector<int> vStale;
+    for (std::map<int, CSuperblockPayments>::iterator it = mapSuperblockPayments.begin(); it != mapSuperblockPayments.end(); ++it) {
+        if (chainActive[it->first] == NULL || chainActive[it->first]->GetBlockHash() != it->second.hashBlock)
+            vStale.push_back(it->first);
+        else
+            it->second.DecodeAddresses();
+    }
+    BOOST_FOREACH(int nHeight, vStale) {
+        if (!EraseSuperblockPaymentIndex(nHeight))
+            return error("%s: unable to erase superblock payments at %d", __func__, nHeight);
+    }
+
+    // Superblocks connected before the index existed
+    int nAdded = 0;
+    for (int nHeight = consensusParams.nDCCSuperblockStartBlock + 1; nHeight <= chainActive.Height(); nHeight++) {
+        if (!IsSuperblockPaymentHeight(nHeight) || mapSuperblockPayments.count(nHeight))
+            continue;
+        CBlockIndex* pindex = chainActive[nHeight];
+        CBlock block;
+        if (!(pindex->nStatus & BLOCK_HAVE_DATA) || !ReadBlockFromDisk(block, pindex, consensusParams))
+            continue;
+        if (!WriteSuperblockPaymentIndex(block, pindex))
+            return error("%s: unable to write superblock payments at %d", __func__, nHeight);
+        nAdded++;
+    }
+    LogPrintf("%s: %u superblocks indexed, %d added, %u stale removed\n", __func__, mapSuperblockPayments.size(), nAdded, vStale.size());
+    return true;
+}
+
+bool GetSuperblockPayments(int nHeight, CSuperblockPayments &payments)
+{
+    LOCK(cs_main);
+    std::map<int, CSuperblockPayments>::const_iterator it = mapSuperblockPayments.find(nHeight);
+    if (it == mapSuperblockPayments.end())
+        return false;
+    payments = it->second;
+    return true;
+}
+
+std::vector<int> GetSuperblockPaymentHeights(int nMaxHeight)
+{
+    LOCK(cs_main);
+    std::vector<int> vHeights;
+    std::map<int, CSuperblockPayments>::const_iterator it = mapSuperblockPayments.upper_bound(nMaxHeight);
+    while (it != mapSuperblockPayments.begin()) {
+        --it;
+        vHeights.push_back(it->first);
+    }
+    return vHeights;
+}
+
+CAmount GetSuperblockPaymentsToAddresses(const CAddressSet &setAddresses, int64_t nStartTime, int64_t nEndTime, int &nSuperblocks)
+{
+    LOCK(cs_main);
+    CAmount nTotal = 0;
+    nSuperblocks = 0;
+    for (std::map<int, CSuperblockPayments>::const_iterator it = mapSuperblockPayments.begin(); it != mapSuperblockPayments.end(); ++it) {
+        const CSuperblockPayments& payments = it->second;
+        if (payments.nTime <= nStartTime || payments.nTime >= nEndTime)
+            continue;
+        nSuperblocks++;
+        for (unsigned int i = 0; i < payments.vPayments.size(); i++) {
+            if (setAddresses.Contains(payments.vPaymentKeys[i]))
+                nTotal += payments.vPayments[i].second;
+        }
+    }
+    return nTotal;
+}
+
 
 const CBlockIndex* GetBlockIndexByTransactionHash(const uint256 &hash)
 {
@@ -2077,7 +2190,7 @@ bool GetTransaction(const uint256 &hash, CTransaction &txOut, const Consensus::P
 
     if (pindexSlow) {
         CBlock block;
-        if (ReadBlockFromDisk(block, pindexSlow, consensusParams, "GetTransaction")) 
+        if (ReadBlockFromDisk(block, pindexSlow, consensusParams)) 
 		{
             BOOST_FOREACH(const CTransaction &tx, block.vtx) {
                 if (tx.GetHash() == hash) {
@@ -2123,69 +2236,83 @@ bool WriteBlockToDisk(const CBlock& block, CDiskBlockPos& pos, const CMessageHea
     return true;
 }
 
-bool ReadBlockFromDisk(CBlock& block, const CDiskBlockPos& pos, const Consensus::Params& consensusParams, std::string Context)
+/** Reads and deserializes the block at pos, returning its serialized size */
+static bool ReadBlockFromDiskPos(CBlock& block, const CDiskBlockPos& pos)
 {
+    block.SetNull();
 
-	// September 14th, 2017 - Robert A. - BiblePay
-	// Depending on the context of the call, ensure the block is read from the disk without a CheckProofOfWork Error
-
-	boost::to_upper(Context);
-	bool bCheckPOW = true;
-	if  (  Context=="RETRIEVETXOUTINFO" 
-		|| Context=="GETTRANSACTION" 
-		|| Context=="CONNECTTIP"
-		|| Context=="VERIFYDB" 
-		|| Context=="LOADEXTERNALBLOCKFILE" 
-	    ) 
-	{
-		bCheckPOW = true;
-	}
-	else if (Context=="PROCESSGETDATA" || Context=="DISCONNECTTIP" || Context=="GETSUBSIDY" || Context=="MEMORIZEBLOCKCHAINPRAYERS") 
-	{
-		bCheckPOW = false;
-	}
-	else
-	{
-		bCheckPOW = true;
-	}
-
+    // Deserialize from the mapped block file, or read it the buffered way if it cannot be mapped
+    size_t nSize;
+    if (blockFileCache.ReadBlock(pos, block, nSize))
+        return true;
     block.SetNull();
 
-    // Open history file to read
     CAutoFile filein(OpenBlockFile(pos, true), SER_DISK, CLIENT_VERSION);
     if (filein.IsNull())
-        return error("ReadBlockFromDisk: OpenBlockFile failed for %s with Context %s", pos.ToString(), Context.c_str());
+        return error("ReadBlockFromDisk: OpenBlockFile failed for %s", pos.ToString());
 
-    // Read block
     try {
         filein >> block;
     }
     catch (const std::exception& e) {
-        return error("%s: Deserialize or I/O error - %s at %s, Context %s", __func__, e.what(), pos.ToString(), Context.c_str());
+        return error("%s: Deserialize or I/O error - %s at %s", __func__, e.what(), pos.ToString());
     }
+    return true;
+}
 
-    // Check the header
-	CBlockIndex* pindexAncestor=mapBlockIndex[block.hashPrevBlock];
+/** Checks the header of a block read from disk against its parent */
+static bool CheckBlockReadPow(const CBlock& block, const CDiskBlockPos& pos, const CBlockIndex* pindexAncestor, const Consensus::Params& consensusParams)
+{
     int64_t nAncestorTime = (pindexAncestor==NULL) ? 0 : pindexAncestor->nTime;
 	int nPrevHeight = (pindexAncestor==NULL) ? 0 : pindexAncestor->nHeight;
-	if (bCheckPOW)
+	if (!CheckProofOfWork(block.GetHash(), block.nBits, consensusParams, block.GetBlockTime(), nAncestorTime, nPrevHeight, block.nNonce, pindexAncestor, true))
 	{
-		if (!CheckProofOfWork(block.GetHash(), block.nBits, consensusParams, block.GetBlockTime(), nAncestorTime, nPrevHeight, block.nNonce, pindexAncestor, true))
-		{
-			LogPrintf("ReadBlockFromDisk (Context %s): Errors in block header at %s", Context.c_str(), pos.ToString());
-			return false;
-		}
+		LogPrintf("ReadBlockFromDisk: Errors in block header at %s", pos.ToString());
+		return false;
 	}
     return true;
 }
 
-bool ReadBlockFromDisk(CBlock& block, const CBlockIndex* pindex, const Consensus::Params& consensusParams, std::string Context)
+bool ReadBlockFromDisk(CBlock& block, const CDiskBlockPos& pos, const Consensus::Params& consensusParams, BlockReadPolicy policy)
 {
-    if (!ReadBlockFromDisk(block, pindex->GetBlockPos(), consensusParams, Context))
+    if (!ReadBlockFromDiskPos(block, pos))
+        return false;
+    if (policy == BLOCK_READ_SKIP_POW)
+        return true;
+    const CBlockIndex* pindexAncestor = NULL;
+    BlockMap::iterator mi = mapBlockIndex.find(block.hashPrevBlock);
+    if (mi != mapBlockIndex.end())
+        pindexAncestor = mi->second;
+    return CheckBlockReadPow(block, pos, pindexAncestor, consensusParams);
+}
+
+bool ReadBlockFromDisk(CBlockCache::block_ptr& pblockRet, const CBlockIndex* pindex, const Consensus::Params& consensusParams, BlockReadPolicy policy)
+{
+	// A block connected with its scripts validated passed CheckProofOfWork then; reading it by index only needs its hash to match
+    bool fCheckPow = policy == BLOCK_READ_CHECK_POW && !pindex->IsValid(BLOCK_VALID_SCRIPTS);
+    if (blockCache.Get(pindex->GetBlockHash(), fCheckPow, pblockRet))
+        return true;
+
+    CBlock* pblock = new CBlock();
+    CBlockCache::block_ptr pread(pblock);
+    if (!ReadBlockFromDiskPos(*pblock, pindex->GetBlockPos()))
         return false;
-    if (block.GetHash() != pindex->GetBlockHash())
+    if (pblock->GetHash() != pindex->GetBlockHash())
         return error("ReadBlockFromDisk(CBlock&, CBlockIndex*): GetHash() doesn't match index for %s at %s",
                 pindex->ToString(), pindex->GetBlockPos().ToString());
+    if (fCheckPow && !CheckBlockReadPow(*pblock, pindex->GetBlockPos(), pindex->pprev, consensusParams))
+        return false;
+    blockCache.Insert(pindex->GetBlockHash(), pread, RecursiveDynamicUsage(*pblock), fCheckPow);
+    pblockRet = pread;
+    return true;
+}
+
+bool ReadBlockFromDisk(CBlock& block, const CBlockIndex* pindex, const Consensus::Params& consensusParams, BlockReadPolicy policy)
+{
+    CBlockCache::block_ptr pblock;
+    if (!ReadBlockFromDisk(pblock, pindex, consensusParams, policy))
+        return false;
+    block = *pblock;
     return true;
 }
 
@@ -3430,6 +3557,14 @@ bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockIndex* pin
         if (!pblocktree->WriteTimestampIndex(CTimestampIndexKey(pindex->nTime, pindex->GetBlockHash())))
             return AbortNode(state, "Failed to write timestamp index");
 
+    if (IsSuperblockPaymentHeight(pindex->nHeight))
+        if (!WriteSuperblockPaymentIndex(block, pindex))
+            return AbortNode(state, "Failed to write superblock payment index");
+
+    // Only a cache of the blocks: RetrieveTxOutInfo fills in what is missing, so a failed write is not fatal
+    if (fBlockSummaryIndex && !pblocktree->WriteBlockSummary(pindex->GetBlockHash(), CBlockSummary(block)))
+        LogPrintf("ConnectBlock(): failed to write the block summary of %s\n", pindex->GetBlockHash().ToString());
+
     // add this block to the view's block chain
     view.SetBestBlock(pindex->GetBlockHash());
 
@@ -3640,7 +3775,7 @@ bool static DisconnectTip(CValidationState& state, const Consensus::Params& cons
     assert(pindexDelete);
     // Read block from disk.
     CBlock block;
-    if (!ReadBlockFromDisk(block, pindexDelete, consensusParams, "DisconnectTip"))
+    if (!ReadBlockFromDisk(block, pindexDelete, consensusParams, BLOCK_READ_SKIP_POW))
         return AbortNode(state, "Failed to read block");
     // Apply the block atomically to the chain state.
     int64_t nStart = GetTimeMicros();
@@ -3650,6 +3785,10 @@ bool static DisconnectTip(CValidationState& state, const Consensus::Params& cons
             return error("DisconnectTip(): DisconnectBlock %s failed", pindexDelete->GetBlockHash().ToString());
         assert(view.Flush());
     }
+    // Not in DisconnectBlock, which VerifyDB also runs on blocks that stay in the chain
+    if (IsSuperblockPaymentHeight(pindexDelete->nHeight))
+        if (!EraseSuperblockPaymentIndex(pindexDelete->nHeight))
+            return AbortNode(state, "Failed to delete superblock payment index");
     LogPrint("bench", "- Disconnect block: %.2fms\n", (GetTimeMicros() - nStart) * 0.001);
     // Write the chain state to disk, if necessary.
     if (!FlushStateToDisk(state, FLUSH_STATE_IF_NEEDED))
@@ -3674,6 +3813,7 @@ bool static DisconnectTip(CValidationState& state, const Consensus::Params& cons
     mempool.UpdateTransactionsFromBlock(vHashUpdate);
     // Update chainActive and related variables.
     UpdateTip(pindexDelete->pprev);
+    blockCache.Erase(pindexDelete->GetBlockHash());
     // Let wallets know transactions went from 1-confirmed to
     // 0-confirmed or conflicted:
     BOOST_FOREACH(const CTransaction &tx, block.vtx) {
@@ -3705,7 +3845,7 @@ bool static ConnectTip(CValidationState& state, const CChainParams& chainparams,
     int64_t nTime1 = GetTimeMicros();
     CBlock block;
     if (!pblock) {
-        if (!ReadBlockFromDisk(block, pindexNew, chainparams.GetConsensus(), "ConnectTip"))
+        if (!ReadBlockFromDisk(block, pindexNew, chainparams.GetConsensus()))
             return AbortNode(state, "Failed to read block");
         pblock = &block;
     }
@@ -4155,6 +4295,10 @@ CBlockIndex* AddToBlockIndex(const CBlockHeader& block)
         pindexNew->BuildSkip();
     }
 
+	// The header passed CheckProofOfWork already, which leaves its BibleHash in the store; persist it with the index entry
+	if (pbiblehashdb && pindexNew->pprev)
+		pbiblehashdb->ReadBibleHash(hash, pindexNew->GetBlockTime(), pindexNew->pprev->nTime, pindexNew->pprev->nHeight, pindexNew->nNonce, pindexNew->hashBibleHash);
+
     pindexNew->nChainWork = (pindexNew->pprev ? pindexNew->pprev->nChainWork : 0) + GetBlockProof(*pindexNew);
     pindexNew->RaiseValidity(BLOCK_VALID_TREE);
 
@@ -4460,7 +4604,7 @@ bool HasThisCPIDSolvedPriorBlocks(std::string CPID, CBlockIndex* pindexPrev)
 		if (pindex != NULL)
 		{
 			CBlock block;
-        	if (ReadBlockFromDisk(block, pindex, chainparams.GetConsensus(), "HasThisCPIDSolvedPriorBlocks"))
+        	if (ReadBlockFromDisk(block, pindex, chainparams.GetConsensus()))
 			{
 				std::string sCPIDSig = ExtractXML(block.vtx[0].vout[0].sTxOutMessage, "<cpidsig>","</cpidsig>");
 				std::string lastcpid = GetElement(sCPIDSig, ";", 0);
@@ -4930,6 +5074,7 @@ void UnlinkPrunedFiles(std::set<int>& setFilesToPrune)
 {
     for (set<int>::iterator it = setFilesToPrune.begin(); it != setFilesToPrune.end(); ++it) {
         CDiskBlockPos pos(*it, 0);
+        blockFileCache.Close(*it);
         boost::filesystem::remove(GetBlockPosFilename(pos, "blk"));
         boost::filesystem::remove(GetBlockPosFilename(pos, "rev"));
         LogPrintf("Prune: %s deleted blk/rev (%05u)\n", __func__, *it);
@@ -5233,7 +5378,7 @@ bool CVerifyDB::VerifyDB(const CChainParams& chainparams, CCoinsView *coinsview,
             break;
         CBlock block;
         // check level 0: read from disk
-        if (!ReadBlockFromDisk(block, pindex, chainparams.GetConsensus(), "VerifyDB"))
+        if (!ReadBlockFromDisk(block, pindex, chainparams.GetConsensus()))
             return error("VerifyDB(): *** ReadBlockFromDisk failed at %d, hash=%s", pindex->nHeight, pindex->GetBlockHash().ToString());
         // check level 1: verify block validity
         if (nCheckLevel >= 1 && !CheckBlock(block, state, true, true, block.GetBlockTime(), pindex->pprev ? pindex->pprev->nTime : 0, pindex->pprev ? pindex->pprev->nHeight : 0, pindex->pprev))
@@ -5268,12 +5413,13 @@ bool CVerifyDB::VerifyDB(const CChainParams& chainparams, CCoinsView *coinsview,
     // check level 4: try reconnecting blocks
     if (nCheckLevel >= 4) {
         CBlockIndex *pindex = pindexState;
+        CBlockFileScan scan;
         while (pindex != chainActive.Tip()) {
             boost::this_thread::interruption_point();
             uiInterface.ShowProgress(_("Verifying blocks..."), std::max(1, std::min(99, 100 - (int)(((double)(chainActive.Height() - pindex->nHeight)) / (double)nCheckDepth * 50))));
             pindex = chainActive.Next(pindex);
             CBlock block;
-            if (!ReadBlockFromDisk(block, pindex, chainparams.GetConsensus(), "VerifyDB"))
+            if (!ReadBlockFromDisk(block, pindex, chainparams.GetConsensus()))
                 return error("VerifyDB(): *** ReadBlockFromDisk failed at %d, hash=%s", pindex->nHeight, pindex->GetBlockHash().ToString());
             if (!ConnectBlock(block, state, pindex, coins))
                 return error("VerifyDB(): *** found unconnectable block at %d, hash=%s", pindex->nHeight, pindex->GetBlockHash().ToString());
@@ -5469,7 +5615,7 @@ bool LoadExternalBlockFile(const CChainParams& chainparams, FILE* fileIn, CDiskB
                     while (range.first != range.second) 
 					{
                         std::multimap<uint256, CDiskBlockPos>::iterator it = range.first;
-	                    if (ReadBlockFromDisk(block, it->second, chainparams.GetConsensus(), "LoadExternalBlockFile"))
+	                    if (ReadBlockFromDisk(block, it->second, chainparams.GetConsensus()))
                         {
                             LogPrintf("%s: Processing out of order child %s of %s\n", __func__, block.GetHash().ToString(),
                                     head.ToString());
@@ -5901,7 +6047,7 @@ void static ProcessGetData(CNode* pfrom, const Consensus::Params& consensusParam
 				{
                     // Send block from disk
                     CBlock block;
-                    if (!ReadBlockFromDisk(block, (*mi).second, consensusParams, "ProcessGetData"))
+                    if (!ReadBlockFromDisk(block, (*mi).second, consensusParams, BLOCK_READ_SKIP_POW))
 					{
                         //assert(!"cannot load block from disk");
 						LogPrintf("\r\n** ProcessGetData:Cannot load block from disk.\r\n");
@@ -7414,22 +7560,17 @@ bool ProcessMessages(CNode* pfrom)
     return fOk;
 }
 
-static CBlockIndex* pblockindexFBBHLast;
 CBlockIndex* FindBlockByHeight(int nHeight)
 {
-    CBlockIndex *pblockindex;
-    if (nHeight < chainActive.Tip()->nHeight / 2)
-		pblockindex = mapBlockIndex[cblockGenesis.GetHash()];
-    else
-        pblockindex = chainActive.Tip();
-    if (pblockindexFBBHLast && abs(nHeight - pblockindex->nHeight) > abs(nHeight - pblockindexFBBHLast->nHeight))
-        pblockindex = pblockindexFBBHLast;
-    while (pblockindex->nHeight > nHeight)
-        pblockindex = pblockindex->pprev;
-    while (pblockindex->nHeight < nHeight)
-		pblockindex = chainActive.Next(pblockindex);
-    pblockindexFBBHLast = pblockindex;
-    return pblockindex;
+    // chainActive is indexed by height, so this is a lookup rather than a walk from a shared cursor
+    LOCK(cs_main);
+    return chainActive[nHeight];
+}
+
+CBlockIndex* FindBlockByHeight(int nHeight, CBlockIndex* pindexFrom)
+{
+    // Block indexes never change their ancestry, so the skip list gets there in O(log n) without cs_main
+    return pindexFrom ? pindexFrom->GetAncestor(nHeight) : NULL;
 }
 
 
@@ -7552,13 +7693,12 @@ bool NonObnoxiousLog(std::string sLogSection, std::string sLogKey, std::string s
 {
 	boost::to_upper(sLogSection);
 	boost::to_upper(sLogKey);
-	int64_t nElapsed = GetAdjustedTime() - mvApplicationCacheTimestamp[sLogSection + ";" + sLogKey];
+	int64_t nElapsed = GetAdjustedTime() - appCache.ReadTimestamp(sLogSection, sLogKey);
 	WriteCache(sLogSection, sLogKey, "1", GetAdjustedTime());
 	bool bAllowed = (nElapsed > nAllowedSpan) ? true : false;
 	if (bAllowed)
 	{
 		LogPrintf("[%s], [%s]: %s (elapsed %f)", sLogSection.c_str(), sLogKey.c_str(), sValue.c_str(), (double)nElapsed);
-		mvApplicationCacheTimestamp[sLogSection + ";" + sLogKey] = GetAdjustedTime();
 	}
 	return bAllowed;
 }
@@ -7571,43 +7711,12 @@ void WriteCache(std::string sSection, std::string sKey, std::string sValue, int6
 		boost::to_upper(sSection);
 		boost::to_upper(sKey);
 	}
-	std::string temp_value = mvApplicationCache[sSection + ";" + sKey];
-	if (temp_value.empty())
-	{
-		mvApplicationCache.insert(map<std::string,std::string>::value_type(sSection + ";" + sKey, sValue));
-	    mvApplicationCache[sSection + ";" + sKey] = sValue;
-	}
-	mvApplicationCache[sSection + ";" + sKey] = sValue;
-	// Record Cache Entry timestamp
-	int64_t temp_locktime = mvApplicationCacheTimestamp[sSection + ";" + sKey];
-	if (temp_locktime == 0)
-	{
-		mvApplicationCacheTimestamp.insert(map<std::string,int64_t>::value_type(sSection + ";" + sKey,1));
-		mvApplicationCacheTimestamp[sSection + ";" + sKey]=locktime;
-	}
-	mvApplicationCacheTimestamp[sSection + ";" + sKey] = locktime;
+	appCache.Write(sSection, sKey, sValue, locktime);
 }
 
 void PurgeCacheAsOfExpiration(std::string sSection, int64_t nExpiration)
 {
-	boost::to_upper(sSection);
-	for(map<string,string>::iterator ii=mvApplicationCache.begin(); ii!=mvApplicationCache.end(); ++ii)
-	{
-		std::string sKey = (*ii).first;
-		boost::to_upper(sKey);
-		if (sKey.length() > sSection.length())
-		{
-			if (sKey.substr(0,sSection.length())==sSection)
-			{
-				int64_t nTimestamp = mvApplicationCacheTimestamp[sKey];
-				if (nTimestamp < nExpiration)
-				{
-					mvApplicationCache[sKey]="";
-					mvApplicationCacheTimestamp[sKey]=0;
-				}
-			}
-		}
-	}
+	appCache.PurgeSection(sSection, nExpiration);
 }
 
 
@@ -7621,9 +7730,7 @@ bool IsTimeWithinMins(int64_t nTime, int mins)
 
 void DeleteCache(std::string section, std::string keyname)
 {
-    std::string pk = section + ";" +keyname;
-    mvApplicationCache.erase(pk);
-    mvApplicationCacheTimestamp.erase(pk);
+    appCache.Erase(section, keyname);
 }
 
 
@@ -7636,9 +7743,10 @@ std::string GetMessagesFromBlock(const CBlock& block, std::string sTargetType)
 			{
 			  if (!tx.vout[0].sTxOutMessage.empty())
 			  {
-				  std::string sMessageType      = ExtractXML(tx.vout[0].sTxOutMessage,"<MT>","</MT>");
-				  std::string sMessageKey       = ExtractXML(tx.vout[0].sTxOutMessage,"<MK>","</MK>");
-				  std::string sMessageValue     = ExtractXML(tx.vout[0].sTxOutMessage,"<MV>","</MV>");
+				  CTxMessageTags tags(tx.vout[0].sTxOutMessage);
+				  std::string sMessageType      = tags.GetString(CTxMessageTags::TAG_MT);
+				  std::string sMessageKey       = tags.GetString(CTxMessageTags::TAG_MK);
+				  std::string sMessageValue     = tags.GetString(CTxMessageTags::TAG_MV);
 				  boost::to_upper(sMessageType);
 				  boost::to_upper(sMessageKey);
 				  if (!sMessageType.empty() && !sMessageKey.empty() && !sMessageValue.empty() && !sTargetType.empty())
@@ -7655,85 +7763,18 @@ std::string GetMessagesFromBlock(const CBlock& block, std::string sTargetType)
 }
 
 
-void MemorizeBlockChainPrayers(bool fDuringConnectBlock, bool fSubThread, bool fColdBoot, bool fDuringSanctuaryQuorum)
+/** The summary of a block from the block summary index, filled in from the block itself for blocks connected before the index existed */
+static bool GetBlockSummary(const CBlockIndex* pindex, CBlockSummary& summary)
 {
-		int nDeserializedHeight = 0;
-		if (fColdBoot)
-		{
-			nDeserializedHeight = DeserializePrayersFromFile();
-			if (chainActive.Tip()->nHeight < nDeserializedHeight && nDeserializedHeight > 0) nDeserializedHeight=0;
-		}
-
-		int nMaxDepth = chainActive.Tip()->nHeight;
-		int nMinDepth = fDuringConnectBlock ? nMaxDepth - 2 : nMaxDepth - (BLOCKS_PER_DAY * 30 * 12);  // One year
-		if (fDuringSanctuaryQuorum) nMinDepth = nMaxDepth - (BLOCKS_PER_DAY * 14); // Two Weeks
-
-		if (nDeserializedHeight > 0 && nDeserializedHeight < nMaxDepth) nMinDepth = nDeserializedHeight;
-
-		if (nMinDepth < 0) nMinDepth = 0;
-		CBlockIndex* pindex = FindBlockByHeight(nMinDepth);
-		const Consensus::Params& consensusParams = Params().GetConsensus();
-		if (fSubThread && !fPrayersMemorized) LogPrintf("MemorizeBlockChainPrayers @ %f ",GetAdjustedTime());
-		int64_t nMaxPaymentAge = 60 * 60 * 24 * 7;
-		while (pindex && pindex->nHeight < nMaxDepth)
-		{
-			if (pindex) if (pindex->nHeight < chainActive.Tip()->nHeight) pindex = chainActive.Next(pindex);
-			if (!pindex) break;
-			CBlock block;
-			if (ReadBlockFromDisk(block, pindex, consensusParams, "MemorizeBlockChainPrayers")) 
-			{
-	  			for (unsigned int n = 0; n < block.vtx.size(); n++)
-       			{
-					double dTotalSent = 0;
-					std::string sPrayer = "";
-					double dFoundationDonation = 0;
-					for (unsigned int i = 0; i < block.vtx[n].vout.size(); i++)
-					{
-						sPrayer += block.vtx[n].vout[i].sTxOutMessage;
-						double dAmount = block.vtx[n].vout[i].nValue / COIN;
-						dTotalSent += dAmount;
-
-						// As of F14000, we no longer need to tally cancer payments by public key, remove this to respect anonymity
-						if (!(fDistributedComputingEnabled && ((pindex->nHeight > F14000_CUTOVER_HEIGHT_PROD && fProd)  ||  (pindex->nHeight > F14000_CUTOVER_HEIGHT_TESTNET && !fProd))))
-						{
-							if (n==0 && i > 0 && block.vtx[n].vout.size() > 4)
-							{
-								std::string sRecipient = PubKeyToAddress(block.vtx[n].vout[i].scriptPubKey);
-								double dTally = cdbl(ReadCacheWithMaxAge("AddressPayment", sRecipient, nMaxPaymentAge), 0) + dAmount;
-								WriteCache("AddressPayment", sRecipient, RoundToString(dTally, 0), block.GetBlockTime());
-							}
-						}
-						// The following 3 lines are used for PODS (Proof of document storage); allowing persistence of paid documents in IPFS
-						std::string sPK = PubKeyToAddress(block.vtx[n].vout[i].scriptPubKey);
-						if (sPK == consensusParams.FoundationAddress || sPK == consensusParams.FoundationPODSAddress)
-						{
-							dFoundationDonation += dAmount;
-						}
-					}
-					MemorizePrayer(sPrayer, block.GetBlockTime(), dTotalSent, 0, block.vtx[n].GetHash().GetHex(), pindex->nHeight, dFoundationDonation);
-				}
-	  		}
-		}
-		if (fColdBoot) 
-		{
-			// ** Initialize distributed-computing CPID
-			std::string out_address = "";
-			double nMagnitude = 0;
-			std::string sAddress = "";
-			// Race Condition - Reported by Snat21 & Dave_BBP - Rob Andrews - 6/13/2018
-			FindResearcherCPIDByAddress(sAddress, out_address, nMagnitude);
-			mnMagnitude=nMagnitude;
-			// ** End of Initializing distributed-computing CPID
-			fPrayersMemorized = true;
-			if (nMaxDepth > (nDeserializedHeight-1000))
-			{
-				SerializePrayersToFile(nMaxDepth-1);
-			}
-		}
-		if (fSubThread && !fPrayersMemorized) LogPrintf("Finished MemorizeBlockChainPrayers @ %f ",GetAdjustedTime());
+	if (pblocktree->ReadBlockSummary(pindex->GetBlockHash(), summary)) return true;
+	CBlockCache::block_ptr pblock;
+	if (!(pindex->nStatus & BLOCK_HAVE_DATA) || !ReadBlockFromDisk(pblock, pindex, Params().GetConsensus())) return false;
+	summary = CBlockSummary(*pblock);
+	if (!pblocktree->WriteBlockSummary(pindex->GetBlockHash(), summary))
+		LogPrintf("GetBlockSummary: failed to write the summary of %s \n", pindex->GetBlockHash().GetHex().c_str());
+	return true;
 }
 
-
 std::string RetrieveTxOutInfo(const CBlockIndex* pindexLast, int iLookback, int iTxOffset, int ivOutOffset, int iDataType)
 {
 	// When DataType == 1, returns txOut Address
@@ -7745,32 +7786,35 @@ std::string RetrieveTxOutInfo(const CBlockIndex* pindexLast, int iLookback, int
         return "";
     }
 
-    for (int i = 1; i < iLookback; i++) 
-	{
-        if (pindexLast->pprev == NULL) { break; }
-        pindexLast = pindexLast->pprev;
-    }
+	// Step back iLookback - 1 blocks, stopping at the genesis block
+	if (iLookback > 1) pindexLast = pindexLast->GetAncestor(std::max(0, pindexLast->nHeight - (iLookback - 1)));
 	if (iDataType < 1 || iDataType > 3) return "DATA_TYPE_OUT_OF_RANGE";
 
 	if (iDataType == 3) return pindexLast ? pindexLast->GetBlockHash().GetHex() : "";	
 	
-	const Consensus::Params& consensusParams = Params().GetConsensus();
-	CBlock block;
-	if (ReadBlockFromDisk(block, pindexLast, consensusParams, "RetrieveTxOutInfo"))
+	CBlockSummary summary;
+	if (pindexLast && GetBlockSummary(pindexLast, summary))
 	{
-		if (iTxOffset >= (int)block.vtx.size()) iTxOffset=block.vtx.size()-1;
-		if (ivOutOffset >= (int)block.vtx[iTxOffset].vout.size()) ivOutOffset=block.vtx[iTxOffset].vout.size()-1;
-		if (iTxOffset >= 0 && ivOutOffset >= 0)
+		if (iTxOffset >= (int)summary.vTxIds.size()) iTxOffset=summary.vTxIds.size()-1;
+		if (iTxOffset < 0) return "";
+		if (ivOutOffset >= (int)summary.vOutputs[iTxOffset]) ivOutOffset=(int)summary.vOutputs[iTxOffset]-1;
+		if (ivOutOffset >= 0)
 		{
-			if (iDataType == 1)
+			if (iDataType == 1 && ivOutOffset == 0)
 			{
-				std::string sPKAddr = PubKeyToAddress(block.vtx[iTxOffset].vout[ivOutOffset].scriptPubKey);
-				return sPKAddr;
+				const std::vector<unsigned char>& vchScript = summary.vFirstScripts[iTxOffset];
+				return PubKeyToAddress(CScript(vchScript.begin(), vchScript.end()));
+			}
+			else if (iDataType == 1)
+			{
+				// Only first outputs are summarized
+				CBlockCache::block_ptr pblock;
+				if (ReadBlockFromDisk(pblock, pindexLast, Params().GetConsensus()) && iTxOffset < (int)pblock->vtx.size() && ivOutOffset < (int)pblock->vtx[iTxOffset].vout.size())
+					return PubKeyToAddress(pblock->vtx[iTxOffset].vout[ivOutOffset].scriptPubKey);
 			}
 			else if (iDataType == 2)
 			{
-				std::string sTxId = block.vtx[iTxOffset].GetHash().ToString();
-				return sTxId;
+				return summary.vTxIds[iTxOffset].ToString();
 			}
 		}
 	}
@@ -7806,36 +7850,6 @@ bool IsMature(int64_t nTime, int64_t nMaturityAge)
 }
 
 
-struct TxMessage
-{
-  std::string sMessageType;
-  std::string sMessageKey;
-  std::string sMessageValue;
-  std::string sSig;
-  std::string sNonce;
-  std::string sSporkSig;
-  std::string sIPFSHash;
-  std::string sBOSig;
-  std::string sBOSigner;
-  std::string sTimestamp;
-  std::string sIPFSSize;
-  std::string sCPIDSig;
-  std::string sCPID;
-  std::string sPODCTasks;
-  std::string sTxId;
-  std::string sVoteSignal;
-  std::string sVoteHash;
-  double      nNonce;
-  double      dAmount;
-  bool        fNonceValid;
-  bool        fPrayersMustBeSigned;
-  bool        fSporkSigValid;
-  bool        fBOSigValid;
-  bool        fPassedSecurityCheck;
-  int64_t     nAge;
-  int64_t     nTime;
-};
-
 void MemorizeUTXOWeight(TxMessage t, double dAmount)
 {
 	if (t.sPODCTasks.empty()) return;
@@ -7888,24 +7902,25 @@ bool CheckBusinessObjectSig(TxMessage t)
 	return false;
 }
 
-TxMessage GetTxMessage(std::string sMessage, int64_t nTime, int iPosition, std::string sTxId, double dAmount)
+TxMessage ParseTxMessage(const std::string& sMessage, int64_t nTime, int iPosition, const std::string& sTxId, double dAmount)
 {
+	// Pure extraction of the message fields (one scan of the message); safe to run on the memorizer worker threads
+	CTxMessageTags tags(sMessage);
 	TxMessage t;
-	t.sMessageType = ExtractXML(sMessage,"<MT>","</MT>");
-	t.sMessageKey  = ExtractXML(sMessage,"<MK>","</MK>");
-	t.sMessageValue= ExtractXML(sMessage,"<MV>","</MV>");
-	t.sSig         = ExtractXML(sMessage,"<MS>","</MS>");
-	t.sNonce       = ExtractXML(sMessage,"<NONCE>","</NONCE>");
+	t.sMessageType = tags.GetString(CTxMessageTags::TAG_MT);
+	t.sMessageKey  = tags.GetString(CTxMessageTags::TAG_MK);
+	t.sMessageValue= tags.GetString(CTxMessageTags::TAG_MV);
+	t.sSig         = tags.GetString(CTxMessageTags::TAG_MS);
+	t.sNonce       = tags.GetString(CTxMessageTags::TAG_NONCE);
 	t.nNonce       = cdbl(t.sNonce, 0);
-	t.sSporkSig    = ExtractXML(sMessage,"<SPORKSIG>","</SPORKSIG>");
-	t.sIPFSHash    = ExtractXML(sMessage,"<IPFSHASH>", "</IPFSHASH>");
-	t.sBOSig       = ExtractXML(sMessage,"<BOSIG>", "</BOSIG>");
-	t.sBOSigner    = ExtractXML(sMessage,"<BOSIGNER>", "</BOSIGNER>");
-	t.sIPFSHash    = ExtractXML(sMessage,"<ipfshash>", "</ipfshash>");
-	t.sIPFSSize    = ExtractXML(sMessage,"<ipfssize>", "</ipfssize>");
-	t.sCPIDSig     = ExtractXML(sMessage,"<cpidsig>","</cpidsig>");
+	t.sSporkSig    = tags.GetString(CTxMessageTags::TAG_SPORKSIG);
+	t.sBOSig       = tags.GetString(CTxMessageTags::TAG_BOSIG);
+	t.sBOSigner    = tags.GetString(CTxMessageTags::TAG_BOSIGNER);
+	t.sIPFSHash    = tags.GetString(CTxMessageTags::TAG_IPFSHASH);
+	t.sIPFSSize    = tags.GetString(CTxMessageTags::TAG_IPFSSIZE);
+	t.sCPIDSig     = tags.GetString(CTxMessageTags::TAG_CPIDSIG);
 	t.sCPID        = GetElement(t.sCPIDSig, ";", 0);
-	t.sPODCTasks   = ExtractXML(sMessage, "<PODC_TASKS>", "</PODC_TASKS>");
+	t.sPODCTasks   = tags.GetString(CTxMessageTags::TAG_PODC_TASKS);
 	t.sTxId        = sTxId;
 	t.nTime        = nTime;
 	t.dAmount      = dAmount;
@@ -7914,12 +7929,40 @@ TxMessage GetTxMessage(std::string sMessage, int64_t nTime, int iPosition, std::
 	t.sTimestamp = TimestampToHRDate((double)nTime + iPosition);
 	t.fNonceValid = (!(t.nNonce > (nTime+(60 * 60)) || t.nNonce < (nTime-(60 * 60))));
 	t.nAge = GetAdjustedTime() - nTime;
-	t.fPrayersMustBeSigned = (GetSporkDouble("prayersmustbesigned", 0) == 1);
-
 	if (t.sMessageType == "PRAYER" && (!(Contains(t.sMessageKey, "(") ))) t.sMessageKey += " (" + t.sTimestamp + ")";
-	if (t.sMessageType == "SPORK" || (t.sMessageType == "PRAYER" && t.fPrayersMustBeSigned))
+	return t;
+}
+
+void PrecheckTxMessageSignature(TxMessage& t)
+{
+	// Verify the signatures that do not depend on spork state up front, so the worker threads carry the ECDSA cost
+	if (t.sMessageType == "SPORK")
+	{
+		t.fSporkSigValid = CheckSporkSig(t);
+		t.fSigChecked = true;
+	}
+	else if (t.sMessageType == "EXPENSE" || t.sMessageType == "REVENUE")
 	{
+		t.sSporkSig = t.sBOSig;
 		t.fSporkSigValid = CheckSporkSig(t);
+		t.fSigChecked = true;
+	}
+	else if (t.sMessageType != "PRAYER" && t.sMessageType != "ATTACHMENT" && t.sMessageType != "CPIDTASKS" && t.sMessageType != "REPENT" 
+		&& t.sMessageType != "MESSAGE" && t.sMessageType != "DCC")
+	{
+		t.fBOSigValid = CheckBusinessObjectSig(t);
+		t.fSigChecked = true;
+	}
+}
+
+void CheckTxMessage(TxMessage& t)
+{
+	// Runs in block order: depends on sporks memorized by earlier messages and on the current time
+	if (t.sMessageType == "PRAYER") t.fPrayersMustBeSigned = (GetSporkDouble("prayersmustbesigned", 0) == 1);
+
+	if (t.sMessageType == "SPORK" || (t.sMessageType == "PRAYER" && t.fPrayersMustBeSigned))
+	{
+		if (!t.fSigChecked) t.fSporkSigValid = CheckSporkSig(t);
 		if (!t.fSporkSigValid) t.sMessageValue  = "";
 		t.fPassedSecurityCheck = t.fSporkSigValid;
 	}
@@ -7943,14 +7986,14 @@ TxMessage GetTxMessage(std::string sMessage, int64_t nTime, int iPosition, std::
 	}
 	else if (t.sMessageType == "DCC")
 	{
-		if (IsMature(nTime, 14400) && !t.sMessageValue.empty()) WriteCache("MatureDCC", t.sMessageKey, t.sMessageValue, nTime);
+		if (IsMature(t.nTime, 14400) && !t.sMessageValue.empty()) WriteCache("MatureDCC", t.sMessageKey, t.sMessageValue, t.nTime);
 		// These are checked in the memory pool (since we have some unbanked CPIDs who didn't sign the CPID from the wallet)
 		t.fPassedSecurityCheck = true;
 	}
 	else if (t.sMessageType == "EXPENSE" || t.sMessageType == "REVENUE")
 	{
 		t.sSporkSig = t.sBOSig;
-		t.fSporkSigValid = CheckSporkSig(t);
+		if (!t.fSigChecked) t.fSporkSigValid = CheckSporkSig(t);
 		if (!t.fSporkSigValid) 
 		{
 			t.sMessageValue  = "";
@@ -7959,35 +8002,317 @@ TxMessage GetTxMessage(std::string sMessage, int64_t nTime, int iPosition, std::
 	}
 	else if (t.sMessageType == "VOTE")
 	{
-		t.fBOSigValid = CheckBusinessObjectSig(t);
+		if (!t.fSigChecked) t.fBOSigValid = CheckBusinessObjectSig(t);
 		t.fPassedSecurityCheck = t.fBOSigValid;
 	}
 	else
 	{
 		// We assume this is a business object
-		t.fBOSigValid = CheckBusinessObjectSig(t);
+		if (!t.fSigChecked) t.fBOSigValid = CheckBusinessObjectSig(t);
 		if (!t.fBOSigValid) t.sMessageValue = "";
 		t.fPassedSecurityCheck = t.fBOSigValid;
 	}
+}
+
+TxMessage GetTxMessage(std::string sMessage, int64_t nTime, int iPosition, std::string sTxId, double dAmount)
+{
+	TxMessage t = ParseTxMessage(sMessage, nTime, iPosition, sTxId, dAmount);
+	CheckTxMessage(t);
+	return t;
+}
+
+TxMessage GetParsedTxMessage(const CTransaction& tx, int64_t nTime)
+{
+	// The message is covered by the txid, so the parse and the spork independent signature checks can be shared by txid
+	TxMessage t;
+	const uint256& hash = tx.GetHash();
+	if (txMessageCache.Get(hash, nTime, t))
+	{
+		t.nAge = GetAdjustedTime() - nTime;
+		return t;
+	}
+	std::string sMessage = "";
+	double dTotalSent = 0;
+	for (unsigned int i = 0; i < tx.vout.size(); i++)
+	{
+		sMessage += tx.vout[i].sTxOutMessage;
+		dTotalSent += tx.vout[i].nValue / COIN;
+	}
+	t = ParseTxMessage(sMessage, nTime, 0, hash.GetHex(), dTotalSent);
+	if (sMessage.empty()) return t;
+	PrecheckTxMessageSignature(t);
+	txMessageCache.Put(hash, t);
 	return t;
 }
 
+void MemorizeTxMessage(const TxMessage& t, int nHeight, double dFoundationDonation)
+{
+	if (!t.sIPFSHash.empty())
+	{
+		WriteCache("IPFS", t.sIPFSHash, RoundToString(nHeight, 0), t.nTime, false);
+		CIPFSFeeRecord fee(t.nTime, (int64_t)cdbl(RoundToString(dFoundationDonation, 0), 0), (int64_t)cdbl(t.sIPFSSize, 0));
+		WriteCache("IPFSFEE", t.sIPFSHash, fee.ToString(), t.nTime);
+	}
+	MemorizeUTXOWeight(t, t.dAmount);
+	if (t.fPassedSecurityCheck && !t.sMessageType.empty() && !t.sMessageKey.empty() && !t.sMessageValue.empty())
+	{
+		WriteCache(t.sMessageType, t.sMessageKey, t.sMessageValue, t.nTime);
+	}
+}
 
 void MemorizePrayer(std::string sMessage, int64_t nTime, double dAmount, int iPosition, std::string sTxID, int nHeight, double dFoundationDonation)
 {
 	if (sMessage.empty()) return;
 	TxMessage t = GetTxMessage(sMessage, nTime, iPosition, sTxID, dAmount);
-	if (!t.sIPFSHash.empty())
+	MemorizeTxMessage(t, nHeight, dFoundationDonation);
+}
+
+/** Maximum number of threads reading and parsing blocks for the prayer memorizer */
+static const int MAX_MEMORIZE_THREADS = 8;
+/** Blocks handed to the memorizer workers at a time; bounds the memory held by parsed, not yet applied blocks */
+static const unsigned int MEMORIZE_BATCH_SIZE = 1000;
+/** Below this many blocks the memorizer works on the calling thread */
+static const unsigned int MEMORIZE_PARALLEL_MIN = 16;
+
+/** A transaction of a block being memorized, digested by a worker thread */
+struct MemorizedTx
+{
+	bool fMessage;
+	TxMessage t;
+	double dFoundationDonation;
+	std::vector<std::pair<std::string, double> > vAddressPayments;
+};
+
+struct MemorizedBlock
+{
+	const CBlockIndex* pindex;
+	bool fRead;
+	int64_t nTime;
+	std::vector<MemorizedTx> vTx;
+
+	MemorizedBlock(const CBlockIndex* pindexIn) : pindex(pindexIn), fRead(false), nTime(0) {}
+};
+
+void ReadMemorizedBlock(MemorizedBlock& mb, const Consensus::Params& consensusParams)
+{
+	CBlockCache::block_ptr pblock;
+	if (!ReadBlockFromDisk(pblock, mb.pindex, consensusParams, BLOCK_READ_SKIP_POW)) return;
+	const CBlock& block = *pblock;
+	mb.nTime = block.GetBlockTime();
+	int nHeight = mb.pindex->nHeight;
+	// As of F14000, we no longer need to tally cancer payments by public key, remove this to respect anonymity
+	bool fTallyAddressPayments = !(fDistributedComputingEnabled && ((nHeight > F14000_CUTOVER_HEIGHT_PROD && fProd)  ||  (nHeight > F14000_CUTOVER_HEIGHT_TESTNET && !fProd)));
+	mb.vTx.resize(block.vtx.size());
+	for (unsigned int n = 0; n < block.vtx.size(); n++)
 	{
-		WriteCache("IPFS", t.sIPFSHash, RoundToString(nHeight, 0), nTime, false);
-		WriteCache("IPFSFEE" + RoundToString(nTime, 0), t.sIPFSHash, RoundToString(dFoundationDonation, 0), nTime);
-		WriteCache("IPFSSIZE" + RoundToString(nTime, 0), t.sIPFSHash, t.sIPFSSize, nTime);
+		MemorizedTx& mtx = mb.vTx[n];
+		mtx.fMessage = false;
+		mtx.dFoundationDonation = 0;
+		for (unsigned int i = 0; i < block.vtx[n].vout.size(); i++)
+		{
+			if (!block.vtx[n].vout[i].sTxOutMessage.empty()) mtx.fMessage = true;
+			double dAmount = block.vtx[n].vout[i].nValue / COIN;
+			std::string sPK = PubKeyToAddress(block.vtx[n].vout[i].scriptPubKey);
+			if (fTallyAddressPayments && n==0 && i > 0 && block.vtx[n].vout.size() > 4)
+			{
+				mtx.vAddressPayments.push_back(std::make_pair(sPK, dAmount));
+			}
+			// The following 3 lines are used for PODS (Proof of document storage); allowing persistence of paid documents in IPFS
+			if (sPK == consensusParams.FoundationAddress || sPK == consensusParams.FoundationPODSAddress)
+			{
+				mtx.dFoundationDonation += dAmount;
+			}
+		}
+		if (mtx.fMessage) mtx.t = GetParsedTxMessage(block.vtx[n], mb.nTime);
 	}
-	MemorizeUTXOWeight(t, dAmount);
-	if (t.fPassedSecurityCheck && !t.sMessageType.empty() && !t.sMessageKey.empty() && !t.sMessageValue.empty())
+	mb.fRead = true;
+}
+
+void ThreadReadMemorizedBlocks(std::vector<MemorizedBlock>* pvBlocks, int nWorker, int nWorkers, const Consensus::Params* pConsensusParams)
+{
+	// Each worker owns every nWorkers'th slot, so no two threads touch the same block
+	for (unsigned int i = nWorker; i < pvBlocks->size(); i += nWorkers)
+	{
+		MemorizedBlock& mb = (*pvBlocks)[i];
+		try
+		{
+			ReadMemorizedBlock(mb, *pConsensusParams);
+		}
+		catch (const std::exception& e)
+		{
+			mb.fRead = false;
+			LogPrintf("ReadMemorizedBlock: error %s at height %d\n", e.what(), mb.pindex->nHeight);
+		}
+	}
+}
+
+void ReadMemorizedBlocks(std::vector<MemorizedBlock>& vBlocks, const Consensus::Params& consensusParams)
+{
+	int nWorkers = std::max(1, std::min(GetNumCores(), MAX_MEMORIZE_THREADS));
+	if (nWorkers == 1 || vBlocks.size() < MEMORIZE_PARALLEL_MIN)
+	{
+		ThreadReadMemorizedBlocks(&vBlocks, 0, 1, &consensusParams);
+		return;
+	}
+	boost::thread_group workers;
+	for (int i = 1; i < nWorkers; i++)
+		workers.create_thread(boost::bind(&ThreadReadMemorizedBlocks, &vBlocks, i, nWorkers, &consensusParams));
+	ThreadReadMemorizedBlocks(&vBlocks, 0, nWorkers, &consensusParams);
+	workers.join_all();
+}
+
+void ApplyMemorizedBlock(MemorizedBlock& mb, int64_t nMaxPaymentAge)
+{
+	for (unsigned int n = 0; n < mb.vTx.size(); n++)
+	{
+		MemorizedTx& mtx = mb.vTx[n];
+		for (unsigned int i = 0; i < mtx.vAddressPayments.size(); i++)
+		{
+			const std::string& sRecipient = mtx.vAddressPayments[i].first;
+			double dTally = cdbl(ReadCacheWithMaxAge("AddressPayment", sRecipient, nMaxPaymentAge), 0) + mtx.vAddressPayments[i].second;
+			WriteCache("AddressPayment", sRecipient, RoundToString(dTally, 0), mb.nTime);
+		}
+		if (mtx.fMessage)
+		{
+			CheckTxMessage(mtx.t);
+			MemorizeTxMessage(mtx.t, mb.pindex->nHeight, mtx.dFoundationDonation);
+		}
+	}
+}
+
+// The memorizer watermark lives in the application cache, so it is persisted in the same snapshot as the data it describes:
+// HEIGHT/HASH is the last block memorized, MATUREHEIGHT the last block below which every block was memorized once mature
+void ReadMemorizedWatermark(int& nMemorized, int& nMature)
+{
+	CAppCacheEntry entry;
+	nMemorized = appCache.Read("MEMORIZED", "HEIGHT", entry) ? atoi(entry.sValue) : -1;
+	nMature = appCache.Read("MEMORIZED", "MATUREHEIGHT", entry) ? atoi(entry.sValue) : -1;
+	if (nMemorized >= 0)
 	{
-		WriteCache(t.sMessageType, t.sMessageKey, t.sMessageValue, nTime);
+		uint256 hashMemorized = uint256S(appCache.ReadValue("MEMORIZED", "HASH"));
+		const CBlockIndex* pindex = chainActive[nMemorized];
+		if (!pindex || pindex->GetBlockHash() != hashMemorized)
+		{
+			// Reorganized (or the chain was erased): resume from the fork point
+			BlockMap::iterator mi = mapBlockIndex.find(hashMemorized);
+			const CBlockIndex* pfork = (mi != mapBlockIndex.end() && mi->second) ? chainActive.FindFork(mi->second) : NULL;
+			LogPrintf("MemorizeBlockChainPrayers: block %d %s is no longer in the active chain, resuming from %d \n", nMemorized, hashMemorized.GetHex(), pfork ? pfork->nHeight : -1);
+			nMemorized = pfork ? pfork->nHeight : -1;
+		}
 	}
+	if (nMature > nMemorized) nMature = nMemorized;
+}
+
+void WriteMemorizedWatermark(const CBlockIndex* pindexMemorized, int nMature)
+{
+	if (!pindexMemorized) return;
+	int64_t nTime = pindexMemorized->GetBlockTime();
+	WriteCache("MEMORIZED", "HEIGHT", RoundToString(pindexMemorized->nHeight, 0), nTime);
+	WriteCache("MEMORIZED", "HASH", pindexMemorized->GetBlockHash().GetHex(), nTime);
+	WriteCache("MEMORIZED", "MATUREHEIGHT", RoundToString(nMature, 0), nTime);
+}
+
+void MemorizeBlockChainPrayers(bool fDuringConnectBlock, bool fSubThread, bool fColdBoot, bool fDuringSanctuaryQuorum)
+{
+		// The worker threads read mapBlockIndex and the block files; keep the chain still while they run
+		LOCK(cs_main);
+		if (!chainActive.Tip()) return;
+		int nDeserializedHeight = 0;
+		if (fColdBoot)
+		{
+			nDeserializedHeight = DeserializePrayersFromFile();
+			if (chainActive.Tip()->nHeight < nDeserializedHeight && nDeserializedHeight > 0) nDeserializedHeight=0;
+		}
+
+		int nMaxDepth = chainActive.Tip()->nHeight;
+		int nMinDepth = fDuringConnectBlock ? nMaxDepth - 2 : nMaxDepth - (BLOCKS_PER_DAY * 30 * 12);  // One year
+		if (fDuringSanctuaryQuorum) nMinDepth = nMaxDepth - (BLOCKS_PER_DAY * 14); // Two Weeks
+
+		if (nDeserializedHeight > 0 && nDeserializedHeight < nMaxDepth) nMinDepth = nDeserializedHeight;
+
+		if (nMinDepth < 0) nMinDepth = 0;
+
+		// Only visit blocks we have not seen: after the last memorized block, or for the quorum, after the last block memorized once mature
+		// (mature DCCs and UTXO weights are only recorded when the message is 4 hours old at memorization time)
+		// An explicit 'memorizeprayers' rescans the whole window
+		int nMemorized = -1;
+		int nMature = -1;
+		ReadMemorizedWatermark(nMemorized, nMature);
+		int nStart = nMinDepth;
+		if (fDuringConnectBlock || fColdBoot || fDuringSanctuaryQuorum)
+		{
+			int nResume = fDuringSanctuaryQuorum ? nMature : nMemorized;
+			if (nResume > nStart && nResume <= nMaxDepth) nStart = nResume;
+		}
+		if (nStart == nMinDepth)
+		{
+			// Blocks older than the window are never memorized, so the window edge counts as seen
+			if (nMemorized < nStart) nMemorized = nStart;
+			if (nMature < nStart && (fDuringSanctuaryQuorum || (!fDuringConnectBlock && nDeserializedHeight == 0))) nMature = nStart;
+		}
+		int nMemorizedBefore = nMemorized;
+		int nMatureBefore = nMature;
+
+		const CBlockIndex* pindex = chainActive[nStart];
+		const Consensus::Params& consensusParams = Params().GetConsensus();
+		if (fSubThread && !fPrayersMemorized) LogPrintf("MemorizeBlockChainPrayers @ %f ",GetAdjustedTime());
+		int64_t nMaxPaymentAge = 60 * 60 * 24 * 7;
+		int64_t nTimeStart = GetTimeMillis();
+		int nBlocks = 0;
+		bool fGap = false;
+		boost::scoped_ptr<CBlockFileScan> pscan;
+		if (nMaxDepth - nStart > (int)MEMORIZE_BATCH_SIZE) pscan.reset(new CBlockFileScan());
+		while (pindex && pindex->nHeight < nMaxDepth)
+		{
+			// Read and parse a batch of blocks on the worker pool, then apply them strictly in height order
+			std::vector<MemorizedBlock> vBlocks;
+			vBlocks.reserve(std::min((int)MEMORIZE_BATCH_SIZE, nMaxDepth - pindex->nHeight));
+			while (pindex && pindex->nHeight < nMaxDepth && vBlocks.size() < MEMORIZE_BATCH_SIZE)
+			{
+				pindex = chainActive.Next(pindex);
+				if (pindex) vBlocks.push_back(MemorizedBlock(pindex));
+			}
+			ReadMemorizedBlocks(vBlocks, consensusParams);
+			for (unsigned int i = 0; i < vBlocks.size(); i++)
+			{
+				MemorizedBlock& mb = vBlocks[i];
+				int nHeight = mb.pindex->nHeight;
+				if (mb.fRead)
+				{
+					ApplyMemorizedBlock(mb, nMaxPaymentAge);
+				}
+				else
+				{
+					// An unreadable block holds the watermark back, so the next pass retries it
+					fGap = true;
+				}
+				if (!fGap && nHeight == nMemorized + 1) nMemorized = nHeight;
+				if (!fGap && nHeight == nMature + 1 && IsMature(mb.pindex->GetBlockTime(), 14400)) nMature = nHeight;
+			}
+			nBlocks += vBlocks.size();
+		}
+		if (nMemorized != nMemorizedBefore || nMature != nMatureBefore) WriteMemorizedWatermark(chainActive[nMemorized], nMature);
+		if (nBlocks > 1) LogPrint("memorize", "MemorizeBlockChainPrayers: memorized %d blocks from %d to %d (mature through %d) %dms\n", nBlocks, nStart + 1, nMaxDepth, nMature, GetTimeMillis() - nTimeStart);
+
+		// Persist this block's cache changes as a small delta rather than rewriting the prayer snapshot
+		if (fDuringConnectBlock && fPrayersMemorized) SerializePrayersToFile(nMaxDepth);
+		if (fColdBoot) 
+		{
+			// ** Initialize distributed-computing CPID
+			std::string out_address = "";
+			double nMagnitude = 0;
+			std::string sAddress = "";
+			// Race Condition - Reported by Snat21 & Dave_BBP - Rob Andrews - 6/13/2018
+			FindResearcherCPIDByAddress(sAddress, out_address, nMagnitude);
+			mnMagnitude=nMagnitude;
+			// ** End of Initializing distributed-computing CPID
+			fPrayersMemorized = true;
+			if (nMaxDepth > (nDeserializedHeight-1000))
+			{
+				SerializePrayersToFile(nMaxDepth-1);
+			}
+		}
+		if (fSubThread && !fPrayersMemorized) LogPrintf("Finished MemorizeBlockChainPrayers @ %f ",GetAdjustedTime());
 }
 
 
@@ -8481,36 +8806,19 @@ CAmount GetRetirementAccountContributionAmount(int nPrevHeight)
 std::string ReadCacheWithMaxAge(std::string sSection, std::string sKey, int64_t nMaxAge)
 {
 	// This allows us to disregard old cache messages
-	std::string sValue = ReadCache(sSection, sKey);
-	std::string sFullKey = sSection + ";" + sKey;
-	boost::to_upper(sFullKey);
-	int64_t nTime = mvApplicationCacheTimestamp[sFullKey];
-	if (nTime==0)
-	{
-		// LogPrintf(" ReadCacheWithMaxAge key %s timestamp 0 \n",sFullKey);
-	}
-	int64_t nAge = GetAdjustedTime() - nTime;
+	boost::to_upper(sSection);
+	boost::to_upper(sKey);
+	CAppCacheEntry entry;
+	if (sSection.empty() || sKey.empty() || !appCache.Read(sSection, sKey, entry)) return "";
+	int64_t nAge = GetAdjustedTime() - entry.nTimestamp;
 	if (nAge > nMaxAge) return "";
-	return sValue;
+	return entry.sValue;
 }
 
 
 void ClearCache(std::string sSection)
 {
-	boost::to_upper(sSection);
-	for(map<string,string>::iterator ii=mvApplicationCache.begin(); ii!=mvApplicationCache.end(); ++ii)
-	{
-		std::string sKey = (*ii).first;
-		boost::to_upper(sKey);
-		if (sKey.length() > sSection.length())
-		{
-			if (sKey.substr(0,sSection.length())==sSection)
-			{
-				mvApplicationCache[sKey]="";
-				mvApplicationCacheTimestamp[sKey]=0;
-			}
-		}
-	}
+	appCache.ClearSection(sSection);
 }
 
 
@@ -8521,22 +8829,7 @@ std::string ReadCache(std::string sSection, std::string sKey)
 	boost::to_upper(sKey);
 	
 	if (sSection.empty() || sKey.empty()) return "";
-	try
-	{
-		std::string sValue = mvApplicationCache[sSection + ";" + sKey];
-		if (sValue.empty())
-		{
-			mvApplicationCache.insert(map<std::string,std::string>::value_type(sSection + ";" + sKey,""));
-			mvApplicationCache[sSection + ";" + sKey]="";
-			return "";
-		}
-		return sValue;
-	}
-	catch(...)
-	{
-		LogPrintf("ReadCache error %s",sSection.c_str());
-		return "";
-	}
+	return appCache.ReadValue(sSection, sKey);
 }
 
 
@@ -19,6 +19,7 @@
 #include "sync.h"
 #include "versionbits.h"
 #include "spentindex.h"
+#include "keyset.h"
 #include <algorithm>
 #include <exception>
 #include <map>
@@ -27,11 +28,13 @@
 #include <string>
 #include <utility>
 #include <vector>
+#include <boost/shared_ptr.hpp>
 #include <boost/unordered_map.hpp>
 #include "support/allocators/secure.h"
 #include <univalue.h>
 
 class CBlockIndex;
+class CBibleHashDB;
 class CBlockTreeDB;
 class CBloomFilter;
 class CChainParams;
@@ -142,6 +145,7 @@ static const bool DEFAULT_TXINDEX = true;
 static const bool DEFAULT_ADDRESSINDEX = false;
 static const bool DEFAULT_TIMESTAMPINDEX = false;
 static const bool DEFAULT_SPENTINDEX = false;
+static const bool DEFAULT_BLOCKSUMMARYINDEX = false;
 static const unsigned int DEFAULT_BANSCORE_THRESHOLD = 100;
 
 static const bool DEFAULT_TESTSAFEMODE = false;
@@ -189,9 +193,6 @@ extern CTxMemPool mempool;
 typedef boost::unordered_map<uint256, CBlockIndex*, BlockHasher> BlockMap;
 extern CBlock cblockGenesis;
 
-extern std::map<std::string, std::string> mvApplicationCache;
-extern std::map<std::string, int64_t> mvApplicationCacheTimestamp;
-
 extern std::map<int64_t, std::string> mapDebug;
 
 extern BlockMap mapBlockIndex;
@@ -215,6 +216,7 @@ extern bool fProofOfLoyaltyEnabled;
 extern unsigned int nBytesPerSigOp;
 extern bool fCheckBlockIndex;
 extern bool fCheckpointsEnabled;
+extern bool fBlockSummaryIndex;
 extern size_t nCoinCacheUsage;
 extern CFeeRate minRelayTxFee;
 extern bool fAlerts;
@@ -501,6 +503,81 @@ struct CTimestampIndexKey {
     }
 };
 
+/** What a DC superblock paid, as kept in the superblock payment index (keyed by height) */
+struct CSuperblockPayments {
+    uint256 hashBlock;
+    int64_t nTime;
+    CAmount nBudget;
+    //! Recipient address and amount of each coinbase output after the first, in output order
+    std::vector<std::pair<std::string, CAmount> > vPayments;
+    //! The recipient addresses decoded, in the same order (not serialized; see DecodeAddresses)
+    std::vector<CAddressKey> vPaymentKeys;
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action, int nType, int nVersion) {
+        READWRITE(hashBlock);
+        READWRITE(nTime);
+        READWRITE(nBudget);
+        READWRITE(vPayments);
+    }
+
+    CSuperblockPayments() {
+        SetNull();
+    }
+
+    void SetNull() {
+        hashBlock.SetNull();
+        nTime = 0;
+        nBudget = 0;
+        vPayments.clear();
+        vPaymentKeys.clear();
+    }
+
+    void DecodeAddresses() {
+        vPaymentKeys.clear();
+        vPaymentKeys.reserve(vPayments.size());
+        for (unsigned int i = 0; i < vPayments.size(); i++)
+            vPaymentKeys.push_back(CAddressKey(vPayments[i].first));
+    }
+};
+
+/**
+ * Each transaction's id, output count and first output script, as kept in the
+ * block summary index (keyed by block hash) so historical transaction lookups
+ * need not read the whole block.
+ */
+struct CBlockSummary {
+    std::vector<uint256> vTxIds;
+    std::vector<unsigned int> vOutputs;
+    //! Script bytes of each first output (empty if it has none)
+    std::vector<std::vector<unsigned char> > vFirstScripts;
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action, int nType, int nVersion) {
+        READWRITE(vTxIds);
+        READWRITE(vOutputs);
+        READWRITE(vFirstScripts);
+    }
+
+    CBlockSummary() {}
+
+    explicit CBlockSummary(const CBlock& block) {
+        vTxIds.reserve(block.vtx.size());
+        vOutputs.reserve(block.vtx.size());
+        vFirstScripts.reserve(block.vtx.size());
+        for (unsigned int i = 0; i < block.vtx.size(); i++) {
+            vTxIds.push_back(block.vtx[i].GetHash());
+            vOutputs.push_back(block.vtx[i].vout.size());
+            const CScript& script = block.vtx[i].vout.empty() ? CScript() : block.vtx[i].vout[0].scriptPubKey;
+            vFirstScripts.push_back(std::vector<unsigned char>(script.begin(), script.end()));
+        }
+    }
+};
+
 struct CAddressUnspentKey {
     unsigned int type;
     uint160 hashBytes;
@@ -851,10 +928,29 @@ bool GetAddressIndex(uint160 addressHash, int type,
 bool GetAddressUnspent(uint160 addressHash, int type,
                        std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > &unspentOutputs);
 
+/** Loads the superblock payment index, dropping entries off the active chain and adding the superblocks it lacks */
+bool LoadSuperblockPaymentIndex(const Consensus::Params& consensusParams);
+/** The payments of the DC superblock at nHeight on the active chain */
+bool GetSuperblockPayments(int nHeight, CSuperblockPayments &payments);
+/** Heights of the indexed DC superblocks at or below nMaxHeight, newest first */
+std::vector<int> GetSuperblockPaymentHeights(int nMaxHeight);
+/** Total paid to any of setAddresses by the DC superblocks timed strictly between nStartTime and nEndTime */
+CAmount GetSuperblockPaymentsToAddresses(const CAddressSet &setAddresses, int64_t nStartTime, int64_t nEndTime, int &nSuperblocks);
+
+/** What ReadBlockFromDisk checks besides the block deserializing (and, read by index, hashing to its index entry) */
+enum BlockReadPolicy {
+    //! Recheck the proof of work, unless the block index holds the block as script validated already
+    BLOCK_READ_CHECK_POW,
+    //! Never check the proof of work (blocks served to peers, disconnected, or scanned for messages)
+    BLOCK_READ_SKIP_POW,
+};
+
 /** Functions for disk access for blocks */
 bool WriteBlockToDisk(const CBlock& block, CDiskBlockPos& pos, const CMessageHeader::MessageStartChars& messageStart);
-bool ReadBlockFromDisk(CBlock& block, const CDiskBlockPos& pos, const Consensus::Params& consensusParams, std::string Context);
-bool ReadBlockFromDisk(CBlock& block, const CBlockIndex* pindex, const Consensus::Params& consensusParams, std::string Context);
+bool ReadBlockFromDisk(CBlock& block, const CDiskBlockPos& pos, const Consensus::Params& consensusParams, BlockReadPolicy policy = BLOCK_READ_CHECK_POW);
+bool ReadBlockFromDisk(CBlock& block, const CBlockIndex* pindex, const Consensus::Params& consensusParams, BlockReadPolicy policy = BLOCK_READ_CHECK_POW);
+/** Read a block by index, sharing the block cache's copy rather than copying it (for readers that only look at the block) */
+bool ReadBlockFromDisk(boost::shared_ptr<const CBlock>& pblockRet, const CBlockIndex* pindex, const Consensus::Params& consensusParams, BlockReadPolicy policy = BLOCK_READ_CHECK_POW);
 
 /** Functions for validating blocks and updating the block tree */
 
@@ -961,12 +1057,21 @@ bool ReconsiderBlock(CValidationState& state, CBlockIndex *pindex);
 /** The currently-connected chain of blocks (protected by cs_main). */
 extern CChain chainActive;
 
+/** The block at nHeight on chainActive, or NULL if the chain is not that high. Takes cs_main. */
+CBlockIndex* FindBlockByHeight(int nHeight);
+
+/** The ancestor of pindexFrom at nHeight (pindexFrom itself at its own height), or NULL if there is none. */
+CBlockIndex* FindBlockByHeight(int nHeight, CBlockIndex* pindexFrom);
+
 /** Global variable that points to the active CCoinsView (protected by cs_main) */
 extern CCoinsViewCache *pcoinsTip;
 
 /** Global variable that points to the active block tree (protected by cs_main) */
 extern CBlockTreeDB *pblocktree;
 
+/** Global variable that points to the validated BibleHash store (thread safe, may be NULL) */
+extern CBibleHashDB *pbiblehashdb;
+
 /**
  * Return the spend height, which is one more than the inputs.GetBestBlock().
  * While checking, GetBestBlock() refers to the parent block. (protected by cs_main)
@@ -146,11 +146,19 @@ bool CMasternode::UpdateFromNewBroadcast(CMasternodeBroadcast& mnb)
 //
 arith_uint256 CMasternode::CalculateScore(const uint256& blockHash)
 {
-    uint256 aux = ArithToUint256(UintToArith256(vin.prevout.hash) + vin.prevout.n);
+    return CalculateScore(blockHash, CalculateBlockScore(blockHash));
+}
 
+arith_uint256 CMasternode::CalculateBlockScore(const uint256& blockHash)
+{
     CHashWriter ss(SER_GETHASH, PROTOCOL_VERSION);
     ss << blockHash;
-    arith_uint256 hash2 = UintToArith256(ss.GetHash());
+    return UintToArith256(ss.GetHash());
+}
+
+arith_uint256 CMasternode::CalculateScore(const uint256& blockHash, const arith_uint256& hash2) const
+{
+    uint256 aux = ArithToUint256(UintToArith256(vin.prevout.hash) + vin.prevout.n);
 
     CHashWriter ss2(SER_GETHASH, PROTOCOL_VERSION);
     ss2 << blockHash;
@@ -373,7 +381,7 @@ void CMasternode::UpdateLastPaid(const CBlockIndex *pindex, int nMaxBlocksToScan
             mnpayments.mapMasternodeBlocks[BlockReading->nHeight].HasPayeeWithVotes(mnpayee, 2))
         {
             CBlock block;
-            if(!ReadBlockFromDisk(block, BlockReading, Params().GetConsensus(), "UPDATELASTPAID")) // shouldn't really happen
+            if(!ReadBlockFromDisk(block, BlockReading, Params().GetConsensus())) // shouldn't really happen
                 continue;
 			CAmount nCollateral = mnpayments.mapMasternodeBlocks[BlockReading->nHeight].GetTxSanctuaryCollateral(block.vtx[0]);
 	        CAmount nMasternodePayment = GetMasternodePayment(BlockReading->nHeight, block.vtx[0].GetValueOut(), nCollateral);
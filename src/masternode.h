@@ -241,6 +241,9 @@ public:
 
     // CALCULATE A RANK AGAINST OF GIVEN BLOCK
     arith_uint256 CalculateScore(const uint256& blockHash);
+    /// Same as above, with the part that only depends on the block taken from CalculateBlockScore(blockHash)
+    arith_uint256 CalculateScore(const uint256& blockHash, const arith_uint256& hashBlockScore) const;
+    static arith_uint256 CalculateBlockScore(const uint256& blockHash);
 
     bool UpdateFromNewBroadcast(CMasternodeBroadcast& mnb);
 
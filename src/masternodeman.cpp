@@ -120,6 +120,7 @@ CMasternodeMan::CMasternodeMan()
   fMasternodesRemoved(false),
   vecDirtyGovernanceObjectHashes(),
   nLastWatchdogVoteTime(0),
+  mapMasternodeScores(),
   mapSeenMasternodeBroadcast(),
   mapSeenMasternodePing(),
   nDsqCount(0)
@@ -134,6 +135,7 @@ bool CMasternodeMan::Add(CMasternode &mn)
         LogPrint("masternode", "CMasternodeMan::Add -- Adding new Masternode: addr=%s, %i now\n", mn.addr.ToString(), size() + 1);
         vMasternodes.push_back(mn);
         indexMasternodes.AddMasternodeVIN(mn.vin);
+        mapMasternodeScores.clear();
         fMasternodesAdded = true;
         return true;
     }
@@ -226,6 +228,7 @@ void CMasternodeMan::CheckAndRemove()
                 // and finally remove it from the list
                 it->FlagGovernanceItemsAsDirty();
                 it = vMasternodes.erase(it);
+                mapMasternodeScores.clear();
                 fMasternodesRemoved = true;
             } else {
                 bool fAsk = pCurrentBlockIndex &&
@@ -395,6 +398,7 @@ void CMasternodeMan::Clear()
     nLastWatchdogVoteTime = 0;
     indexMasternodes.Clear();
     indexMasternodesOld.Clear();
+    mapMasternodeScores.clear();
 }
 
 int CMasternodeMan::CountMasternodes(int nProtocolVersion)
@@ -642,8 +646,9 @@ CMasternode* CMasternodeMan::GetNextMasternodeInQueueForPayment(int nBlockHeight
     int nTenthNetwork = nMnCount/10;
     int nCountTenth = 0;
     arith_uint256 nHighest = 0;
+    arith_uint256 hashBlockScore = CMasternode::CalculateBlockScore(blockHash);
     BOOST_FOREACH (PAIRTYPE(int, CMasternode*)& s, vecMasternodeLastPaid){
-        arith_uint256 nScore = s.second->CalculateScore(blockHash);
+        arith_uint256 nScore = s.second->CalculateScore(blockHash, hashBlockScore);
         if(nScore > nHighest){
             nHighest = nScore;
             pBestMasternode = s.second;
@@ -697,18 +702,47 @@ CMasternode* CMasternodeMan::FindRandomNotInVec(const std::vector<CTxIn> &vecToE
     return NULL;
 }
 
-int CMasternodeMan::GetMasternodeRank(const CTxIn& vin, int nBlockHeight, int nMinProtocol, bool fOnlyActive)
+const std::vector<std::pair<int64_t, int> >& CMasternodeMan::GetMasternodeScores(const uint256& blockHash)
 {
+    AssertLockHeld(cs);
+
+    std::map<uint256, std::vector<std::pair<int64_t, int> > >::iterator it = mapMasternodeScores.find(blockHash);
+    if(it != mapMasternodeScores.end()) return it->second;
+
+    // Scores only depend on the block and the collateral, so the whole list is ranked once
+    // and callers skip the entries their filter rejects; the order among the rest is unchanged
     std::vector<std::pair<int64_t, CMasternode*> > vecMasternodeScores;
+    vecMasternodeScores.reserve(vMasternodes.size());
+    arith_uint256 hashBlockScore = CMasternode::CalculateBlockScore(blockHash);
+    BOOST_FOREACH(CMasternode& mn, vMasternodes) {
+        int64_t nScore = mn.CalculateScore(blockHash, hashBlockScore).GetCompact(false);
+        vecMasternodeScores.push_back(std::make_pair(nScore, &mn));
+    }
 
+    sort(vecMasternodeScores.rbegin(), vecMasternodeScores.rend(), CompareScoreMN());
+
+    if((int)mapMasternodeScores.size() >= MAX_SCORE_CACHE_BLOCKS) mapMasternodeScores.clear();
+    std::vector<std::pair<int64_t, int> >& vecScores = mapMasternodeScores[blockHash];
+    vecScores.reserve(vecMasternodeScores.size());
+    BOOST_FOREACH (PAIRTYPE(int64_t, CMasternode*)& s, vecMasternodeScores) {
+        vecScores.push_back(std::make_pair(s.first, (int)(s.second - &vMasternodes[0])));
+    }
+    return vecScores;
+}
+
+int CMasternodeMan::GetMasternodeRank(const CTxIn& vin, int nBlockHeight, int nMinProtocol, bool fOnlyActive)
+{
     //make sure we know about this block
     uint256 blockHash = uint256();
     if(!GetBlockHash(blockHash, nBlockHeight)) return -1;
 
     LOCK(cs);
 
-    // scan for winner
-    BOOST_FOREACH(CMasternode& mn, vMasternodes) {
+    const std::vector<std::pair<int64_t, int> >& vecScores = GetMasternodeScores(blockHash);
+
+    int nRank = 0;
+    BOOST_FOREACH (const PAIRTYPE(int64_t, int)& s, vecScores) {
+        CMasternode& mn = vMasternodes[s.second];
         if(mn.nProtocolVersion < nMinProtocol) continue;
         if(fOnlyActive) {
             if(!mn.IsEnabled()) continue;
@@ -716,17 +750,8 @@ int CMasternodeMan::GetMasternodeRank(const CTxIn& vin, int nBlockHeight, int nM
         else {
             if(!mn.IsValidForPayment()) continue;
         }
-        int64_t nScore = mn.CalculateScore(blockHash).GetCompact(false);
-
-        vecMasternodeScores.push_back(std::make_pair(nScore, &mn));
-    }
-
-    sort(vecMasternodeScores.rbegin(), vecMasternodeScores.rend(), CompareScoreMN());
-
-    int nRank = 0;
-    BOOST_FOREACH (PAIRTYPE(int64_t, CMasternode*)& scorePair, vecMasternodeScores) {
         nRank++;
-        if(scorePair.second->vin.prevout == vin.prevout) return nRank;
+        if(mn.vin.prevout == vin.prevout) return nRank;
     }
 
     return -1;
@@ -734,7 +759,6 @@ int CMasternodeMan::GetMasternodeRank(const CTxIn& vin, int nBlockHeight, int nM
 
 std::vector<std::pair<int, CMasternode> > CMasternodeMan::GetMasternodeRanks(int nBlockHeight, int nMinProtocol)
 {
-    std::vector<std::pair<int64_t, CMasternode*> > vecMasternodeScores;
     std::vector<std::pair<int, CMasternode> > vecMasternodeRanks;
 
     //make sure we know about this block
@@ -743,22 +767,14 @@ std::vector<std::pair<int, CMasternode> > CMasternodeMan::GetMasternodeRanks(int
 
     LOCK(cs);
 
-    // scan for winner
-    BOOST_FOREACH(CMasternode& mn, vMasternodes) {
-
-        if(mn.nProtocolVersion < nMinProtocol || !mn.IsEnabled()) continue;
-
-        int64_t nScore = mn.CalculateScore(blockHash).GetCompact(false);
-
-        vecMasternodeScores.push_back(std::make_pair(nScore, &mn));
-    }
-
-    sort(vecMasternodeScores.rbegin(), vecMasternodeScores.rend(), CompareScoreMN());
+    const std::vector<std::pair<int64_t, int> >& vecScores = GetMasternodeScores(blockHash);
 
     int nRank = 0;
-    BOOST_FOREACH (PAIRTYPE(int64_t, CMasternode*)& s, vecMasternodeScores) {
+    BOOST_FOREACH (const PAIRTYPE(int64_t, int)& s, vecScores) {
+        CMasternode& mn = vMasternodes[s.second];
+        if(mn.nProtocolVersion < nMinProtocol || !mn.IsEnabled()) continue;
         nRank++;
-        vecMasternodeRanks.push_back(std::make_pair(nRank, *s.second));
+        vecMasternodeRanks.push_back(std::make_pair(nRank, mn));
     }
 
     return vecMasternodeRanks;
@@ -766,8 +782,6 @@ std::vector<std::pair<int, CMasternode> > CMasternodeMan::GetMasternodeRanks(int
 
 CMasternode* CMasternodeMan::GetMasternodeByRank(int nRank, int nBlockHeight, int nMinProtocol, bool fOnlyActive)
 {
-    std::vector<std::pair<int64_t, CMasternode*> > vecMasternodeScores;
-
     LOCK(cs);
 
     uint256 blockHash;
@@ -776,24 +790,16 @@ CMasternode* CMasternodeMan::GetMasternodeByRank(int nRank, int nBlockHeight, in
         return NULL;
     }
 
-    // Fill scores
-    BOOST_FOREACH(CMasternode& mn, vMasternodes) {
+    const std::vector<std::pair<int64_t, int> >& vecScores = GetMasternodeScores(blockHash);
 
+    int rank = 0;
+    BOOST_FOREACH (const PAIRTYPE(int64_t, int)& s, vecScores){
+        CMasternode& mn = vMasternodes[s.second];
         if(mn.nProtocolVersion < nMinProtocol) continue;
         if(fOnlyActive && !mn.IsEnabled()) continue;
-
-        int64_t nScore = mn.CalculateScore(blockHash).GetCompact(false);
-
-        vecMasternodeScores.push_back(std::make_pair(nScore, &mn));
-    }
-
-    sort(vecMasternodeScores.rbegin(), vecMasternodeScores.rend(), CompareScoreMN());
-
-    int rank = 0;
-    BOOST_FOREACH (PAIRTYPE(int64_t, CMasternode*)& s, vecMasternodeScores){
         rank++;
         if(rank == nRank) {
-            return s.second;
+            return &mn;
         }
     }
 
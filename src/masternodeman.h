@@ -110,6 +110,8 @@ private:
     static const int MNB_RECOVERY_WAIT_SECONDS      = 60;
     static const int MNB_RECOVERY_RETRY_SECONDS     = 3 * 60 * 60;
 
+    static const int MAX_SCORE_CACHE_BLOCKS         = 64;
+
 
     // critical section to protect the inner data structures
     mutable CCriticalSection cs;
@@ -152,10 +154,16 @@ private:
 
     int64_t nLastWatchdogVoteTime;
 
+    // every masternode's score per block hash as (compact score, index in vMasternodes), best first
+    std::map<uint256, std::vector<std::pair<int64_t, int> > > mapMasternodeScores;
+
     friend class CMasternodeSync;
 	/// Find an entry
     CMasternode* Find(const COutPoint& outpoint);
 
+    /// Scores of all masternodes for blockHash in rank order, computed once per block and list; cs must be held
+    const std::vector<std::pair<int64_t, int> >& GetMasternodeScores(const uint256& blockHash);
+
 public:
     // Keep track of all broadcasts I've seen
     std::map<uint256, std::pair<int64_t, CMasternodeBroadcast> > mapSeenMasternodeBroadcast;
@@ -193,6 +201,9 @@ public:
         READWRITE(mapSeenMasternodeBroadcast);
         READWRITE(mapSeenMasternodePing);
         READWRITE(indexMasternodes);
+        if(ser_action.ForRead()) {
+            mapMasternodeScores.clear();
+        }
         if(ser_action.ForRead() && (strVersion != SERIALIZATION_VERSION_STRING)) {
             Clear();
         }
@@ -15,6 +15,7 @@
 #include "consensus/merkle.h"
 #include "consensus/validation.h"
 #include "clientversion.h"
+#include "crypto/x11.h"
 #include "hash.h"
 #include "main.h"
 #include "net.h"
@@ -718,11 +719,46 @@ std::string GetCPIDSignature(int iThreadID)
 		/* End of Ascertain CPID Signature */
 }
 
+/**
+ * Serves the X11 hashes of the miner's nonce loop from batches computed by
+ * X11HashHeaders. A batch is refilled when the nonce leaves it or any other
+ * header field (time, merkle root) changed since it was hashed.
+ */
+class CX11NonceBatch
+{
+private:
+    unsigned char header[X11_HEADER_SIZE];
+    uint32_t nFirst;
+    unsigned int nCount;
+    unsigned char hashes[32 * X11_MAX_BATCH];
+
+public:
+    CX11NonceBatch() : nFirst(0), nCount(0) {}
+
+    uint256 GetHash(const CBlockHeader& block)
+    {
+        // Same bytes CBlockHeader::GetHash() feeds HashX11
+        const unsigned char* pheader = (const unsigned char*)BEGIN(block.nVersion);
+        if (block.nNonce - nFirst >= nCount || memcmp(pheader, header, X11_HEADER_SIZE - 4) != 0)
+        {
+            memcpy(header, pheader, X11_HEADER_SIZE);
+            nFirst = block.nNonce;
+            nCount = X11_MAX_BATCH;
+            X11HashHeaders(header, nFirst, nCount, hashes);
+        }
+        uint256 hash;
+        memcpy(hash.begin(), hashes + 32 * (block.nNonce - nFirst), 32);
+        return hash;
+    }
+};
+
 void static BibleMiner(const CChainParams& chainparams, int iThreadID, int iFeatureSet)
 {
 	// 2-23-2018 - Robert A. (BiblePay)
 
 	LogPrintf("BibleMiner -- started thread %f \n",(double)iThreadID);
+	LogPrintf("BibleMiner -- X11 implementation: %s \n", X11BatchImplementation());
+	CX11NonceBatch x11Batch;
     int64_t nThreadStart = GetTimeMillis();
 	int64_t nLastPODCUpdate = GetAdjustedTime();
 	int64_t nThreadWork = 0;
@@ -893,7 +929,7 @@ recover:
 					// BiblePay: Proof of BibleHash requires the blockHash to not only be less than the Hash Target, but also,
 					// the BibleHash of the blockhash must be less than the target.
 					// The BibleHash is generated from chained bible verses, a historical tx lookup, one AES encryption operation, and MD5 hash
-					uint256 x11_hash = pblock->GetHash();
+					uint256 x11_hash = x11Batch.GetHash(*pblock);
 					uint256 hash;
 					hash = BibleHash(x11_hash, pblock->GetBlockTime(), pindexPrev->nTime, true, pindexPrev->nHeight, NULL, false, f7000, f8000, f9000, fTitheBlocksActive, pblock->nNonce);
 					nHashesDone += 1;
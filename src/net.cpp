@@ -17,6 +17,8 @@
 #include "consensus/consensus.h"
 #include "crypto/common.h"
 #include "hash.h"
+#include "httpsclient.h"
+#include "ipfsclient.h"
 #include "primitives/transaction.h"
 #include "scheduler.h"
 #include "ui_interface.h"
@@ -48,6 +50,7 @@
 #include <miniupnpc/upnperrors.h>
 #endif
 
+#include <boost/bind.hpp>
 #include <boost/filesystem.hpp>
 #include <boost/thread.hpp>
 
@@ -91,8 +94,6 @@ extern std::string GetDomainFromURL(std::string sURL);
 extern bool DownloadDistributedComputingFile(int iNextSuperblock, std::string& sError);
 bool FilterFile(int iBufferSize, int iNextSuperblock, std::string& sError);
 std::string GetSporkValue(std::string sKey);
-int ipfs_socket_connect(string ip_address, int port);
-int ipfs_http_get(const string& request, const string& ip_address, int port, const string& fname, double dTimeoutSecs);
 extern int ipfs_download(const string& url, const string& filename, double dTimeoutSecs);
 int64_t GetFileSize(std::string sPath);
 
@@ -3189,6 +3190,25 @@ bool DownloadDistributedComputingFile(int iNextSuperblock, std::string& sError)
 }
 
 
+static bool IsHTTPSResponseComplete(bool fPoolMarkers, int iBreakOnError, const std::string& sData)
+{
+	// The pool and project pages are not always sent with a length; these mark their end
+	if (sData.find("</html>") != string::npos) return true;
+	if (sData.find("</HTML>") != string::npos) return true;
+	if (sData.find("<EOF>") != string::npos) return true;
+	if (!fPoolMarkers) return false;
+	if (sData.find("<END>") != string::npos) return true;
+	if (sData.find("</account_out>") != string::npos) return true;
+	if (sData.find("</am_set_info_reply>") != string::npos) return true;
+	if (sData.find("</am_get_info_reply>") != string::npos) return true;
+	if (iBreakOnError == 1) if (sData.find("</user>") != string::npos) return true;
+	if (iBreakOnError == 1) if (sData.find("</error>") != string::npos) return true;
+	if (iBreakOnError == 1) if (sData.find("</error_msg>") != string::npos) return true;
+	if (iBreakOnError == 2) if (sData.find("</results>") != string::npos) return true;
+	if (iBreakOnError == 3) if (sData.find("}}") != string::npos) return true;
+	return false;
+}
+
 std::string BiblepayIPFSPost(std::string sFileName, std::string sPayload)
 {
 		int iTimeoutSecs = 30;
@@ -3198,73 +3218,15 @@ std::string BiblepayIPFSPost(std::string sFileName, std::string sPayload)
 		mapRequestHeaders["Filename"] = sFileName;
 		const CChainParams& chainparams = Params();
 		mapRequestHeaders["NetworkID"] = chainparams.NetworkIDString();
-		BIO* bio;
-		SSL_CTX* ctx;
-		SSL_library_init();
-		ctx = SSL_CTX_new(SSLv23_client_method());
-		if (ctx == NULL) 
-			return "<ERROR>CTX_IS_NULL</ERROR>";
-		bio = BIO_new_ssl_connect(ctx);
 		std::string sDomain = GetDomainFromURL("ipfs.biblepay.org");
-		int iPort = 443;
-		std::string sDomainWithPort = sDomain + ":" + RoundToString(iPort, 0);
-		BIO_set_conn_hostname(bio, sDomainWithPort.c_str());
-		if(BIO_do_connect(bio) <= 0)
-			return "<ERROR>BIO_FAILURE while connecting " + sDomainWithPort + "</ERROR>";
-		CService addrConnect;
 		if (sDomain.empty()) return "<ERROR>DOMAIN_MISSING</ERROR>";
-		CService addrIP(sDomain, iPort, true);
-    	if (addrIP.IsValid())
-		{
-			addrConnect = addrIP;
-		}
-		else
-		{ 
-			return "<ERROR>DNS_ERROR</ERROR>"; 
-		}
-		
 		std::string sPost = PrepareHTTPPost(true, "ipfs.bible", sDomain, sPayload, mapRequestHeaders);
-		const char* write_buf = sPost.c_str();
-		if(BIO_write(bio, write_buf, strlen(write_buf)) <= 0)
-		{
-		return "<ERROR>FAILED_HTTPS_POST</ERROR>";
-		}
-		int size;
-		char buf[1024];
-		clock_t begin = clock();
-		std::string sData = "";
-		for(;;)
-		{
-			size = BIO_read(bio, buf, 1023);
-			if(size <= 0)
-			{
-				break;
-			}
-			buf[size] = 0;
-			string MyData(buf);
-			sData += MyData;
-			clock_t end = clock();
-			double elapsed_secs = double(end - begin) / (CLOCKS_PER_SEC + .01);
-			if (elapsed_secs > iTimeoutSecs) break;
-			if (sData.find("</html>") != string::npos) break;
-			if (sData.find("</HTML>") != string::npos) break;
-			if (sData.find("<EOF>") != string::npos) break;
-			if (sData.find("Content-Length:") != string::npos)
-			{
-				double dMaxSize = cdbl(ExtractXML(sData,"Content-Length: ","\n"),0);
-				std::size_t foundPos = sData.find("Content-Length:");
-				if (dMaxSize > 0)
-				{
-					iMaxSize = dMaxSize + (int)foundPos + 16;
-				}
-			}
-			if ((int)sData.size() >= (iMaxSize-1)) break;
-		}
-		BIO_free_all(bio);
+		std::string sError;
+		std::string sData = GetHTTPSClient().Request(sDomain, 443, sPost, iTimeoutSecs, iMaxSize, boost::bind(&IsHTTPSResponseComplete, false, 0, _1), sError);
+		if (!sError.empty()) return "<ERROR>" + sError + "</ERROR>";
 		return sData;
 }
 
-
 std::string BiblepayHTTPSPost(bool bPost, int iThreadID, std::string sActionName, std::string sDistinctUser, std::string sPayload, std::string sBaseURL, 
 	std::string sPage, int iPort, std::string sSolution, int iTimeoutSecs, int iMaxSize, int iBreakOnError)
 {
@@ -3281,92 +3243,14 @@ std::string BiblepayHTTPSPost(bool bPost, int iThreadID, std::string sActionName
 			mapRequestHeaders["ThreadID"] = RoundToString(iThreadID,0);
 			mapRequestHeaders["OS"] = sOS;
 
-			BIO* bio;
-			SSL_CTX* ctx;
-			//   Registers the SSL/TLS ciphers and digests and starts the security layer.
-			SSL_library_init();
-			ctx = SSL_CTX_new(SSLv23_client_method());
-			if (ctx == NULL)
-			{
-				return "<ERROR>CTX_IS_NULL</ERROR>";
-			}
-			bio = BIO_new_ssl_connect(ctx);
 			std::string sDomain = GetDomainFromURL(sBaseURL);
-			std::string sDomainWithPort = sDomain + ":" + "443";
-			BIO_set_conn_hostname(bio, sDomainWithPort.c_str());
-			if(BIO_do_connect(bio) <= 0)
-			{
-				return "<ERROR>Failed connection to " + sDomainWithPort + "</ERROR>";
-			}
-	
-			CService addrConnect;
 			if (sDomain.empty()) return "<ERROR>DOMAIN_MISSING</ERROR>";
-			CService addrIP(sDomain, 443, true);
-            if (addrIP.IsValid())
-			{
-				addrConnect = addrIP;
-			}
-			else
-			{
-  				return "<ERROR>DNS_ERROR</ERROR>"; 
-			}
 			std::string sPost = PrepareHTTPPost(bPost, sPage, sDomain, sPayload, mapRequestHeaders);
-			const char* write_buf = sPost.c_str();
-			if(BIO_write(bio, write_buf, strlen(write_buf)) <= 0)
-			{
-				//  Handle failed writes here
-				if(!BIO_should_retry(bio))
-				{
-					// ToDo: Server requested a retry.  Handle this someday.
-				}
-				return "<ERROR>FAILED_HTTPS_POST</ERROR>";
-			}
-      		//  Variables used to read the response from the server
-			int size;
-			char buf[1024];
-			clock_t begin = clock();
-			std::string sData = "";
-			for(;;)
-			{
-				//  Get chunks of the response 1023 at the time.
-				size = BIO_read(bio, buf, 1023);
-				if(size <= 0)
-				{
-					break;
-				}
-				buf[size] = 0;
-				string MyData(buf);
-				sData += MyData;
-				clock_t end = clock();
-				double elapsed_secs = double(end - begin) / (CLOCKS_PER_SEC + .01);
-				if (elapsed_secs > iTimeoutSecs) break;
-				if (sData.find("</html>") != string::npos) break;
-				if (sData.find("</HTML>") != string::npos) break;
-				if (sData.find("<EOF>") != string::npos) break;
-				if (sData.find("<END>") != string::npos) break;
-				if (sData.find("</account_out>") != string::npos) break;
-				if (sData.find("</am_set_info_reply>") != string::npos) break;
-				if (sData.find("</am_get_info_reply>") != string::npos) break;
-				if (iBreakOnError == 1) if (sData.find("</user>") != string::npos) break;
-				if (iBreakOnError == 1) if (sData.find("</error>") != string::npos) break;
-				if (iBreakOnError == 1) if (sData.find("</error_msg>") != string::npos) break;
-				if (iBreakOnError == 2) if (sData.find("</results>") != string::npos) break;
-				if (iBreakOnError == 3) if (sData.find("}}") != string::npos) break;
-				if (sData.find("Content-Length:") != string::npos)
-				{
-					double dMaxSize = cdbl(ExtractXML(sData,"Content-Length: ","\n"),0);
-					std::size_t foundPos = sData.find("Content-Length:");
-					if (dMaxSize > 0)
-					{
-						iMaxSize = dMaxSize + (int)foundPos + 16;
-					}
-				}
-				if ((int)sData.size() >= (iMaxSize-1)) break;
-			}
-			// R ANDREW - JAN 4 2018: Free bio resources
-
-			BIO_free_all(bio);
-			
+			// Connections and TLS sessions are kept per host by the shared client, so repeated calls skip the handshakes
+			std::string sError;
+			std::string sData = GetHTTPSClient().Request(sDomain, iPort, sPost, iTimeoutSecs, iMaxSize, 
+				boost::bind(&IsHTTPSResponseComplete, true, iBreakOnError, _1), sError);
+			if (!sError.empty()) return "<ERROR>" + sError + "</ERROR>";
 			return sData;
 	}
 	catch (std::exception &e)
@@ -3383,161 +3267,9 @@ std::string BiblepayHTTPSPost(bool bPost, int iThreadID, std::string sActionName
 /*                                                                          IPFS                                                                 */
 
 
-string ipfs_header_value(const string& full_header, const string& header_name)
-{
-    size_t pos = full_header.find(header_name);
-    string r;
-    if (pos!=string::npos)
-    {
-        size_t begin = full_header.find_first_not_of(": ", pos + header_name.length());
-        size_t until = full_header.find_first_of("\r\n\t ", begin + 1);
-        if (begin!=string::npos && until!=string::npos)
-        {
-            r = full_header.substr(begin,until-begin);
-        }
-    }
-    return r;
-}
-
-int ipfs_http_get(const string& request, const string& ip_address, int port, const string& fname, double dTimeoutSecs)
-{
-    char buffer[65535];
-	int bytes_total=0;
-	int bytes_expected=99999999;
-    int mode = 0;
-	SOCKET socketnumber;
-	CService addrConnect(ip_address, port, true);
-    if (!addrConnect.IsValid()) return -4;
-	bool proxyConnectionFailed = false;
-   
-	if (!ConnectSocket(addrConnect, socketnumber, dTimeoutSecs * 1000, &proxyConnectionFailed))
-	{
-		return -3;
-	}
-
-	ofstream fd(fname.c_str());
-	if (!fd.good()) return -1;
-	
-	int iOffset = 0;
-	LogPrintf(" sending %s ",ip_address.c_str());
-
-    ::send(socketnumber, request.c_str(), request.length(), MSG_NOSIGNAL | MSG_DONTWAIT);
-	double begin = clock();
-    while (bytes_total < bytes_expected)
-	{
-		    char tempbuffer[4096];
-			int iTempBytesRec = ::recv(socketnumber, tempbuffer, sizeof(tempbuffer), MSG_DONTWAIT);
-			if (iTempBytesRec > 0)
-			{
-				for (int k = 0; k < iTempBytesRec; k++)
-				{
-					buffer[iOffset + k] = tempbuffer[k];
-				}
-				iOffset += iTempBytesRec;
-			}
-		                
-			double elapsed_secs = double(clock() - begin) / (CLOCKS_PER_SEC + .01);
-			if (elapsed_secs > dTimeoutSecs) break;
-			if (iOffset > 255 || (iOffset+bytes_total > bytes_expected-1))
-			{
-				if (mode == 1) 
-				{
-					fd.write(buffer, iOffset);
-					bytes_total += iOffset;
-					//	LogPrintf(" . rec %f  bytestotal %f . ", iOffset, bytes_total);
-					iOffset = 0;
-					memset(buffer, 0, sizeof(buffer));
-				}
-				else if (mode == 0)
-				{
-					string sHeader(buffer);
-					std::string CL = ExtractXML(sHeader, "Content-Length:","\n");
-					int ContentSize = (int)cdbl(CL, 0);
-					if (ContentSize > 0)
-					{
-						// Find offset
-						int body_start = sHeader.find("\r\n\r\n");
-						bytes_expected  = ContentSize + body_start + 3;
-						bytes_total += iOffset;
-						// LogPrintf(" data %s bytes expected %f  elapsed %f bodystart %f   bytestotal %f ....... ",CL.c_str(), bytes_expected, elapsed_secs, body_start, bytes_total);
-						mode=1;
-						// Write first chunk
-						int iFirstByte = body_start + 4;
-						int iFirstChunk = iOffset - iFirstByte;
-						char tempbuffer[iFirstChunk];
-						for (int j = 0; j < iFirstChunk; j++)
-						{
-							tempbuffer[j] = buffer[j + iFirstByte];
-						}
-						fd.write(tempbuffer, iFirstChunk);
-						memset(buffer, 0, sizeof(buffer));
-						iOffset = 0;
-					}
-			}
-		}
-    }
-    ::close(socketnumber);
-    fd.close();
-	if (bytes_total >= bytes_expected && bytes_total > 0 && bytes_expected > 0) return 1;
-	return -2;
-}
-
-
 int ipfs_download(const string& url, const string& filename, double dTimeoutSecs)
 {
-	int port = 0;
-    string protocol, domain, path, query, url_port;
-    vector<string> ip_addresses;
-    int offset = 0;
-    size_t pos1,pos2,pos3,pos4;
-    offset = offset==0 && url.compare(0, 8, "https://")==0 ? 8 : offset;
-    offset = offset==0 && url.compare(0, 7, "http://" )==0 ? 7 : offset;
-    pos1 = url.find_first_of('/', offset+1 );
-    path = pos1==string::npos ? "" : url.substr(pos1);
-    domain = string( url.begin()+offset, pos1 != string::npos ? url.begin()+pos1 : url.end() );
-    path = (pos2 = path.find("#"))!=string::npos ? path.substr(0,pos2) : path;
-    url_port = (pos3 = domain.find(":"))!=string::npos ? domain.substr(pos3+1) : "";
-    domain = domain.substr(0, pos3!=string::npos ? pos3 : domain.length());
-    protocol = offset > 0 ? url.substr(0,offset-3) : "";
-    query = (pos4 = path.find("?"))!=string::npos ? path.substr(pos4+1) : "";
-    path = pos4!=string::npos ? path.substr(0,pos4) : path;
- 
-    if (query.length()>0)
-    {
-        path.reserve( path.length() + 1 + query.length() );
-        path.append("?").append(query);
-    }
-    if (url_port.length()==0 && protocol.length()>0)
-    {
-        url_port = protocol=="http" ? "80" : "443";
-    }
-
-	// DNS
-	CService addrIP(domain, (int)cdbl(url_port, 0), true);
-    if (addrIP.IsValid())
-	{
-		domain = GetIPFromAddress(addrIP.ToString());
-		LogPrintf(" domain %s ",domain.c_str());
-	}
-	
-    if (domain.length() > 0)
-            ip_addresses.push_back(domain);
-    int r = -1;
-    if (ip_addresses.size() > 0)
-    {
-        stringstream(url_port) >> port;
-        stringstream request;
-        request << "GET " << path << " HTTP/1.1\r\n";
-        request << "Host: " << domain << "\r\n\r\n";
-		int ix = ip_addresses.size();
-
-        for(int i = 0; i < ix; i++)
-        {
-            r = ipfs_http_get(request.str(), ip_addresses[i], port, filename, dTimeoutSecs);
-			if (r==1) return r;
-        }
-    }
-
-	return r;
+	// Streams the body straight into the file, see ipfsclient.h for the other sinks
+	return IPFSDownloadFile(url, filename, dTimeoutSecs);
 }
 
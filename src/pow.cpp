@@ -8,7 +8,9 @@
 #include "arith_uint256.h"
 #include "chain.h"
 #include "chainparams.h"
+#include "main.h"
 #include "primitives/block.h"
+#include "txdb.h"
 #include "uint256.h"
 #include "util.h"
 #include "kjv.h"
@@ -26,6 +28,45 @@ uint256 PercentToBigIntBase(int iPercent);
 extern bool CheckProofOfLoyalty(double dWeight, uint256 hash, unsigned int nBits, const Consensus::Params& params, 
 	int64_t nBlockTime, int64_t nPrevBlockTime, int nPrevHeight, unsigned int nNonce, const CBlockIndex* pindexPrev, bool bLoadingBlockIndex);
 
+/** BibleHash of a header, taken from the validated BibleHash store when it holds one computed from the same inputs */
+static uint256 GetCachedBibleHash(const uint256& hash, int64_t nBlockTime, int64_t nPrevBlockTime, int nPrevHeight, unsigned int nNonce,
+	bool f7000, bool f8000, bool f9000, bool fTitheBlocksActive, bool& fCached)
+{
+	uint256 uBibleHash;
+	fCached = pbiblehashdb != NULL && pbiblehashdb->ReadBibleHash(hash, nBlockTime, nPrevBlockTime, nPrevHeight, nNonce, uBibleHash);
+	if (!fCached)
+		uBibleHash = BibleHash(hash, nBlockTime, nPrevBlockTime, true, nPrevHeight, NULL, false, f7000, f8000, f9000, fTitheBlocksActive, nNonce);
+	return uBibleHash;
+}
+
+/** Remembers a locally computed BibleHash, but only when the inputs are those of the real parent block */
+static void StoreBibleHash(const uint256& hash, int64_t nBlockTime, int64_t nPrevBlockTime, int nPrevHeight, unsigned int nNonce, 
+	const CBlockIndex* pindexPrev, const uint256& uBibleHash)
+{
+	if (pbiblehashdb == NULL || pindexPrev == NULL || nPrevHeight == 0) return;
+	if ((int64_t)pindexPrev->nTime != nPrevBlockTime || pindexPrev->nHeight != nPrevHeight) return;
+	if (!pbiblehashdb->WriteBibleHash(hash, CBibleHashRecord(nBlockTime, nPrevBlockTime, nPrevHeight, nNonce, uBibleHash)))
+		LogPrintf("StoreBibleHash: failed to write the BibleHash of %s \n", hash.GetHex().c_str());
+}
+
+uint256 GetBlockBibleHash(const CBlockIndex* pindex)
+{
+	if (!pindex->hashBibleHash.IsNull()) return pindex->hashBibleHash;
+	const CBlockIndex* pindexPrev = pindex->pprev;
+	int64_t nPrevBlockTime = (pindexPrev != NULL) ? pindexPrev->nTime : 0;
+	int nPrevHeight = (pindexPrev != NULL) ? pindexPrev->nHeight : 0;
+	bool f7000;
+	bool f8000;
+	bool f9000;
+	bool fTitheBlocksActive;
+	GetMiningParams(nPrevHeight, f7000, f8000, f9000, fTitheBlocksActive);
+	bool fCached = false;
+	uint256 uBibleHash = GetCachedBibleHash(pindex->GetBlockHash(), pindex->GetBlockTime(), nPrevBlockTime, nPrevHeight, pindex->nNonce, 
+		f7000, f8000, f9000, fTitheBlocksActive, fCached);
+	if (!fCached) StoreBibleHash(pindex->GetBlockHash(), pindex->GetBlockTime(), nPrevBlockTime, nPrevHeight, pindex->nNonce, pindexPrev, uBibleHash);
+	return uBibleHash;
+}
+
 
 
 
@@ -399,7 +440,8 @@ bool CheckProofOfWork(uint256 hash, unsigned int nBits, const Consensus::Params&
 	
 	if (f7000 || f_8000)
 	{
-		uint256 uBibleHash = BibleHash(hash, nBlockTime, nPrevBlockTime, true, nPrevHeight, NULL, false, f_7000, f_8000, f_9000, fTitheBlocksActive, nNonce);
+		bool fCached = false;
+		uint256 uBibleHash = GetCachedBibleHash(hash, nBlockTime, nPrevBlockTime, nPrevHeight, nNonce, f_7000, f_8000, f_9000, fTitheBlocksActive, fCached);
 		if (UintToArith256(uBibleHash) > bnTarget)
 		{
 			uint256 uBibleHash2 = BibleHash(hash, nBlockTime, nPrevBlockTime, true, nPrevHeight, NULL, false, f_7000, f_8000, f_9000, fTitheBlocksActive, nNonce);
@@ -420,6 +462,11 @@ bool CheckProofOfWork(uint256 hash, unsigned int nBits, const Consensus::Params&
 				return error("CheckProofOfWork(1): BibleHash does not meet POW level, prevheight %f pindexPrev %s ",(double)nPrevHeight,h1.GetHex().c_str());
 			}
 		}
+		else if (!fCached)
+		{
+			// Validated: later checks of this header (reindex, block index load, RPC) read it back instead of recomputing it
+			StoreBibleHash(hash, nBlockTime, nPrevBlockTime, nPrevHeight, nNonce, pindexPrev, uBibleHash);
+		}
 	}
 	
 	if (f_9000)
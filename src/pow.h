@@ -31,6 +31,9 @@ bool CheckProofOfWork(uint256 hash, unsigned int nBits, const Consensus::Params&
 
 arith_uint256 GetBlockProof(const CBlockIndex& block);
 
+/** BibleHash of an indexed block: the one persisted in the index, else the validated BibleHash store, else computed (and stored) */
+uint256 GetBlockBibleHash(const CBlockIndex* pindex);
+
 /** Return the time it would take to redo the work difference between from and to, assuming the current hashrate corresponds to the difficulty at tip, in seconds. */
 int64_t GetBlockProofEquivalentTime(const CBlockIndex& to, const CBlockIndex& from, const CBlockIndex& tip, const Consensus::Params&);
 
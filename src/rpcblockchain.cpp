@@ -5,19 +5,29 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include "amount.h"
+#include "appcache.h"
+#include "appcachedb.h"
+#include "blockcache.h"
+#include "bostore.h"
 #include "chain.h"
 #include "chainparams.h"
 #include "checkpoints.h"
 #include "coins.h"
 #include "consensus/validation.h"
+#include "dccfile.h"
+#include "ipfsclient.h"
+#include "keyset.h"
 #include "main.h"
 #include "policy/policy.h"
+#include "pow.h"
 #include "primitives/transaction.h"
 #include "rpcserver.h"
 #include "podc.h"
+#include "stakeweight.h"
 #include "streams.h"
 #include "sync.h"
 #include "txmempool.h"
+#include "txmessage.h"
 #include "util.h"
 #include "utilstrencodings.h"
 #include "base58.h"
@@ -32,6 +42,7 @@
 #include "governance-classes.h"
 #include "masternode-sync.h"
 
+#include <boost/bind.hpp>
 #include <boost/lexical_cast.hpp>
 #include <boost/algorithm/string/case_conv.hpp> // for to_lower()
 #include <boost/algorithm/string.hpp> // for trim()
@@ -87,7 +98,7 @@ extern std::string GetAccountAuthenticator(std::string sEmail, std::string sPass
 extern double GetRosettaLocalRAC();
 extern std::string GetCPID();
 
-bool ipfs_download(const string& url, const string& filename, double dTimeoutSecs);
+int ipfs_download(const string& url, const string& filename, double dTimeoutSecs);
 extern int CheckSanctuaryIPFSHealth(std::string sAddress);
 extern std::string AssociateDCAccount(std::string sProjectId, std::string sBoincEmail, std::string sBoincPassword, std::string sUnbankedPublicKey, bool fForce);
 extern std::string SubmitToIPFS(std::string sPath, std::string& sError);
@@ -102,7 +113,7 @@ extern bool is_email_valid(const std::string& e);
 extern double AscertainResearcherTotalRAC();
 extern std::vector<std::string> GetListOfDCCS(std::string sSearch, bool fRequireSig);
 extern bool VerifyCPIDSignature(std::string sFullSig, bool bRequireEndToEndVerification, std::string& sError);
-extern double GetSumOfXMLColumnFromXMLFile(std::string sFileName, std::string sObjectName, std::string sElementName, double dReqSPM, double dReqSPR, double dTeamRequired, std::string sConcatCpids, 
+extern double GetSumOfDCCCredit(const CDCCTable& table, double dReqSPM, double dReqSPR, double dTeamRequired, const CCPIDSet& setConcatCPIDs, 
 		double dRACThreshhold, std::string sTeamBlacklist, int iNextSuperblock);
 extern uint256 GetDCCHash(std::string sContract);
 extern UniValue UTXOReport(std::string sCPID);
@@ -207,6 +218,7 @@ extern std::string rPad(std::string data, int minWidth);
 bool CheckNonce(bool f9000, unsigned int nNonce, int nPrevHeight, int64_t nPrevBlockTime, int64_t nBlockTime);
 extern std::string GetElement(std::string sIn, std::string sDelimiter, int iPos);
 std::string GetMessagesFromBlock(const CBlock& block, std::string sMessages);
+TxMessage GetParsedTxMessage(const CTransaction& tx, int64_t nTime);
 std::string GetBibleHashVerses(uint256 hash, uint64_t nBlockTime, uint64_t nPrevBlockTime, int nPrevHeight, CBlockIndex* pindexprev);
 UniValue createrawtransaction(const UniValue& params, bool fHelp);
 CBlockIndex* FindBlockByHeight(int nHeight);
@@ -403,19 +415,14 @@ UniValue blockToJSON(const CBlock& block, const CBlockIndex* blockindex, bool tx
 	{
 		//result.push_back(Pair("estimatedsanctuaryreward", dReward));
         result.push_back(Pair("previousblockhash", blockindex->pprev->GetBlockHash().GetHex()));
-		std::string sVerses = GetBibleHashVerses(block.GetHash(), block.GetBlockTime(), blockindex->pprev->nTime, blockindex->pprev->nHeight, blockindex->pprev);
-		if (bShowPrayers) result.push_back(Pair("verses", sVerses));
+		if (bShowPrayers)
+		{
+			std::string sVerses = GetBibleHashVerses(block.GetHash(), block.GetBlockTime(), blockindex->pprev->nTime, blockindex->pprev->nHeight, blockindex->pprev);
+			result.push_back(Pair("verses", sVerses));
+		}
     	// Check work against BibleHash
-		bool f7000;
-		bool f8000;
-		bool f9000;
-		bool fTitheBlocksActive;
-		GetMiningParams(blockindex->pprev->nHeight, f7000, f8000, f9000, fTitheBlocksActive);
-
 		arith_uint256 hashTarget = arith_uint256().SetCompact(blockindex->nBits);
-		uint256 hashWork = blockindex->GetBlockHash();
-		uint256 bibleHash = BibleHash(hashWork, block.GetBlockTime(), blockindex->pprev->nTime, false, blockindex->pprev->nHeight, blockindex->pprev, 
-			false, f7000, f8000, f9000, fTitheBlocksActive, blockindex->nNonce);
+		uint256 bibleHash = GetBlockBibleHash(blockindex);
 		bool bSatisfiesBibleHash = (UintToArith256(bibleHash) <= hashTarget);
 	
 
@@ -514,7 +521,7 @@ UniValue showblock(const UniValue& params, bool fHelp)
         throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Block not found");
     CBlock block;
     const Consensus::Params& consensusParams = Params().GetConsensus();
-	ReadBlockFromDisk(block, pblockindex, consensusParams, "SHOWBLOCK");
+	ReadBlockFromDisk(block, pblockindex, consensusParams);
 	bool bVerbose = false;
 	if (params.size() > 1) bVerbose = params[1].get_str() == "true" ? true : false;
 	return blockToJSON(block, pblockindex, false, bVerbose);
@@ -930,7 +937,7 @@ UniValue getblock(const UniValue& params, bool fHelp)
     if (fHavePruned && !(pblockindex->nStatus & BLOCK_HAVE_DATA) && pblockindex->nTx > 0)
         throw JSONRPCError(RPC_INTERNAL_ERROR, "Block not available (pruned data)");
 
-    if(!ReadBlockFromDisk(block, pblockindex, Params().GetConsensus(), "GETBLOCK"))
+    if(!ReadBlockFromDisk(block, pblockindex, Params().GetConsensus()))
         throw JSONRPCError(RPC_INTERNAL_ERROR, "Can't read block from disk");
 
     if (!fVerbose)
@@ -1373,7 +1380,7 @@ void ScanBlockChainVersion(int nLookback)
     {
          if (!pblockindex || !pblockindex->pprev) return;
          pblockindex = pblockindex->pprev;
-         if (ReadBlockFromDisk(block, pblockindex, consensusParams, "SCANBLOCKCHAINVERSION")) 
+         if (ReadBlockFromDisk(block, pblockindex, consensusParams)) 
 		 {
 			std::string sVersion2 = ExtractXML(block.vtx[0].vout[0].sTxOutMessage,"<VER>","</VER>");
 			mvBlockVersion[sVersion2]++;
@@ -1625,20 +1632,8 @@ UniValue GetVersionReport()
 
 bool GetTransactionTimeAndAmount(uint256 txhash, int nVout, int64_t& nTime, CAmount& nAmount)
 {
-	uint256 hashBlock = uint256();
-	CTransaction tx2;
-	if (GetTransaction(txhash, tx2, Params().GetConsensus(), hashBlock, true))
-	{
-		   BlockMap::iterator mi = mapBlockIndex.find(hashBlock);
-           if (mi != mapBlockIndex.end() && (*mi).second) 
-		   {
-              CBlockIndex* pMNIndex = (*mi).second; 
-			  nTime = pMNIndex->GetBlockTime();
-		      nAmount = tx2.vout[nVout].nValue;
-			  return true;
-		   }
-	}
-	return false;
+	// Looked up once per coin; the miner asks again for every block template
+	return GetStakeWeightCache().GetCoin(COutPoint(txhash, nVout), nTime, nAmount);
 }
 
 
@@ -1682,14 +1677,28 @@ double GetStakeWeight(CTransaction tx, int64_t nTipTime, std::string sXML, bool
 		bool fSigned = false;
 		// Ensure the signature works for every output:
 		std::string sMessage = ExtractXML(sXML, "<polmessage>","</polmessage>");
+		std::map<int, std::string> mapSigs;
+		ParseStakeSignatures(sXML, mapSigs);
+		std::vector<std::string> vSigs;
 		for (int iIndex = 0; iIndex < (int)tx.vout.size(); iIndex++) 
 		{
-			std::string sSignature = ExtractXML(sXML, "<SIG_" + RoundToString(iIndex,0) + ">","</SIG_" + RoundToString(iIndex,0) + ">");
-			const CTxOut& txout = tx.vout[iIndex];
-			std::string sAddr = PubKeyToAddress(txout.scriptPubKey);
-			fSigned = CheckStakeSignature(sAddr, sSignature, sMessage, sError);
-			if (!fSigned) break;
+			vSigs.push_back(mapSigs.count(iIndex) ? mapSigs[iIndex] : "");
 		}
+		// An unchanged stake (same transaction, message and signatures) is only verified once
+		uint256 hashSigKey = CStakeWeightCache::GetSignatureKey(tx.GetHash(), sMessage, vSigs);
+		std::string sSigError = "";
+		if (!GetStakeWeightCache().GetSignatureResult(hashSigKey, fSigned, sSigError))
+		{
+			for (int iIndex = 0; iIndex < (int)tx.vout.size(); iIndex++) 
+			{
+				const CTxOut& txout = tx.vout[iIndex];
+				std::string sAddr = PubKeyToAddress(txout.scriptPubKey);
+				fSigned = CheckStakeSignature(sAddr, vSigs[iIndex], sMessage, sSigError);
+				if (!fSigned) break;
+			}
+			GetStakeWeightCache().SetSignatureResult(hashSigKey, fSigned, sSigError);
+		}
+		if (!sSigError.empty()) sError = sSigError;
 
 		if (!fSigned) dTotal=0;
 	}
@@ -1806,6 +1815,17 @@ uint256 Sha256001(int nType, int nVersion, string data)
     return result;
 }
 
+static double GetSuperblockTotalCoins(const CSuperblockPayments& payments)
+{
+	// Each payment counts in whole coins, as the superblock checks always summed them
+	double nTotalBlock = 0;
+	for (unsigned int i = 0; i < payments.vPayments.size(); i++)
+	{
+		nTotalBlock += payments.vPayments[i].second / COIN;
+	}
+	return nTotalBlock;
+}
+
 UniValue exec(const UniValue& params, bool fHelp)
 {
     if (fHelp || (params.size() != 1 && params.size() != 2  && params.size() != 3 && params.size() != 4 && params.size() != 5 && params.size() != 6 && params.size() != 7))
@@ -1969,7 +1989,7 @@ UniValue exec(const UniValue& params, bool fHelp)
 			if (pindex)
 			{
 				CBlock block;
-				if (ReadBlockFromDisk(block, pindex, consensusParams, "GETSUBSIDY")) 
+				if (ReadBlockFromDisk(block, pindex, consensusParams, BLOCK_READ_SKIP_POW)) 
 				{
         			results.push_back(Pair("subsidy", block.vtx[0].vout[0].nValue/COIN));
 					std::string sRecipient = PubKeyToAddress(block.vtx[0].vout[0].scriptPubKey);
@@ -2294,7 +2314,7 @@ UniValue exec(const UniValue& params, bool fHelp)
 		if (pblockindex==NULL)    throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Block not found");
 		CBlock block;
 		const Consensus::Params& consensusParams = Params().GetConsensus();
-		ReadBlockFromDisk(block, pblockindex, consensusParams, "SHOWBLOCK");
+		ReadBlockFromDisk(block, pblockindex, consensusParams);
 		CDataStream ssBlock(SER_NETWORK, PROTOCOL_VERSION);
 		//CBlock block1 = const_cast<CBlock&>(*block);
 		ssBlock << block;
@@ -2744,6 +2764,19 @@ UniValue exec(const UniValue& params, bool fHelp)
 			throw runtime_error("You must specify a list of BBP Addresses delimited by semicolons.");
 		}
 	}
+	else if (sItem == "getsuperblockpayments")
+	{
+		// Answered from the superblock payment index: exec getsuperblockpayments address_list [days]
+		if (params.size() != 2 && params.size() != 3)
+			throw runtime_error("You must specify a list of BBP Addresses delimited by semicolons, and optionally the number of days.");
+		double nDays = params.size() == 3 ? cdbl(params[2].get_str(), 0) : 7;
+		int64_t nNow = GetAdjustedTime();
+		int nSuperblocks = 0;
+		CAmount nPaid = GetSuperblockPaymentsToAddresses(CAddressSet(params[1].get_str()), nNow - (int64_t)(nDays * 86400), nNow, nSuperblocks);
+		results.push_back(Pair("Days", nDays));
+		results.push_back(Pair("Superblock Count", nSuperblocks));
+		results.push_back(Pair("Total Payments", ValueFromAmount(nPaid)));
+	}
 	else if (sItem == "getboincinfo")
 	{
 		std::string out_address = "";
@@ -2925,7 +2958,7 @@ UniValue exec(const UniValue& params, bool fHelp)
 			throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Block not found");
 		CBlock block;
 		const Consensus::Params& consensusParams = Params().GetConsensus();
-		ReadBlockFromDisk(block, pblockindex, consensusParams, "SHOWBLOCK");
+		ReadBlockFromDisk(block, pblockindex, consensusParams);
 		return blockToJSON(block, pblockindex, false, false, false);
 	}
 	else if (sItem == "wcgrac")
@@ -3556,6 +3589,63 @@ UniValue getmempoolinfo(const UniValue& params, bool fHelp)
     return mempoolInfoToJSON();
 }
 
+UniValue getcacheinfo(const UniValue& params, bool fHelp)
+{
+    if (fHelp || params.size() != 0)
+        throw runtime_error(
+            "getcacheinfo\n"
+            "\nReturns usage counters of the in-memory caches.\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"blockcache\": {             (object) Recently read blocks\n"
+            "    \"blocks\": xxxxx,           (numeric) Blocks held\n"
+            "    \"bytes\": xxxxx,            (numeric) Their memory usage\n"
+            "    \"maxbytes\": xxxxx,         (numeric) Size limit (-blockcachesize)\n"
+            "    \"hits\": xxxxx,             (numeric) Reads served from memory\n"
+            "    \"misses\": xxxxx            (numeric) Reads that went to disk\n"
+            "  },\n"
+            "  \"blockfiles\": {             (object) Memory mapped block files\n"
+            "    \"open\": xxxxx,             (numeric) Files held mapped\n"
+            "    \"opens\": xxxxx,            (numeric) Files mapped so far\n"
+            "    \"reads\": xxxxx             (numeric) Blocks read from them\n"
+            "  },\n"
+            "  \"appcache\": {               (object) Memorized blockchain messages\n"
+            "    \"entries\": xxxxx,          (numeric) Entries held\n"
+            "    \"keys\": xxxxx              (numeric) Distinct keys\n"
+            "  }\n"
+            "}\n"
+            "\nExamples:\n"
+            + HelpExampleCli("getcacheinfo", "")
+            + HelpExampleRpc("getcacheinfo", "")
+        );
+
+    CBlockCacheStats stats = blockCache.GetStats();
+    UniValue block(UniValue::VOBJ);
+    block.push_back(Pair("blocks", (uint64_t)stats.nBlocks));
+    block.push_back(Pair("bytes", (uint64_t)stats.nBytes));
+    block.push_back(Pair("maxbytes", (uint64_t)stats.nMaxBytes));
+    block.push_back(Pair("hits", stats.nHits));
+    block.push_back(Pair("misses", stats.nMisses));
+
+    size_t nOpen;
+    uint64_t nOpens, nReads;
+    blockFileCache.GetStats(nOpen, nOpens, nReads);
+    UniValue files(UniValue::VOBJ);
+    files.push_back(Pair("open", (uint64_t)nOpen));
+    files.push_back(Pair("opens", nOpens));
+    files.push_back(Pair("reads", nReads));
+
+    UniValue app(UniValue::VOBJ);
+    app.push_back(Pair("entries", (uint64_t)appCache.Size()));
+    app.push_back(Pair("keys", (uint64_t)appCache.KeyCount()));
+
+    UniValue ret(UniValue::VOBJ);
+    ret.push_back(Pair("blockcache", block));
+    ret.push_back(Pair("blockfiles", files));
+    ret.push_back(Pair("appcache", app));
+    return ret;
+}
+
 std::string AddBlockchainMessages(std::string sAddress, std::string sType, std::string sPrimaryKey, 
 	std::string sHTML, CAmount nAmount, std::string& sError)
 {
@@ -3718,29 +3808,13 @@ std::string TimestampToHRDate(double dtm)
 
 void SerializePrayersToFile(int nHeight)
 {
+	// Appends the changes since the last call to the binary snapshot; rewrites it only when the deltas outgrow it
 	if (nHeight < 100) return;
-	std::string sSuffix = fProd ? "_prod" : "_testnet";
-	std::string sTarget = GetSANDirectory2() + "prayers2" + sSuffix;
-	FILE *outFile = fopen(sTarget.c_str(), "w");
-	LogPrintf("Serializing Prayers... %f ",GetAdjustedTime());
-	for(map<string,string>::iterator ii=mvApplicationCache.begin(); ii!=mvApplicationCache.end(); ++ii) 
-    {
-		std::string sKey = (*ii).first;
-	   	int64_t nTimestamp = mvApplicationCacheTimestamp[(*ii).first];
-		std::string sValue = mvApplicationCache[(*ii).first];
-		bool bSkip = false;
-		if (sKey.length() > 7 && sKey.substr(0,7)=="MESSAGE" && (sValue == "" || sValue==" ")) bSkip = true;
-		if (!bSkip)
-		{
-			std::string sRow = RoundToString(nTimestamp, 0) + "<colprayer>" + RoundToString(nHeight, 0) + "<colprayer>" + sKey + "<colprayer>" + sValue + "<rowprayer>\r\n";
-			fputs(sRow.c_str(), outFile);
-		}
-	}
-	LogPrintf("...Done Serializing Prayers... %f ",GetAdjustedTime());
-    fclose(outFile);
+	if (!appCacheDB.IsOpen()) return;
+	appCacheDB.Flush(appCache, nHeight);
 }
 
-int DeserializePrayersFromFile()
+int DeserializeLegacyPrayersFromFile()
 {
 	std::string sSuffix = fProd ? "_prod" : "_testnet";
 	std::string sSource = GetSANDirectory2() + "prayers2" + sSuffix;
@@ -3779,6 +3853,17 @@ int DeserializePrayersFromFile()
 	return nHeight;
 }
 
+int DeserializePrayersFromFile()
+{
+	std::string sSuffix = fProd ? "_prod" : "_testnet";
+	appCacheDB.SetPath(GetSANDirectory2() + "appcache" + sSuffix + ".dat");
+	int nHeight = appCacheDB.Load(appCache);
+	// Upgrade path: fall back to the old text dump once, the next flush writes the binary snapshot.
+	// A snapshot of an older version means the text dump is older still, so the cache is memorized from the chain instead.
+	if (nHeight < 0 && !appCacheDB.HasFile()) nHeight = DeserializeLegacyPrayersFromFile();
+	return nHeight;
+}
+
 std::string GetIPFromAddress(std::string sAddress)
 {
 	std::vector<std::string> vAddr = Split(sAddress.c_str(),":");
@@ -3786,15 +3871,22 @@ std::string GetIPFromAddress(std::string sAddress)
 	return vAddr[0];
 }
 
-int CheckSanctuaryIPFSHealth(std::string sAddress)
+static CIPFSRequest GetSanctuaryIPFSHealthRequest(std::string sAddress)
 {
 	std::string sIP = GetIPFromAddress(sAddress);
 	std::string sHash = "QmU3cpfPbqzZQTDtMswsF5VP7hzduhvacqNTuEaEsV3wBX";
 	//TODO: Make Spork
 	std::string sSporkHash = GetSporkValue("ipfshealthhash");
-	std::string sURL = "http://" + sIP + ":8080/ipfs/" + sHash;
-	std::string sHealthFN = GetSANDirectory2() + "checkhealth.dat";
-	int i = ipfs_download(sURL, sHealthFN, 5);
+	CIPFSRequest req;
+	req.sURL = "http://" + sIP + ":8080/ipfs/" + sHash;
+	req.dTimeoutSecs = 5;
+	// Only whether the whole object arrives matters, so it is not stored
+	return req;
+}
+
+int CheckSanctuaryIPFSHealth(std::string sAddress)
+{
+	int i = IPFSGet(GetSanctuaryIPFSHealthRequest(sAddress));
 	LogPrintf(" Checking %s, Result %i ",sAddress.c_str(), i);
 	return i;
 }
@@ -3803,19 +3895,23 @@ UniValue GetSancIPFSQualityReport()
 {
 	UniValue ret(UniValue::VOBJ);
     std::vector<CMasternode> vMasternodes = mnodeman.GetFullMasternodeVector();
+	std::vector<CMasternode> vEnabled;
+	std::vector<CIPFSRequest> vRequests;
     BOOST_FOREACH(CMasternode& mn, vMasternodes) 
 	{
-		std::string strOutpoint = mn.vin.prevout.ToStringShort();
-		std::string sStatus = mn.GetStatus();
-		if (sStatus == "ENABLED")
+		if (mn.GetStatus() == "ENABLED")
 		{
-			int iQuality = CheckSanctuaryIPFSHealth(mn.addr.ToString());
-			//std::string sRow = sStatus + "; " 				+  CBitcoinAddress(mn.pubKeyCollateralAddress.GetID()).ToString()				+ " - " + TimestampToHRDate(mn.lastPing.sigTime)			+ " - " + mn.addr.ToString() + " - Q" + RoundToString(iQuality, 0);
-			std::string sNarr = iQuality == 1 ? "UP" : "DOWN";
-			std::string sRow = mn.addr.ToString() + ": " + sNarr;
-			ret.push_back(Pair(mn.addr.ToString(), sNarr));
+			vEnabled.push_back(mn);
+			vRequests.push_back(GetSanctuaryIPFSHealthRequest(mn.addr.ToString()));
 		}
 	}
+	// Sanctuaries are checked several at a time, so the unreachable ones do not each add their timeout
+	std::vector<int> vQuality = IPFSGetAll(vRequests, 8);
+	for (int i = 0; i < (int)vEnabled.size(); i++)
+	{
+		std::string sNarr = vQuality[i] == IPFS_OK ? "UP" : "DOWN";
+		ret.push_back(Pair(vEnabled[i].addr.ToString(), sNarr));
+	}
 	return ret;
 }
 
@@ -3837,37 +3933,67 @@ std::string GetUndownloadedIPFSHash()
 	return "";
 }
 
+static bool FetchBusinessObjectFromGateway(const std::string& sGateway, const std::string& sHash, const std::string& sPath)
+{
+	return ipfs_download(sGateway + sHash, sPath, 15) == 1;
+}
+
+static CBusinessObjectStore& GetBusinessObjectStore()
+{
+	static CBusinessObjectStore store(GetSANDirectory2() + "objects",
+		boost::bind(&FetchBusinessObjectFromGateway, GetArg("-ipfsgateway", "http://ipfs.biblepay.org:8080/ipfs/"), _1, _2));
+	return store;
+}
+
+static void PrefetchBusinessObjectHashes(const std::vector<std::string>& vHashes)
+{
+	GetBusinessObjectStore().Prefetch(vHashes, 8);
+}
+
+static void PrefetchBusinessObjects(const std::vector<CAppCache::item_t>& vItems)
+{
+	// The section values are the IPFS hashes of the objects
+	std::vector<std::string> vHashes;
+	for (int i = 0; i < (int)vItems.size(); i++)
+	{
+		vHashes.push_back(vItems[i].second.sValue);
+	}
+	PrefetchBusinessObjectHashes(vHashes);
+}
+
+static bool LoadIndexedBusinessObject(const std::string& sType, const std::string& sPrimaryKey, UniValue& o)
+{
+	std::string sError = "";
+	o = GetBusinessObject(sType, sPrimaryKey, sError);
+	return o.size() > 0;
+}
+
+static bool DeclareBusinessObjectIndexes(CBusinessObjectIndex& index)
+{
+	// The accounting summary totals and the contact lookup
+	index.Declare("REVENUE", "bbp_amount", BO_INDEX_SUM);
+	index.Declare("REVENUE", "btc_raised", BO_INDEX_SUM);
+	index.Declare("REVENUE", "btc_price", BO_INDEX_SUM);
+	index.Declare("REVENUE", "amount", BO_INDEX_SUM);
+	index.Declare("EXPENSE", "amount", BO_INDEX_SUM);
+	index.Declare("CONTACT", "email", BO_INDEX_EQUAL);
+	return true;
+}
+
+static CBusinessObjectIndex& GetBusinessObjectIndex()
+{
+	static CBusinessObjectIndex index(appCache, boost::bind(&LoadIndexedBusinessObject, _1, _2, _3), boost::bind(&PrefetchBusinessObjectHashes, _1));
+	static bool fDeclared = DeclareBusinessObjectIndexes(index);
+	(void)fDeclared;
+	return index;
+}
+
 double GetBusinessObjectTotal(std::string sType, std::string sFieldName, int iAggregationType)
 {
-	UniValue ret(UniValue::VOBJ);
 	boost::to_upper(sType);
-	double dTotal = 0;
-	double dTotalRows = 0;
-    for(map<string,string>::iterator ii=mvApplicationCache.begin(); ii!=mvApplicationCache.end(); ++ii) 
-    {
-		std::string sKey = (*ii).first;
-	   	if (sKey.length() > sType.length())
-		{
-			if (sKey.substr(0,sType.length())==sType)
-			{
-				std::string sPrimaryKey = sKey.substr(sType.length() + 1, sKey.length() - sType.length());
-				std::string sIPFSHash = mvApplicationCache[(*ii).first];
-				std::string sError = "";
-				UniValue o = GetBusinessObject(sType, sPrimaryKey, sError);
-				if (o.size() > 0)
-				{
-					bool fDeleted = o["deleted"].getValStr() == "1";
-					if (!fDeleted)
-					{
-						std::string sBOValue = o[sFieldName].getValStr();
-						double dBOValue = cdbl(sBOValue, 2);
-						dTotal += dBOValue;
-						dTotalRows++;
-					}
-				}
-			}
-		}
-	}
+	int64_t nTotalRows = 0;
+	double dTotal = GetBusinessObjectIndex().GetSum(sType, sFieldName, nTotalRows);
+	double dTotalRows = nTotalRows;
 	if (iAggregationType == 1) return dTotal;
 	double dAvg = 0;
 	if (dTotalRows > 0) dAvg = dTotal / dTotalRows;
@@ -3883,30 +4009,12 @@ UniValue GetBusinessObjectByFieldValue(std::string sType, std::string sFieldName
 	UniValue ret(UniValue::VOBJ);
 	boost::to_upper(sType);
 	boost::to_upper(sSearchValue);
-    for(map<string,string>::iterator ii=mvApplicationCache.begin(); ii!=mvApplicationCache.end(); ++ii) 
-    {
-		std::string sKey = (*ii).first;
-	   	if (sKey.length() > sType.length())
-		{
-			if (sKey.substr(0,sType.length())==sType)
-			{
-				std::string sPrimaryKey = sKey.substr(sType.length() + 1, sKey.length() - sType.length());
-				std::string sIPFSHash = mvApplicationCache[(*ii).first];
-				std::string sError = "";
-				UniValue o = GetBusinessObject(sType, sPrimaryKey, sError);
-				if (o.size() > 0)
-				{
-					bool fDeleted = o["deleted"].getValStr() == "1";
-					if (!fDeleted)
-					{
-						std::string sBOValue = o[sFieldName].getValStr();
-						boost::to_upper(sBOValue);
-						if (sBOValue == sSearchValue)
-							return o;
-					}
-				}
-			}
-		}
+	std::string sPrimaryKey = "";
+	if (GetBusinessObjectIndex().FindFirst(sType, sFieldName, sSearchValue, sPrimaryKey))
+	{
+		std::string sError = "";
+		UniValue o = GetBusinessObject(sType, sPrimaryKey, sError);
+		if (o.size() > 0) return o;
 	}
 	return ret;
 }
@@ -3916,24 +4024,19 @@ UniValue GetBusinessObjectList(std::string sType)
 {
 	UniValue ret(UniValue::VOBJ);
 	boost::to_upper(sType);
-    for(map<string,string>::iterator ii=mvApplicationCache.begin(); ii!=mvApplicationCache.end(); ++ii) 
-    {
-		std::string sKey = (*ii).first;
-	   	if (sKey.length() > sType.length())
+	std::vector<CAppCache::item_t> vItems = appCache.GetSection(sType);
+	PrefetchBusinessObjects(vItems);
+	for (int i = 0; i < (int)vItems.size(); i++)
+	{
+		std::string sPrimaryKey = vItems[i].first;
+		std::string sIPFSHash = vItems[i].second.sValue;
+		std::string sError = "";
+		UniValue o = GetBusinessObject(sType, sPrimaryKey, sError);
+		if (o.size() > 0)
 		{
-			if (sKey.substr(0,sType.length()) == sType)
-			{
-				std::string sPrimaryKey = sKey.substr(sType.length() + 1, sKey.length() - sType.length());
-				std::string sIPFSHash = mvApplicationCache[(*ii).first];
-				std::string sError = "";
-				UniValue o = GetBusinessObject(sType, sPrimaryKey, sError);
-				if (o.size() > 0)
-				{
-					bool fDeleted = o["deleted"].getValStr() == "1";
-					if (!fDeleted)
-							ret.push_back(Pair(sPrimaryKey + " (" + sIPFSHash + ")", o));
-				}
-			}
+			bool fDeleted = o["deleted"].getValStr() == "1";
+			if (!fDeleted)
+					ret.push_back(Pair(sPrimaryKey + " (" + sIPFSHash + ")", o));
 		}
 	}
 	return ret;
@@ -3957,11 +4060,12 @@ UserVote GetSumOfSignal(std::string sType, std::string sIPFSHash)
 	std::string sData = "";
 	UserVote v = UserVote();
 
-    for(map<string,string>::iterator ii=mvApplicationCache.begin(); ii!=mvApplicationCache.end(); ++ii) 
-    {
-		std::string sKey = (*ii).first;
-		std::string sValue = mvApplicationCache[(*ii).first];
-		if (Contains(sKey, sType + ";" + sIPFSHash))
+	std::vector<CAppCache::item_t> vItems = appCache.GetSection(sType);
+	for (int i = 0; i < (int)vItems.size(); i++)
+	{
+		const std::string& sKey = vItems[i].first;
+		const std::string& sValue = vItems[i].second.sValue;
+		if (sKey.substr(0, sIPFSHash.length()) == sIPFSHash)
 		{
 			std::string sLocalSignal = ExtractXML(sValue, "<signal>", "</signal>");
 			double dWeight = cdbl(ExtractXML(sValue, "<voteweight>", "</voteweight>"), 2);
@@ -3991,32 +4095,27 @@ std::string GetBusinessObjectList(std::string sType, std::string sFields)
 	boost::to_upper(sType);
 	std::vector<std::string> vFields = Split(sFields.c_str(), ",");
 	std::string sData = "";
-    for(map<string,string>::iterator ii=mvApplicationCache.begin(); ii!=mvApplicationCache.end(); ++ii) 
-    {
-		std::string sKey = (*ii).first;
-	   	if (sKey.length() > sType.length())
+	std::vector<CAppCache::item_t> vItems = appCache.GetSection(sType);
+	PrefetchBusinessObjects(vItems);
+	for (int iItem = 0; iItem < (int)vItems.size(); iItem++)
+	{
+		std::string sPrimaryKey = vItems[iItem].first;
+		std::string sIPFSHash = vItems[iItem].second.sValue;
+		std::string sError = "";
+		UniValue o = GetBusinessObject(sType, sPrimaryKey, sError);
+		if (o.size() > 0)
 		{
-			if (sKey.substr(0,sType.length()) == sType)
+			bool fDeleted = o["deleted"].getValStr() == "1";
+			if (!fDeleted)
 			{
-				std::string sPrimaryKey = sKey.substr(sType.length() + 1, sKey.length() - sType.length());
-				std::string sIPFSHash = mvApplicationCache[(*ii).first];
-				std::string sError = "";
-				UniValue o = GetBusinessObject(sType, sPrimaryKey, sError);
-				if (o.size() > 0)
+				// 1st column is ID - objecttype - recaddress - secondarykey
+				std::string sPK = sType + "-" + sPrimaryKey + "-" + sIPFSHash;
+				std::string sRow = sPK + "<col>";
+				for (int i = 0; i < (int)vFields.size(); i++)
 				{
-					bool fDeleted = o["deleted"].getValStr() == "1";
-					if (!fDeleted)
-					{
-						// 1st column is ID - objecttype - recaddress - secondarykey
-						std::string sPK = sType + "-" + sPrimaryKey + "-" + sIPFSHash;
-						std::string sRow = sPK + "<col>";
-						for (int i = 0; i < (int)vFields.size(); i++)
-						{
-							sRow += o[vFields[i]].getValStr() + "<col>";
-						}
-						sData += sRow + "<object>";
-					}
+					sRow += o[vFields[i]].getValStr() + "<col>";
 				}
+				sData += sRow + "<object>";
 			}
 		}
 	}
@@ -4033,27 +4132,24 @@ UniValue GetIPFSList(int iMaxAgeInDays, std::string& out_Files)
 	std::string sFiles = ""; // TODO:  Make this a map of files for PODS; for now this is OK for a proof-of-concept
 	double dCostPerByte = GetSporkDouble("ipfscostperbyte", .0002);
 	// Only include the IPFS hashes that actually paid the PODS fees
-    for(map<string,string>::iterator ii=mvApplicationCache.begin(); ii!=mvApplicationCache.end(); ++ii) 
-    {
-		std::string sKey = (*ii).first;
-	   	if (sKey.length() > sType.length())
+	std::vector<CAppCache::item_t> vItems = appCache.GetSection(sType);
+	for (int i = 0; i < (int)vItems.size(); i++)
+	{
+		std::string sPrimaryKey = vItems[i].first;
+		int64_t nTimestamp = vItems[i].second.nTimestamp;
+		if (nTimestamp > nMinStamp)
 		{
-			if (sKey.substr(0,sType.length())==sType)
+			std::string sValue = vItems[i].second.sValue;
+			// Only the fee paid with the attachment's latest memorized transaction counts
+			CIPFSFeeRecord fee;
+			if (!fee.FromString(ReadCache("IpfsFee", sPrimaryKey)) || fee.nTime != nTimestamp) continue;
+			double dPODSFeeCollected = fee.nFee;
+			double dSize = fee.nSize;
+			double dFee = dCostPerByte * dSize;
+			if (dPODSFeeCollected >= dFee && dPODSFeeCollected > 0)
 			{
-				std::string sPrimaryKey = sKey.substr(sType.length() + 1, sKey.length() - sType.length());
-		     	int64_t nTimestamp = mvApplicationCacheTimestamp[(*ii).first];
-				if (nTimestamp > nMinStamp)
-				{
-					std::string sValue = mvApplicationCache[(*ii).first];
-					double dPODSFeeCollected = cdbl(ReadCache("IpfsFee" + RoundToString(nTimestamp, 0), sPrimaryKey), 2);
-					double dSize = cdbl(ReadCache("IpfsSize" + RoundToString(nTimestamp, 0), sPrimaryKey), 0);
-					double dFee = dCostPerByte * dSize;
-					if (dPODSFeeCollected >= dFee && dPODSFeeCollected > 0)
-					{
-						ret.push_back(Pair(sPrimaryKey + " (" + sValue + ")", dPODSFeeCollected));
-						sFiles += sPrimaryKey + ";";
-					}
-				}
+				ret.push_back(Pair(sPrimaryKey + " (" + sValue + ")", dPODSFeeCollected));
+				sFiles += sPrimaryKey + ";";
 			}
 		}
 	}
@@ -4071,42 +4167,36 @@ UniValue GetDataList(std::string sType, int iMaxAgeInDays, int& iSpecificEntry,
 	ret.push_back(Pair("DataList",sType));
 	int iPos = 0;
 	int iTotalRecords = 0;
-    for(map<string,string>::iterator ii=mvApplicationCache.begin(); ii!=mvApplicationCache.end(); ++ii) 
-    {
-		std::string sKey = (*ii).first;
-	   	if (sKey.length() > sType.length())
+	std::vector<CAppCache::item_t> vItems = appCache.GetSection(sType);
+	for (int i = 0; i < (int)vItems.size(); i++)
+	{
+		std::string sPrimaryKey = vItems[i].first;
+		int64_t nTimestamp = vItems[i].second.nTimestamp;
+
+		if (nTimestamp > nEpoch || nTimestamp == 0)
 		{
-			if (sKey.substr(0,sType.length())==sType)
+			iTotalRecords++;
+			std::string sValue = vItems[i].second.sValue;
+			std::string sLongValue = sPrimaryKey + " - " + sValue;
+			if (iPos==iSpecificEntry) outEntry = sValue;
+			std::string sTimestamp = TimestampToHRDate((double)nTimestamp);
+			if (!sSearch.empty())
 			{
-				std::string sPrimaryKey = sKey.substr(sType.length() + 1, sKey.length() - sType.length());
-		     	int64_t nTimestamp = mvApplicationCacheTimestamp[(*ii).first];
-			
-				if (nTimestamp > nEpoch || nTimestamp == 0)
+				std::string sPK1 = sPrimaryKey;
+				std::string sPK2 = sValue;
+				boost::to_upper(sPK1);
+				boost::to_upper(sPK2);
+				boost::to_upper(sSearch);
+				if (Contains(sPK1, sSearch) || Contains(sPK2, sSearch))
 				{
-					iTotalRecords++;
-					std::string sValue = mvApplicationCache[(*ii).first];
-					std::string sLongValue = sPrimaryKey + " - " + sValue;
-					if (iPos==iSpecificEntry) outEntry = sValue;
-					std::string sTimestamp = TimestampToHRDate((double)nTimestamp);
-					if (!sSearch.empty())
-					{
-						std::string sPK1 = sPrimaryKey;
-						std::string sPK2 = sValue;
-						boost::to_upper(sPK1);
-						boost::to_upper(sPK2);
-						boost::to_upper(sSearch);
-						if (Contains(sPK1, sSearch) || Contains(sPK2, sSearch))
-						{
-							ret.push_back(Pair(sPrimaryKey + " (" + sTimestamp + ")", sValue));
-						}
-					}
-					else
-					{
-						ret.push_back(Pair(sPrimaryKey + " (" + sTimestamp + ")", sValue));
-					}
-					iPos++;
+					ret.push_back(Pair(sPrimaryKey + " (" + sTimestamp + ")", sValue));
 				}
 			}
+			else
+			{
+				ret.push_back(Pair(sPrimaryKey + " (" + sTimestamp + ")", sValue));
+			}
+			iPos++;
 		}
 	}
 	iSpecificEntry++;
@@ -4203,7 +4293,7 @@ UniValue GetLeaderboard(int nHeight)
 	vector<pair<double, std::string> > vLeaderboard;
     UniValue ret(UniValue::VOBJ);
    
-	if (ReadBlockFromDisk(block, pindex, consensusParams, "GetLeaderboard")) 
+	if (ReadBlockFromDisk(block, pindex, consensusParams)) 
 	{
 		  vLeaderboard.reserve(block.vtx[0].vout.size());
 		  for (unsigned int i = 1; i < block.vtx[0].vout.size(); i++)
@@ -4267,7 +4357,7 @@ UniValue ContributionReport()
 	for (int ii = nMinDepth; ii <= nMaxDepth; ii++)
 	{
    			CBlockIndex* pblockindex = FindBlockByHeight(ii);
-			if (ReadBlockFromDisk(block, pblockindex, consensusParams, "CONTRIBUTIONREPORT"))
+			if (ReadBlockFromDisk(block, pblockindex, consensusParams))
 			{
 				iProcessedBlocks++;
 				nEnd = ii;
@@ -4808,17 +4898,15 @@ bool PODCUpdate(std::string& sError, bool bForce, std::string sDebugInfo)
 std::string RetrieveDCCWithMaxAge(std::string cpid, int64_t iMaxSeconds)
 {
 	boost::to_upper(cpid); // CPID must be uppercase to retrieve
-    const std::string key = "DCC;" + cpid;
-    const std::string& value = mvApplicationCache[key];
-	const Consensus::Params& consensusParams = Params().GetConsensus();
-    int64_t iAge = chainActive.Tip() != NULL ? chainActive.Tip()->nTime - mvApplicationCacheTimestamp[key] : 0;
-	return (iAge > iMaxSeconds) ? "" : value;
+    CAppCacheEntry entry;
+    appCache.Read("DCC", cpid, entry);
+    int64_t iAge = chainActive.Tip() != NULL ? chainActive.Tip()->nTime - entry.nTimestamp : 0;
+	return (iAge > iMaxSeconds) ? "" : entry.sValue;
 }
 
 int64_t RetrieveCPIDAssociationTime(std::string cpid)
 {
-	std::string key = "DCC;" + cpid;
-	return mvApplicationCacheTimestamp[key];
+	return appCache.ReadTimestamp("DCC", cpid);
 }
 
 
@@ -4866,28 +4954,22 @@ UniValue UTXOReport(std::string sCPID)
 	for (; b > 1; b--)
 	{
 		CBlockIndex* pindex = FindBlockByHeight(b);
-		CBlock block;
-		if (ReadBlockFromDisk(block, pindex, consensusParams, "MemorizeBlockChainPrayers")) 
+		CBlockCache::block_ptr pblock;
+		if (ReadBlockFromDisk(pblock, pindex, consensusParams, BLOCK_READ_SKIP_POW)) 
 		{
+			const CBlock& block = *pblock;
 			iBlocks++;
 			if (iBlocks > (BLOCKS_PER_DAY*10)) break;
 			BOOST_FOREACH(const CTransaction &tx, block.vtx)
 			{
-				double dUTXOAmount = 0;
-				std::string sMsg = "";
-			
-				for (unsigned int i = 0; i < tx.vout.size(); i++)
-				{
-					sMsg += tx.vout[i].sTxOutMessage;
-					dUTXOAmount += tx.vout[i].nValue / COIN;
-				}
-				std::string sPODC = ExtractXML(sMsg, "<PODC_TASKS>", "</PODC_TASKS>");
-				if (!sPODC.empty())
+				// Shares the parse made when the block's prayers were memorized
+				TxMessage t = GetParsedTxMessage(tx, block.GetBlockTime());
+				double dUTXOAmount = t.dAmount;
+				if (!t.sPODCTasks.empty())
 				{
 					std::string sErr2 = "";
-					std::string sMySig = ExtractXML(sMsg,"<cpidsig>","</cpidsig>");
-					bool fSigChecked = VerifyCPIDSignature(sMySig, true, sErr2);
-					std::string sDiskCPID = GetElement(sMySig, ";", 0);
+					bool fSigChecked = VerifyCPIDSignature(t.sCPIDSig, true, sErr2);
+					std::string sDiskCPID = t.sCPID;
 					if (fSigChecked && sDiskCPID == sCPID)
 					{
 						dTotalAmount += dUTXOAmount;
@@ -4918,72 +5000,50 @@ UniValue UTXOReport(std::string sCPID)
 
 double GetUserMagnitude(std::string sListOfPublicKeys, double& nBudget, double& nTotalPaid, int& out_iLastSuperblock, std::string& out_Superblocks, int& out_SuperblockCount, int& out_HitCount, double& out_OneDayPaid, double& out_OneWeekPaid, double& out_OneDayBudget, double& out_OneWeekBudget)
 {
-	// Query actual magnitude from last superblock
-	const Consensus::Params& consensusParams = Params().GetConsensus();
-	int iNextSuperblock = 0;  
-	for (int b = chainActive.Tip()->nHeight; b > 1; b--)
-	{
-		int iLastSuperblock = GetLastDCSuperblockHeight(b + 1, iNextSuperblock);
-		if (iLastSuperblock == b)
+	// Query actual magnitude from the superblock payment index, newest superblock first
+	CAddressSet setAddresses(sListOfPublicKeys);
+	std::vector<int> vHeights = GetSuperblockPaymentHeights(chainActive.Tip()->nHeight);
+	for (unsigned int j = 0; j < vHeights.size(); j++)
+	{
+		int b = vHeights[j];
+		out_SuperblockCount++;
+		CSuperblockPayments payments;
+		if (!GetSuperblockPayments(b, payments)) continue;
+		nBudget = payments.nBudget / COIN;
+		nTotalPaid = 0;
+		double nTotalBlock = 0;
+		int Age = GetAdjustedTime() - payments.nTime;
+		for (unsigned int i = 0; i < payments.vPayments.size(); i++)
 		{
-			out_SuperblockCount++;
-			CBlockIndex* pindex = FindBlockByHeight(b);
-			CBlock block;
-			double nTotalBlock = 0;
-			if (ReadBlockFromDisk(block, pindex, consensusParams, "MemorizeBlockChainPrayers")) 
+			double dAmount = payments.vPayments[i].second / COIN;
+			nTotalBlock += dAmount;
+			if (setAddresses.Contains(payments.vPaymentKeys[i]))
 			{
-					  nBudget = CSuperblock::GetPaymentsLimit(iLastSuperblock) / COIN;
-					  nTotalPaid=0;
-					  nTotalBlock=0;
-					  int Age = GetAdjustedTime() - block.GetBlockTime();
-							
-					  for (unsigned int i = 1; i < block.vtx[0].vout.size(); i++)
-					  {
-				            std::string sRecipient = PubKeyToAddress(block.vtx[0].vout[i].scriptPubKey);
-							double dAmount = block.vtx[0].vout[i].nValue/COIN;
-							nTotalBlock += dAmount;
-							if (Contains(sListOfPublicKeys, sRecipient))
-							{
-								nTotalPaid += dAmount;
-								if (Age > 0 && Age < 86400)
-								{
-									out_OneDayPaid += dAmount;
-								}
-								if (Age > 0 && Age < (7 * 86400)) out_OneWeekPaid += dAmount;
-							}
-					  }
-					  if (nTotalBlock > (nBudget * .50) && nBudget > 0) 
-					  {
-						    if (out_iLastSuperblock == 0) out_iLastSuperblock = iLastSuperblock;
-						    out_Superblocks += RoundToString(b,0) + ",";
-							out_HitCount++;
-							if (Age > 0 && Age < 86400)
-							{
-								out_OneDayBudget += nBudget;
-							}
-							if (Age > 0 && Age < (7 * 86400)) 
-							{
-								out_OneWeekBudget += nBudget;
-							}
-							if (Age > (7 * 86400)) 
-							{
-								break;
-							}
-					  }
-				}
+				nTotalPaid += dAmount;
+				if (Age > 0 && Age < 86400) out_OneDayPaid += dAmount;
+				if (Age > 0 && Age < (7 * 86400)) out_OneWeekPaid += dAmount;
 			}
 		}
-		if (out_OneWeekBudget > 0)
+		if (nTotalBlock > (nBudget * .50) && nBudget > 0) 
 		{
-			mnMagnitude = out_OneWeekPaid / out_OneWeekBudget * 1000;
+			if (out_iLastSuperblock == 0) out_iLastSuperblock = b;
+			out_Superblocks += RoundToString(b,0) + ",";
+			out_HitCount++;
+			if (Age > 0 && Age < 86400) out_OneDayBudget += nBudget;
+			if (Age > 0 && Age < (7 * 86400)) out_OneWeekBudget += nBudget;
+			if (Age > (7 * 86400)) break;
 		}
-		if (out_OneDayBudget > 0)
-		{
-			mnMagnitudeOneDay = out_OneDayPaid / out_OneDayBudget * 1000;
-		}
-		out_Superblocks = ChopLast(out_Superblocks);
-			
-		return mnMagnitude;
+	}
+	if (out_OneWeekBudget > 0)
+	{
+		mnMagnitude = out_OneWeekPaid / out_OneWeekBudget * 1000;
+	}
+	if (out_OneDayBudget > 0)
+	{
+		mnMagnitudeOneDay = out_OneDayPaid / out_OneDayBudget * 1000;
+	}
+	out_Superblocks = ChopLast(out_Superblocks);
+	return mnMagnitude;
 }
 
 
@@ -5309,120 +5369,44 @@ std::string GetBoincTasksByHost(int iHostID, std::string sProjectId)
 }
 
 
-bool FilterPhase1(int iNextSuperblock, std::string sConcatCPIDs, std::string sSourcePath, std::string sTargetPath, std::vector<std::string> vCPIDs)
+static std::string GetDCCResearcherExtra(int iNextSuperblock, int64_t nMaxAge, const std::string& sCpid)
 {
-	boost::filesystem::path pathIn(sSourcePath);
-    std::ifstream streamIn;
-    streamIn.open(pathIn.string().c_str());
-	if (!streamIn) return false;
+	double dUTXOWeight = GetMatureMetric("UTXOWeight", sCpid, nMaxAge, iNextSuperblock);
+	double dTaskWeight = GetMatureMetric("TaskWeight", sCpid, nMaxAge, iNextSuperblock);
+	double dUnbanked = cdbl(ReadCacheWithMaxAge("Unbanked", sCpid, nMaxAge), 0);
+	std::string sExtra = "<utxoweight>" + RoundToString(dUTXOWeight, 0) 
+		+ "</utxoweight>\r\n<taskweight>" 
+		+ RoundToString(dTaskWeight, 0) + "</taskweight><unbanked>" + RoundToString(dUnbanked, 0) + "</unbanked>\r\n";
+	return sExtra;
+}
 
-	FILE *outFile = fopen(sTargetPath.c_str(), "w");
-	std::string sBuffer = "";
-	int iBuffer = 0;
-	
+bool FilterPhase1(int iNextSuperblock, const CCPIDSet& setConcatCPIDs, std::string sSourcePath, std::string sTargetPath, std::vector<std::string> vCPIDs)
+{
 	// Phase 1: Scan the Combined Researcher file for all Biblepay Researchers (who have associated BiblePay Keys with Research Projects)
-	// Filter the file down to BiblePay researchers:
-	int iLines = 0;
-	std::string sOutData = "";
-	std::string line;
+	// Filter the file down to BiblePay researchers; the file is streamed and each researcher is found with one hash lookup
+	DCCResearcherMap mapResearchers;
+	for (int i = 0; i < (int)vCPIDs.size(); i++)
+	{
+		std::string sBiblepayResearcher = GetDCCElement(vCPIDs[i], 0, false);
+		boost::to_upper(sBiblepayResearcher);
+		if (setConcatCPIDs.Contains(sBiblepayResearcher)) mapResearchers[sBiblepayResearcher]++;
+	}
     int64_t nMaxAge = (int64_t)GetSporkDouble("podcmaximumchatterage", (60 * 60 * 24));
-	 
-    while(std::getline(streamIn, line))
-    {
-		  std::string sCpid = ExtractXML(line,"<cpid>","</cpid>");
-		  sBuffer += line + "<ROW>";
-		  iBuffer++;
-		  iLines++;
-		  if (iLines % 2000000 == 0) LogPrintf(" Processing DCC Line %f ",(double)iLines);
-		  if (!sCpid.empty())
-		  {
-			 boost::to_upper(sCpid);
-			 if (Contains(sConcatCPIDs, sCpid))
-			 {
-				for (int i = 0; i < (int)vCPIDs.size(); i++)
-				{
-					std::string sBiblepayResearcher = GetDCCElement(vCPIDs[i], 0, false);
-					boost::to_upper(sBiblepayResearcher);
-					if (!sBiblepayResearcher.empty() && sBiblepayResearcher == sCpid)
-					{
-						for (int z = 0; z < 2; z++)
-						{
-							// Add in the User URL and Team
-							bool bAddlData = static_cast<bool>(std::getline(streamIn, line));
-							if (bAddlData) sBuffer += line + "<ROW>";
-						}
-
-						double dUTXOWeight = GetMatureMetric("UTXOWeight", sCpid, nMaxAge, iNextSuperblock);
-						double dTaskWeight = GetMatureMetric("TaskWeight", sCpid, nMaxAge, iNextSuperblock);
-						double dUnbanked = cdbl(ReadCacheWithMaxAge("Unbanked", sCpid, nMaxAge), 0);
-						std::string sExtra = "<utxoweight>" + RoundToString(dUTXOWeight, 0) 
-							+ "</utxoweight>\r\n<taskweight>" 
-							+ RoundToString(dTaskWeight, 0) + "</taskweight><unbanked>" + RoundToString(dUnbanked, 0) + "</unbanked>\r\n";
-						std::string sData = FilterBoincData(sBuffer, "<user>","</user>", sExtra);
-						sOutData += sData;
-						sBuffer = "";
-					}
-			 	}
-			 }
-			 else
-			 {
-				 sBuffer="";
-			 }
-		  }
-    }
-	fputs(sOutData.c_str(), outFile);
-	streamIn.close();
-    fclose(outFile);
-	return true;
+	return FilterDCCUserFile(sSourcePath, sTargetPath, mapResearchers, boost::bind(&GetDCCResearcherExtra, iNextSuperblock, nMaxAge, _1));
 }
 
 
 bool FilterPhase2(int iNextSuperblock, std::string sSourcePath, std::string sTargetPath, double dTargetTeam)
 {
-	boost::filesystem::path pathIn(sSourcePath);
-    std::ifstream streamIn;
-    streamIn.open(pathIn.string().c_str());
-	if (!streamIn) return false;
-
-	FILE *outFile = fopen(sTargetPath.c_str(), "w");
-	std::string sBuffer = "";
 	// This file is used by the faucets; Find all team members who are not necessarily yet associated in the chain:
-	std::string line;
-     
-    while(std::getline(streamIn, line))
-    {
-		  sBuffer += line;
-		  if (Contains(sBuffer,"</user>"))
-		  {
-			  	 std::string sCpid = ExtractXML(sBuffer,"<cpid>","</cpid>");
-				 double dTeamID = cdbl(ExtractXML(sBuffer,"<teamid>","</teamid>"), 0);
-				 double dRac = cdbl(ExtractXML(sBuffer,"<expavg_credit>","</expavg_credit>"), 0);
-				 double dTotalRAC = cdbl(ExtractXML(sBuffer,"<total_credit>","</total_credit>"), 0);
-				 double dCreated = cdbl(ExtractXML(sBuffer,"<create_time>","</create_time>"), 0);
-				 std::string sName = ExtractXML(sBuffer,"<name>","</name>");
-				 if (dTargetTeam == dTeamID)
-				 {
-					 std::string sRow = sCpid + "," + RoundToString(dTeamID,0) + "," + RoundToString(dRac,0) + "," + RoundToString(dTotalRAC,0) + "," + RoundToString(dCreated,0) + "," + sName + "\r\n";
-					 fputs(sRow.c_str(), outFile);
-				 }
-				 sBuffer="";
-		  }
-				 
-    }
-	streamIn.close();
-    fclose(outFile);
-	return true;
+	return FilterDCCTeamFile(sSourcePath, sTargetPath, dTargetTeam);
 }
 
 
-double GetRACFromPODCProject(int iNextSuperblock, std::string sFileName, std::string sResearcherCPID, double dDRMode, double dReqSPM, double dReqSPR, double dTeamRequired,
+double GetRACFromPODCProject(int iNextSuperblock, const CDCCTable& table, std::string sResearcherCPID, double dDRMode, double dReqSPM, double dReqSPR, double dTeamRequired,
 	double dProjectFactor, double dRACThreshhold, std::string sTeamBlacklist, double& out_Team)
 {
-	boost::filesystem::path pathFiltered(sFileName);
-	std::ifstream streamFiltered;
-    streamFiltered.open(pathFiltered.string().c_str());
-	if (!streamFiltered) return 0;
-	std::string sUser = "";
+	if (table.size() == 0) return 0;
 	int64_t nMaxAge = (int64_t)GetSporkDouble("podcmaximumchatterage", (60 * 60 * 24));
 	double dUTXOWeight = GetMatureMetric("UTXOWeight", sResearcherCPID, nMaxAge, iNextSuperblock);
 	double dTaskWeight = GetMatureMetric("TaskWeight", sResearcherCPID, nMaxAge, iNextSuperblock);
@@ -5432,28 +5416,16 @@ double GetRACFromPODCProject(int iNextSuperblock, std::string sFileName, std::st
 	double dTotalRAC = 0;
 	double dTotalFound = 0;
 	boost::to_upper(sResearcherCPID);
-	std::string line = "";
-    while(std::getline(streamFiltered, line))
-    {
-		sUser += line;
-		if (Contains(line, "</user>"))
-		{
-			std::string sCPID = ExtractXML(sUser, "<cpid>", "</cpid>");
-			boost::to_upper(sCPID);
-			if (sCPID == sResearcherCPID)
-			{
-				double dAvgCredit = cdbl(ExtractXML(sUser, "<expavg_credit>", "</expavg_credit>"), 4);
-				double dTeam = cdbl(ExtractXML(sUser, "<teamid>", "</teamid>"), 0);
-				out_Team = dTeam;
-				// if (fDebugMaster) LogPrintf(" CPID %s, ExtraRAC %f, Team %f, TeamReq %f  ", sCPID.c_str(), dModifiedCredit, dTeam, dTeamRequired);
-				double dPercent = GetTeamPercentage(dTeam, dTeamRequired, sTeamBlacklist, dNonBiblepayTeamPercentage);
-				double dModifiedCredit = GetResearcherCredit(dDRMode, dAvgCredit, dUTXOWeight, dTaskWeight, dUnbanked, dTotalRAC, dReqSPM, dReqSPR, dRACThreshhold, dPercent) * dProjectFactor;
-				dTotalFound += dModifiedCredit;
-			}
-			sUser = "";
-		}
-    }
-	streamFiltered.close();
+	const std::vector<unsigned int>& vRows = table.GetRows(sResearcherCPID);
+	for (int i = 0; i < (int)vRows.size(); i++)
+	{
+		double dAvgCredit = table.vCredit[vRows[i]];
+		double dTeam = table.vTeam[vRows[i]];
+		out_Team = dTeam;
+		double dPercent = GetTeamPercentage(dTeam, dTeamRequired, sTeamBlacklist, dNonBiblepayTeamPercentage);
+		double dModifiedCredit = GetResearcherCredit(dDRMode, dAvgCredit, dUTXOWeight, dTaskWeight, dUnbanked, dTotalRAC, dReqSPM, dReqSPR, dRACThreshhold, dPercent) * dProjectFactor;
+		dTotalFound += dModifiedCredit;
+	}
 	return dTotalFound;
 }
 
@@ -5507,6 +5479,44 @@ double GetMatureMetric(std::string sMetricName, std::string sPrimaryKey, int64_t
 		
 
 
+/** Number of threads FilterFile verifies researchers' tasks with */
+static const int DCC_VERIFY_THREADS = 8;
+
+/** What FilterFile gathers for one DCC record before anything is written to the cache */
+struct CDCCVerification
+{
+	std::string sCPID;
+	double dRosettaID;
+	double dUnbankedIndicator;
+	double dVerifyTasks;
+	CDCCVerification() : dRosettaID(0), dUnbankedIndicator(0), dVerifyTasks(0) {}
+};
+
+static void VerifyDCCThread(const std::vector<std::string>* pvCPIDs, std::vector<CDCCVerification>* pvVerified, size_t* pnNext, CCriticalSection* pcs,
+	int64_t nMaxAge, int iNextSuperblock, double dDRMode)
+{
+	while (true)
+	{
+		size_t i;
+		{
+			LOCK(*pcs);
+			if (*pnNext >= pvCPIDs->size()) return;
+			i = (*pnNext)++;
+		}
+		// Only reads the cache; each thread fills its own slots
+		const std::string& sDCC = (*pvCPIDs)[i];
+		CDCCVerification& v = (*pvVerified)[i];
+		v.sCPID = GetDCCElement(sDCC, 0, true);
+		v.dRosettaID = cdbl(GetDCCElement(sDCC, 3, false), 0);
+		v.dUnbankedIndicator = cdbl(GetDCCElement(sDCC, 5, false), 0);
+		if (v.dUnbankedIndicator == 1) v.sCPID = GetDCCElement(sDCC, 0, false);
+		if (v.sCPID.empty()) continue;
+		std::string sTaskList = GetMatureString("CPIDTasks", v.sCPID, nMaxAge, iNextSuperblock);
+		// R ANDREWS; 5-9-2018
+		if (dDRMode == 0 || dDRMode == 2) v.dVerifyTasks = VerifyTasks(v.sCPID, sTaskList);
+	}
+}
+
 bool FilterFile(int iBufferSize, int iNextSuperblock, std::string& sError)
 {
 	std::vector<std::string> vCPIDs = GetListOfDCCS("", false);
@@ -5544,39 +5554,43 @@ bool FilterFile(int iBufferSize, int iNextSuperblock, std::string& sError)
 
 	ClearCache("Unbanked");
 	double dDRMode = cdbl(GetSporkValue("dr"), 0);
-	for (int i = 0; i < (int)vCPIDs.size(); i++)
-	{
-		std::string sCPID1 = GetDCCElement(vCPIDs[i], 0, true);
-		double dRosettaID = cdbl(GetDCCElement(vCPIDs[i], 3, false), 0);
-		double dUnbankedIndicator = cdbl(GetDCCElement(vCPIDs[i], 5, false), 0);
-		if (dUnbankedIndicator==1) sCPID1 = GetDCCElement(vCPIDs[i], 0, false);
-		if (!sCPID1.empty())
+	// Each researcher's tasks are verified by the pool (these are network bound), then the results are merged in DCC order, so the cache and the contract come out the same as a serial pass
+	std::vector<CDCCVerification> vVerified(vCPIDs.size());
+	size_t nNext = 0;
+	CCriticalSection csNext;
+	boost::thread_group threads;
+	int nThreads = std::max(1, std::min(DCC_VERIFY_THREADS, (int)vCPIDs.size()));
+	for (int i = 0; i < nThreads; i++)
+		threads.create_thread(boost::bind(&VerifyDCCThread, &vCPIDs, &vVerified, &nNext, &csNext, nMaxAge, iNextSuperblock, dDRMode));
+	threads.join_all();
+
+	for (int i = 0; i < (int)vVerified.size(); i++)
+	{
+		const CDCCVerification& v = vVerified[i];
+		if (!v.sCPID.empty())
 		{
-			if (!sCPID1.empty()) sConcatCPIDs += sCPID1 + ",";
-			std::string sTaskList = GetMatureString("CPIDTasks", sCPID1, nMaxAge, iNextSuperblock);
-			double dVerifyTasks = 0;
-			// R ANDREWS; 5-9-2018
-			if (dDRMode == 0 || dDRMode == 2) dVerifyTasks = VerifyTasks(sCPID1, sTaskList);
-			WriteCache("TaskWeight", sCPID1, RoundToString(dVerifyTasks, 0), GetAdjustedTime());
-			if (dRosettaID > 0 && IsInList(sUnbankedList, ",", RoundToString(dRosettaID,0)))
+			sConcatCPIDs += v.sCPID + ",";
+			WriteCache("TaskWeight", v.sCPID, RoundToString(v.dVerifyTasks, 0), GetAdjustedTime());
+			if (v.dRosettaID > 0 && IsInList(sUnbankedList, ",", RoundToString(v.dRosettaID,0)))
 			{
-				WriteCache("Unbanked", sCPID1, "1", GetAdjustedTime());
+				WriteCache("Unbanked", v.sCPID, "1", GetAdjustedTime());
 			}
 			else
 			{
-				if (dUnbankedIndicator == 1)
+				if (v.dUnbankedIndicator == 1)
 				{
-					WriteCache("Unbanked", sCPID1, "0", GetAdjustedTime());
+					WriteCache("Unbanked", v.sCPID, "0", GetAdjustedTime());
 				}
 			}
 		}
 	}
 	boost::to_upper(sConcatCPIDs);
 	if (fDebugMaster) LogPrintf("Filter Phase 1: CPID List concatenated %s, unbanked %s  ",sConcatCPIDs.c_str(), sUnbankedList.c_str());
+	CCPIDSet setConcatCPIDs(sConcatCPIDs);
 
 	// Filter each BOINC Project file down to the individual BiblePay records
 
-	bool bResult = FilterPhase1(iNextSuperblock, sConcatCPIDs, sTarget, sFiltered, vCPIDs);
+	bool bResult = FilterPhase1(iNextSuperblock, setConcatCPIDs, sTarget, sFiltered, vCPIDs);
 	if (!bResult)
 	{
 		LogPrintf(" \n FilterFile::FilterPhase 1 failed. \n");
@@ -5595,15 +5609,20 @@ bool FilterFile(int iBufferSize, int iNextSuperblock, std::string& sError)
 	
     if (boost::filesystem::exists(sTarget2.c_str())) 
 	{
-		FilterPhase1(iNextSuperblock, sConcatCPIDs, sTarget2, sFiltered2, vCPIDs);
+		FilterPhase1(iNextSuperblock, setConcatCPIDs, sTarget2, sFiltered2, vCPIDs);
     }
 	bResult = FilterPhase2(iNextSuperblock, sTarget2, sTeamFile2, dTeamBackupProject);
 
 	//  Phase II : Normalize the file for Biblepay (this process asseses the magnitude of each BiblePay Researcher relative to one another, with 100 being the leader, 0 being a researcher with no activity)
 	//  We measure users by RAC - the BOINC Decay function: expavg_credit.  This is the half-life of the users cobblestone emission over a one month period.
 	
-	double dRAC1 = GetSumOfXMLColumnFromXMLFile(sFiltered, "<user>", "expavg_credit", dReqSPM, dReqSPR, dTeamRequired, sConcatCPIDs, dRACThreshhold, sTeamBlacklist, iNextSuperblock);
-	double dRAC2 = GetSumOfXMLColumnFromXMLFile(sFiltered2,"<user>", "expavg_credit", dReqSPM, dReqSPR, dTeamBackupProject, sConcatCPIDs, dRACThreshhold, sTeamBlacklist, iNextSuperblock);
+	// Both filtered files are parsed once here; the totals and every researcher's magnitude below are looked up in the tables
+	CDCCTable tableFiltered;
+	CDCCTable tableFiltered2;
+	tableFiltered.Load(sFiltered);
+	tableFiltered2.Load(sFiltered2);
+	double dRAC1 = GetSumOfDCCCredit(tableFiltered, dReqSPM, dReqSPR, dTeamRequired, setConcatCPIDs, dRACThreshhold, sTeamBlacklist, iNextSuperblock);
+	double dRAC2 = GetSumOfDCCCredit(tableFiltered2, dReqSPM, dReqSPR, dTeamBackupProject, setConcatCPIDs, dRACThreshhold, sTeamBlacklist, iNextSuperblock);
 	double dTotalRAC = dRAC1 + dRAC2;
 	LogPrintf(" \n FilterPhase2: Team %f, backupteam %f, Proj1 RAC %f, Proj2 RAC %f, Total RAC %f \n", dTeamRequired, dTeamBackupProject, dRAC1, dRAC2, dTotalRAC);
 	if (dTotalRAC < 10)
@@ -5659,9 +5678,9 @@ bool FilterFile(int iBufferSize, int iNextSuperblock, std::string& sError)
 				if (dTeamBackupProject > 0) 
 				{
 					// Note that dDR Mode is set to 3 so that we can penalize the user based on the TOTAL UTXO LEVEL BELOW, not once per project (since they fit in ONE UTXO LEVEL SLOT):
-					dWCGRAC = GetRACFromPODCProject(iNextSuperblock, sFiltered2, sCPID, 3, dReqSPM, dReqSPR, dTeamBackupProject, dBackupProjectFactor, dRACThreshhold, sTeamBlacklist, doutWCGTeam);
+					dWCGRAC = GetRACFromPODCProject(iNextSuperblock, tableFiltered2, sCPID, 3, dReqSPM, dReqSPR, dTeamBackupProject, dBackupProjectFactor, dRACThreshhold, sTeamBlacklist, doutWCGTeam);
 				}
-				double dRosettaRAC = GetRACFromPODCProject(iNextSuperblock, sFiltered, sCPID, 3, dReqSPM, dReqSPR, dTeamRequired, 1.0, dRACThreshhold, sTeamBlacklist, doutRAHTeam);
+				double dRosettaRAC = GetRACFromPODCProject(iNextSuperblock, tableFiltered, sCPID, 3, dReqSPM, dReqSPR, dTeamRequired, 1.0, dRACThreshhold, sTeamBlacklist, doutRAHTeam);
 
 				dTotalRosetta += dRosettaRAC;
 				dTotalWCG += dWCGRAC;
@@ -5758,53 +5777,27 @@ uint256 GetDCPAMHash(std::string sAddresses, std::string sAmounts)
 
 int GetLastDCSuperblockWithPayment(int nChainHeight)
 {
-	const Consensus::Params& consensusParams = Params().GetConsensus();
-	int iNextSuperblock = 0;  
-	for (int b = nChainHeight; b > 1; b--)
+	std::vector<int> vHeights = GetSuperblockPaymentHeights(nChainHeight);
+	for (unsigned int j = 0; j < vHeights.size(); j++)
 	{
-		int iLastSuperblock = GetLastDCSuperblockHeight(b+1, iNextSuperblock);
-		if (iLastSuperblock == b)
-		{
-			CBlockIndex* pindex = FindBlockByHeight(b);
-			CBlock block;
-			double nTotalBlock = 0;
-			if (ReadBlockFromDisk(block, pindex, consensusParams, "GetLastDCSuperblockWithPayments")) 
-			{
-				  double nBudget = CSuperblock::GetPaymentsLimit(iLastSuperblock) / COIN;
-				  nTotalBlock=0;
-				  for (unsigned int i = 1; i < block.vtx[0].vout.size(); i++)
-				  {
-						double dAmount = block.vtx[0].vout[i].nValue/COIN;
-						nTotalBlock += dAmount;
-				  }
-   				  if (nTotalBlock > (nBudget * .50) && nBudget > 0) return b;
-			}
-		}
+		CSuperblockPayments payments;
+		if (!GetSuperblockPayments(vHeights[j], payments)) continue;
+		double nBudget = payments.nBudget / COIN;
+		if (GetSuperblockTotalCoins(payments) > (nBudget * .50) && nBudget > 0) return vHeights[j];
 	}
 	return 0;
 }
 
 double GetBlockMagnitude(int nChainHeight)
 {
-	const Consensus::Params& consensusParams = Params().GetConsensus();
 	if (chainActive.Tip() == NULL) return 0;
 	if (nChainHeight < 1) return 0;
 	if (nChainHeight > chainActive.Tip()->nHeight) return 0;
 	int nHeight = GetLastDCSuperblockWithPayment(nChainHeight);
-	CBlockIndex* pindex = FindBlockByHeight(nHeight);
-	CBlock block;
-	double nParticipants = 0;
-	double nTotalBlock = 0;
-	if (ReadBlockFromDisk(block, pindex, consensusParams, "GetBlockMagnitude")) 
-	{
-		  for (unsigned int i = 1; i < block.vtx[0].vout.size(); i++)
-		  {
-				double dAmount = block.vtx[0].vout[i].nValue/COIN;
-				nTotalBlock += dAmount;
-				nParticipants++;
-		  }
-    }
-	if (nTotalBlock <= 20000) return 0;
+	CSuperblockPayments payments;
+	if (!GetSuperblockPayments(nHeight, payments)) return 0;
+	double nParticipants = payments.vPayments.size();
+	if (GetSuperblockTotalCoins(payments) <= 20000) return 0;
 	double dPODCDiff = pow(nParticipants, 1.4);
     return dPODCDiff;
 }
@@ -5833,34 +5826,20 @@ double GetPaymentByCPID(std::string CPID, int nHeight)
 
 
 	// 2-10-2018 - R ANDREWS - BIBLEPAY - Provide ability to return last payment amount (in most recent superblock) for a given CPID
-	const Consensus::Params& consensusParams = Params().GetConsensus();
 	int iNextSuperblock = 0;  
 	int iLastSuperblock = GetLastDCSuperblockHeight(chainActive.Tip()->nHeight, iNextSuperblock);
-	CBlockIndex* pindex = FindBlockByHeight(iLastSuperblock);
-	CBlock block;
-	double nTotalBlock = 0;
-	double nBudget = 0;
-	if (pindex == NULL) return -1;
-	double nTotalPaid=0;
-	nTotalBlock = 0;
-	if (ReadBlockFromDisk(block, pindex, consensusParams, "GetPaymentByCPID")) 
-	{
-		nBudget = CSuperblock::GetPaymentsLimit(iLastSuperblock) / COIN;
-		for (unsigned int i = 1; i < block.vtx[0].vout.size(); i++)
+	CSuperblockPayments payments;
+	if (!GetSuperblockPayments(iLastSuperblock, payments)) return -1;
+	double nBudget = payments.nBudget / COIN;
+	double nTotalBlock = GetSuperblockTotalCoins(payments);
+	double nTotalPaid = 0;
+	for (unsigned int i = 0; i < payments.vPayments.size(); i++)
+	{
+		if (payments.vPayments[i].first == sDCPK)
 		{
-			std::string sRecipient = PubKeyToAddress(block.vtx[0].vout[i].scriptPubKey);
-			double dAmount = block.vtx[0].vout[i].nValue/COIN;
-			nTotalBlock += dAmount;
-			if (Contains(sDCPK, sRecipient))
-			{
-				nTotalPaid += dAmount;
-			}
+			nTotalPaid += payments.vPayments[i].second / COIN;
 		}
 	}
-	else
-	{
-		return -1;
-	}
 	if (nBudget == 0 || nTotalBlock == 0) return -1;
 	if (nBudget < 21000 || nTotalBlock < 21000) return -1; 
 	bool bSuperblockHit = (nTotalBlock > (nBudget * .50) && nBudget > 0);
@@ -5933,7 +5912,7 @@ bool VoteForDistributedComputingContract(int nHeight, std::string sMyContract, s
 
 	if (sPaymentAddresses.empty() || sAmounts.empty())
 	{
-		sError = "nable to vote for DC Contract::Foreign addresses or amounts empty.";
+		sError = "nable to vote for DC Contract::Foreign addresses or amounts empty.";
 		return false;
 	}
 
@@ -6357,9 +6336,7 @@ bool SubmitDistributedComputingTrigger(std::string sHex, std::string& gobjecthas
 std::string GetSporkValue(std::string sKey)
 {
 	boost::to_upper(sKey);
-    const std::string key = "SPORK;" + sKey;
-    const std::string& value = mvApplicationCache[key];
-	return value;
+	return appCache.ReadValue("SPORK", sKey);
 }
 
 
@@ -6513,7 +6490,7 @@ double GetQTPhase(double dPrice, int nEventHeight, double& out_PriorPrice, doubl
 		if (pindex != NULL)
 		{
 			CBlock block;
-			if (ReadBlockFromDisk(block, pindex, consensusParams, "IsGovObjPaid")) 
+			if (ReadBlockFromDisk(block, pindex, consensusParams)) 
 			{
 				for (unsigned int i = 0; i < block.vtx[0].vout.size(); i++)
 				{
@@ -6668,68 +6645,47 @@ std::vector<std::string> GetListOfDCCS(std::string sSearch, bool fRequireSig)
 	std::string sType = "DCC";
 	std::string sOut = "";
 	boost::to_upper(sSearch);
-    for(map<string,string>::iterator ii=mvApplicationCache.begin(); ii!=mvApplicationCache.end(); ++ii) 
-    {
-		std::string sKey = (*ii).first;
-	   	if (sKey.length() > sType.length())
+	std::vector<CAppCache::item_t> vItems = appCache.GetSection(sType);
+	for (int i = 0; i < (int)vItems.size(); i++)
+	{
+		const std::string& sValue = vItems[i].second.sValue;
+		std::string sCPID = GetDCCElement(sValue, 0, fRequireSig);
+		std::string sAddress = GetDCCElement(sValue, 2, fRequireSig);
+		boost::to_upper(sAddress);
+		boost::to_upper(sCPID);
+		if (!sSearch.empty()) if (sSearch == sCPID || sSearch == sAddress)
 		{
-			if (sKey.substr(0,sType.length())==sType)
-			{
-				std::string sPrimaryKey = sKey.substr(sType.length() + 1, sKey.length() - sType.length());
-				std::string sValue = mvApplicationCache[(*ii).first];
-				std::string sCPID = GetDCCElement(sValue, 0, fRequireSig);
-				std::string sAddress = GetDCCElement(sValue, 2, fRequireSig);
-				boost::to_upper(sAddress);
-				boost::to_upper(sCPID);
-				if (!sSearch.empty()) if (sSearch == sCPID || sSearch == sAddress)
-				{
-					sOut += sValue + "<ROW>";
-				}
-				if (sSearch.empty() && !sCPID.empty()) sOut += sValue + "<ROW>";
-			}
+			sOut += sValue + "<ROW>";
 		}
+		if (sSearch.empty() && !sCPID.empty()) sOut += sValue + "<ROW>";
 	}
 	std::vector<std::string> vCPID = Split(sOut.c_str(), "<ROW>");
 	return vCPID;
 }
 
 
-double GetSumOfXMLColumnFromXMLFile(std::string sFileName, std::string sObjectName, std::string sElementName, double dReqSPM, double dReqSPR, double dTeamRequired, std::string sConcatCPIDs, 
+double GetSumOfDCCCredit(const CDCCTable& table, double dReqSPM, double dReqSPR, double dTeamRequired, const CCPIDSet& setConcatCPIDs, 
 	double dRACThreshhold, std::string sTeamBlacklist, int iNextSuperblock)
 {
-	boost::filesystem::path pathIn(sFileName);
-    std::ifstream streamIn;
-    streamIn.open(pathIn.string().c_str());
-	if (!streamIn) return 0;
+	// Sums the researchers' expavg_credit (adjusted by the DR mode and team) over the rows of a filtered DCC file, in file order
+	if (table.size() == 0) return 0;
 	double dTotal = 0;
-	std::string sLine = "";
-	std::string sBuffer = "";
 	double dDRMode = cdbl(GetSporkValue("dr"), 0);
 	double dNonBiblepayTeamPercentage = cdbl(GetSporkValue("nonbiblepayteampercentage"), 2);
-	//int64_t nMaxAge = (int64_t)GetSporkDouble("podcmaximumchatterage", (60 * 60 * 24));
 	
-    while(std::getline(streamIn, sLine))
-    {
-		sBuffer += sLine;
-	}
-	streamIn.close();
-   	std::vector<std::string> vRows = Split(sBuffer.c_str(), sObjectName);
-	for (int i = 0; i < (int)vRows.size(); i++)
-	{
-		std::string sData = vRows[i];
-		double dTeam = cdbl(ExtractXML(sData,"<teamid>","</teamid>"), 0);
-		double dUTXOWeight = cdbl(ExtractXML(sData,"<utxoweight>","</utxoweight>"), 0);
-		double dTaskWeight = cdbl(ExtractXML(sData,"<taskweight>","</taskweight>"), 0);
-		double dUnbanked = cdbl(ExtractXML(sData,"<unbanked>","</unbanked>"), 0);
-		std::string sCPID = ExtractXML(sData,"<cpid>","</cpid>");
-		boost::to_upper(sCPID);
-		if (Contains(sConcatCPIDs, sCPID))
+	for (int i = 0; i < (int)table.size(); i++)
+	{
+		double dTeam = table.vTeam[i];
+		double dUTXOWeight = table.vUTXOWeight[i];
+		double dTaskWeight = table.vTaskWeight[i];
+		double dUnbanked = table.vUnbanked[i];
+		const std::string& sCPID = table.vCPID[i];
+		if (setConcatCPIDs.Contains(sCPID))
 		{
 			double dTeamPercentage = GetTeamPercentage(dTeam, dTeamRequired, sTeamBlacklist, dNonBiblepayTeamPercentage);
 			if (dTeamPercentage > 0)
 			{
-				std::string sValue = ExtractXML(sData, "<" + sElementName + ">","</" + sElementName + ">");
-				double dAvgCredit = cdbl(sValue,2);
+				double dAvgCredit = table.vCreditTotal[i];
 				double dModifiedCredit = GetResearcherCredit(dDRMode, dAvgCredit, dUTXOWeight, dTaskWeight, dUnbanked, 0, dReqSPM, dReqSPR, dRACThreshhold, dTeamPercentage);
 				dTotal += dModifiedCredit;
 				if (fDebugMaster && false) LogPrintf(" Adding CPID %s, Team %f, modifiedrac %f from RAC %f  with nonbbptp %f   DRMode %f,  Grand Total %f \n", 
@@ -6894,7 +6850,7 @@ bool IsGovObjPaid(std::string sGobjId)
 					CBlock block;
 					std::string sBlockPayments = "";
 					std::string sBlockRecips = "";
-					if (ReadBlockFromDisk(block, pindex, consensusParams, "IsGovObjPaid")) 
+					if (ReadBlockFromDisk(block, pindex, consensusParams)) 
 					{
 						for (unsigned int i = 0; i < block.vtx[0].vout.size(); i++)
 						{
@@ -7318,6 +7274,8 @@ std::string StoreBusinessObjectWithPK(UniValue& oBusinessObject, std::string& sE
 	std::string sIPFSHash = SubmitBusinessObjectToIPFS(sJson, sError);
 	if (sError.empty())
 	{
+		// Keep our own copy, so indexing the object once it is memorized needs no download
+		GetBusinessObjectStore().Put(sIPFSHash, sJson);
 		double dStorageFee = 1;
 		std::string sTxId = "";
 		sTxId = SendBusinessObject(sOT, sPK + sSecondaryKey, sIPFSHash, dStorageFee, sSignKey, true, sError);
@@ -7336,6 +7294,8 @@ std::string StoreBusinessObject(UniValue& oBusinessObject, std::string& sError)
 	std::string sIPFSHash = SubmitBusinessObjectToIPFS(sJson, sError);
 	if (sError.empty())
 	{
+		// Keep our own copy, so indexing the object once it is memorized needs no download
+		GetBusinessObjectStore().Put(sIPFSHash, sJson);
 		double dStorageFee = 1;
 		std::string sTxId = "";
 		sTxId = SendBusinessObject(sPrimaryKey, sAddress + sSecondaryKey, sIPFSHash, dStorageFee, sAddress, true, sError);
@@ -7354,43 +7314,19 @@ void ClearFile(std::string sPath)
 
 std::string GetDataFromIPFS(std::string sURL, std::string& sError)
 {
-	std::string sPath = GetSANDirectory2() + "guid";
-	std::ofstream fd(sPath.c_str());
-	std::string sEmptyData = "";
-	fd.write(sEmptyData.c_str(), sizeof(char)*sEmptyData.size());
-	fd.close();
-
-	int i = ipfs_download(sURL, sPath, 15);
-	if (i != 1) 
+	std::string sData;
+	int i = IPFSGetString(sURL, 15, 25000000, sData);
+	if (i != IPFS_OK) 
 	{
 		sError = "IPFS Download error.";
 		return "";
 	}
-	boost::filesystem::path pathIn(sPath);
-    std::ifstream streamIn;
-    streamIn.open(pathIn.string().c_str());
-	if (!streamIn) 
-	{
-		sError = "FileSystem Error.";
-		return "";
-	}
-	std::string sLine = "";
-	std::string sJson = "";
-    while(std::getline(streamIn, sLine))
-    {
-		sJson += sLine;
-	}
-	streamIn.close();
-	return sJson;
+	// Callers have always received the lines joined
+	sData.erase(std::remove(sData.begin(), sData.end(), '\n'), sData.end());
+	return sData;
 }
 
 
-std::string GetJSONFromIPFS(std::string sHash, std::string& sError)
-{
-	std::string sURL = "http://ipfs.biblepay.org:8080/ipfs/" + sHash;
-	return GetDataFromIPFS(sURL, sError);
-}
-
 std::string ReadAllText(std::string sPath)
 {
 	boost::filesystem::path pathIn(sPath);
@@ -7419,16 +7355,12 @@ UniValue GetBusinessObject(std::string sType, std::string sPrimaryKey, std::stri
 		sError = "Object not found";
 		return o;
 	}
-	std::string sJson = GetJSONFromIPFS(sIPFSHash, sError);
-	//LogPrintf(" json %s ",sJson.c_str());
-
-	if (!sError.empty()) return o;
+	UniValue oStored(UniValue::VOBJ);
+	if (!GetBusinessObjectStore().Get(sIPFSHash, oStored, sError)) return o;
 	try  
 	{
-	    UniValue o(UniValue::VOBJ);
-	    o.read(sJson);
-		LogPrintf("objecttype %s ",o["objecttype"].get_str().c_str());
-		return o;
+		LogPrintf("objecttype %s ",oStored["objecttype"].get_str().c_str());
+		return oStored;
     }
     catch(std::exception& e) 
 	{
@@ -0,0 +1,126 @@
+// Copyright (c) 2017-2018 The Biblepay Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "stakeweight.h"
+
+#include "chainparams.h"
+#include "hash.h"
+#include "main.h"
+#include "tinyformat.h"
+
+void ParseStakeSignatures(const std::string& sXML, std::map<int, std::string>& mapSigs)
+{
+    static const std::string OPEN = "<SIG_";
+    mapSigs.clear();
+    for (size_t nPos = sXML.find(OPEN); nPos != std::string::npos; nPos = sXML.find(OPEN, nPos + 1)) {
+        // Only the tags ExtractXML would be asked for: "<SIG_" + RoundToString(n, 0) + ">"
+        size_t nDigits = nPos + OPEN.size();
+        size_t nEnd = nDigits;
+        while (nEnd < sXML.size() && nEnd - nDigits < 9 && sXML[nEnd] >= '0' && sXML[nEnd] <= '9')
+            nEnd++;
+        if (nEnd == nDigits || nEnd >= sXML.size() || sXML[nEnd] != '>')
+            continue;
+        if (sXML[nDigits] == '0' && nEnd - nDigits > 1)
+            continue;
+        int n = atoi(sXML.substr(nDigits, nEnd - nDigits).c_str());
+        if (mapSigs.count(n))
+            continue;
+        size_t nClose = sXML.find(strprintf("</SIG_%d>", n), nPos + 3);
+        mapSigs[n] = nClose == std::string::npos ? "" : sXML.substr(nEnd + 1, nClose - nEnd - 1);
+    }
+}
+
+CStakeWeightCache::CStakeWeightCache() : mapCoins(MAX_COINS), mapSignatures(MAX_SIGNATURES)
+{
+}
+
+bool CStakeWeightCache::GetCoin(const COutPoint& outpoint, int64_t& nTimeRet, CAmount& nAmountRet)
+{
+    // cs is never held while taking cs_main, as callers may already hold cs_main
+    CStakeCoin coin;
+    bool fCached;
+    {
+        LOCK(cs);
+        fCached = mapCoins.Get(outpoint, coin);
+    }
+    if (fCached) {
+        bool fActive;
+        {
+            LOCK(cs_main);
+            BlockMap::iterator mi = mapBlockIndex.find(coin.hashBlock);
+            fActive = mi != mapBlockIndex.end() && chainActive.Contains(mi->second);
+        }
+        if (fActive) {
+            nTimeRet = coin.nTime;
+            nAmountRet = coin.nAmount;
+            return true;
+        }
+        LOCK(cs);
+        mapCoins.Erase(outpoint);
+    }
+
+    CTransaction tx;
+    if (!GetTransaction(outpoint.hash, tx, Params().GetConsensus(), coin.hashBlock, true) || outpoint.n >= tx.vout.size())
+        return false;
+    bool fActive = false;
+    {
+        LOCK(cs_main);
+        BlockMap::iterator mi = mapBlockIndex.find(coin.hashBlock);
+        if (mi == mapBlockIndex.end() || !mi->second)
+            return false;
+        coin.nTime = mi->second->GetBlockTime();
+        coin.nAmount = tx.vout[outpoint.n].nValue;
+        fActive = chainActive.Contains(mi->second);
+    }
+    if (fActive) {
+        LOCK(cs);
+        mapCoins.Insert(outpoint, coin);
+    }
+    nTimeRet = coin.nTime;
+    nAmountRet = coin.nAmount;
+    return true;
+}
+
+uint256 CStakeWeightCache::GetSignatureKey(const uint256& txid, const std::string& sMessage, const std::vector<std::string>& vSigs)
+{
+    CHashWriter ss(SER_GETHASH, 0);
+    ss << txid << sMessage << vSigs;
+    return ss.GetHash();
+}
+
+bool CStakeWeightCache::GetSignatureResult(const uint256& key, bool& fSignedRet, std::string& sErrorRet) const
+{
+    LOCK(cs);
+    std::pair<bool, std::string> result;
+    if (!mapSignatures.Get(key, result))
+        return false;
+    fSignedRet = result.first;
+    sErrorRet = result.second;
+    return true;
+}
+
+void CStakeWeightCache::SetSignatureResult(const uint256& key, bool fSigned, const std::string& sError)
+{
+    LOCK(cs);
+    mapSignatures.Insert(key, std::make_pair(fSigned, sError));
+}
+
+size_t CStakeWeightCache::GetCoinCount() const
+{
+    LOCK(cs);
+    return mapCoins.GetSize();
+}
+
+void CStakeWeightCache::Clear()
+{
+    LOCK(cs);
+    mapCoins.Clear();
+    mapSignatures.Clear();
+}
+
+CStakeWeightCache& GetStakeWeightCache()
+{
+    static CStakeWeightCache cache;
+    return cache;
+}
@@ -0,0 +1,72 @@
+// Copyright (c) 2017-2018 The Biblepay Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_STAKEWEIGHT_H
+#define BITCOIN_STAKEWEIGHT_H
+
+#include "amount.h"
+#include "cachemap.h"
+#include "primitives/transaction.h"
+#include "sync.h"
+#include "uint256.h"
+
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+/** A coin spent by a Proof-of-Loyalty stake: the block that confirmed it, that block's time and the coin's value */
+struct CStakeCoin
+{
+    uint256 hashBlock;
+    int64_t nTime;
+    CAmount nAmount;
+
+    CStakeCoin() : nTime(0), nAmount(0) {}
+};
+
+/**
+ * Reads every <SIG_n> tag of a stake message in one pass. As with
+ * ExtractXML, the first tag for each n wins and an unclosed one reads as empty.
+ */
+void ParseStakeSignatures(const std::string& sXML, std::map<int, std::string>& mapSigs);
+
+/**
+ * What evaluating a Proof-of-Loyalty stake costs, kept between evaluations:
+ * the time and amount of each staked coin (a transaction lookup each), and
+ * whether a stake's signatures verified. The miner evaluates the same stake
+ * for every block template, so after the first template both are hits.
+ */
+class CStakeWeightCache
+{
+private:
+    mutable CCriticalSection cs;
+    CacheMap<COutPoint, CStakeCoin> mapCoins;
+    //! Signature key -> (all outputs signed, error of the first failure)
+    CacheMap<uint256, std::pair<bool, std::string> > mapSignatures;
+
+public:
+    static const size_t MAX_COINS = 10000;
+    static const size_t MAX_SIGNATURES = 1000;
+
+    CStakeWeightCache();
+
+    /**
+     * Time and amount of the coin at outpoint. Coins are only kept while their
+     * block is on the active chain; after a reorg they are looked up again.
+     */
+    bool GetCoin(const COutPoint& outpoint, int64_t& nTimeRet, CAmount& nAmountRet);
+
+    /** Identifies one signature check: the stake transaction, the signed message and the signature of each output */
+    static uint256 GetSignatureKey(const uint256& txid, const std::string& sMessage, const std::vector<std::string>& vSigs);
+    bool GetSignatureResult(const uint256& key, bool& fSignedRet, std::string& sErrorRet) const;
+    void SetSignatureResult(const uint256& key, bool fSigned, const std::string& sError);
+
+    size_t GetCoinCount() const;
+    void Clear();
+};
+
+CStakeWeightCache& GetStakeWeightCache();
+
+#endif // BITCOIN_STAKEWEIGHT_H
@@ -330,6 +330,62 @@ public:
 
 
 
+/** Read-only stream over a borrowed range of memory, such as a mapped file.
+ *
+ * Unlike CDataStream it never copies the underlying bytes; the caller must keep
+ * the range alive for as long as the reader is used.
+ */
+class CSpanReader
+{
+private:
+    const char* pbegin;
+    const char* pcur;
+    const char* pend;
+    int nType;
+    int nVersion;
+
+public:
+    CSpanReader(const char* pbeginIn, const char* pendIn, int nTypeIn, int nVersionIn)
+        : pbegin(pbeginIn), pcur(pbeginIn), pend(pendIn), nType(nTypeIn), nVersion(nVersionIn) {}
+
+    int GetType()                { return nType; }
+    int GetVersion()             { return nVersion; }
+
+    size_t size() const          { return pend - pcur; }
+    bool empty() const           { return pcur == pend; }
+    size_t GetPos() const        { return pcur - pbegin; }
+    const char* data() const     { return pcur; }
+
+    CSpanReader& read(char* pch, size_t nSize)
+    {
+        if (nSize > size())
+            throw std::ios_base::failure("CSpanReader::read: end of data");
+        memcpy(pch, pcur, nSize);
+        pcur += nSize;
+        return (*this);
+    }
+
+    /** Advance past nSize bytes, returning a pointer to them (no copy) */
+    const char* skip(size_t nSize)
+    {
+        if (nSize > size())
+            throw std::ios_base::failure("CSpanReader::skip: end of data");
+        const char* p = pcur;
+        pcur += nSize;
+        return p;
+    }
+
+    template<typename T>
+    CSpanReader& operator>>(T& obj)
+    {
+        // Unserialize from this stream
+        ::Unserialize(*this, obj, nType, nVersion);
+        return (*this);
+    }
+};
+
+
+
 /** Non-refcounted RAII wrapper for FILE*
  *
  * Will automatically close the file when it goes out of scope if not null.
@@ -0,0 +1,256 @@
+// Copyright (c) 2017-2018 The Biblepay Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "appcache.h"
+#include "appcachedb.h"
+
+#include "test/test_biblepay.h"
+#include "tinyformat.h"
+
+#include <boost/filesystem.hpp>
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(appcache_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(appcache_readwrite)
+{
+    CAppCache cache;
+    BOOST_CHECK(cache.Size() == 0);
+
+    cache.Write("PRAYER", "KEY1", "value1", 100);
+    cache.Write("prayer", "KEY2", "value2", 200);
+    cache.Write("DCC", "KEY1", "dcc1", 300);
+    BOOST_CHECK(cache.Size() == 3);
+
+    // sections are case insensitive, keys are not
+    CAppCacheEntry entry;
+    BOOST_CHECK(cache.Read("Prayer", "KEY2", entry));
+    BOOST_CHECK(entry.sValue == "value2" && entry.nTimestamp == 200);
+    BOOST_CHECK(!cache.Read("PRAYER", "key2", entry));
+    BOOST_CHECK(cache.ReadValue("DCC", "KEY1") == "dcc1");
+    BOOST_CHECK(cache.ReadValue("DCC", "KEY2") == "");
+    BOOST_CHECK(cache.ReadTimestamp("SPORK", "KEY1") == 0);
+
+    // overwriting keeps a single entry
+    cache.Write("PRAYER", "KEY1", "value3", 400);
+    BOOST_CHECK(cache.Size() == 3);
+    BOOST_CHECK(cache.ReadValue("PRAYER", "KEY1") == "value3");
+    BOOST_CHECK(cache.ReadTimestamp("PRAYER", "KEY1") == 400);
+
+    BOOST_CHECK(cache.Erase("PRAYER", "KEY1"));
+    BOOST_CHECK(!cache.Erase("PRAYER", "KEY1"));
+    BOOST_CHECK(cache.Size() == 2);
+
+    cache.ClearSection("prayer");
+    BOOST_CHECK(cache.Size() == 1);
+    BOOST_CHECK(cache.GetSection("PRAYER").empty());
+    BOOST_CHECK(cache.GetSectionNames().size() == 1);
+
+    cache.Clear();
+    BOOST_CHECK(cache.Size() == 0);
+}
+
+BOOST_AUTO_TEST_CASE(appcache_sections)
+{
+    CAppCache cache;
+    cache.Write("DCC", "C", "3", 1);
+    cache.Write("DCC", "A", "1", 1);
+    cache.Write("DCC", "B", "2", 1);
+    // A section scan must not pick up sections sharing a prefix
+    cache.Write("DCCX", "A", "x", 1);
+
+    std::vector<CAppCache::item_t> vItems = cache.GetSection("dcc");
+    BOOST_CHECK(vItems.size() == 3);
+    BOOST_CHECK(vItems[0].first == "A" && vItems[0].second.sValue == "1");
+    BOOST_CHECK(vItems[1].first == "B" && vItems[1].second.sValue == "2");
+    BOOST_CHECK(vItems[2].first == "C" && vItems[2].second.sValue == "3");
+
+    std::vector<std::string> vNames = cache.GetSectionNames();
+    BOOST_CHECK(vNames.size() == 2 && vNames[0] == "DCC" && vNames[1] == "DCCX");
+}
+
+BOOST_AUTO_TEST_CASE(appcache_section_stamp)
+{
+    CAppCache cache;
+    BOOST_CHECK(cache.GetSectionStamp("REVENUE") == 0);
+    cache.Write("REVENUE", "A", "hash1", 1);
+    uint64_t nStamp = cache.GetSectionStamp("revenue");
+    BOOST_CHECK(nStamp != 0);
+
+    // only new keys, new values and removals count
+    cache.Write("REVENUE", "A", "hash1", 2);
+    cache.Write("EXPENSE", "A", "hash2", 2);
+    BOOST_CHECK(cache.GetSectionStamp("REVENUE") == nStamp);
+    cache.Write("REVENUE", "A", "hash3", 3);
+    BOOST_CHECK(cache.GetSectionStamp("REVENUE") != nStamp);
+    nStamp = cache.GetSectionStamp("REVENUE");
+    cache.Write("REVENUE", "B", "hash4", 3);
+    BOOST_CHECK(cache.GetSectionStamp("REVENUE") != nStamp);
+    nStamp = cache.GetSectionStamp("REVENUE");
+    cache.Erase("REVENUE", "B");
+    BOOST_CHECK(cache.GetSectionStamp("REVENUE") != nStamp);
+
+    cache.ClearSection("REVENUE");
+    BOOST_CHECK(cache.GetSectionStamp("REVENUE") == 0);
+    cache.Write("REVENUE", "A", "hash3", 4);
+    BOOST_CHECK(cache.GetSectionStamp("REVENUE") != nStamp);
+}
+
+BOOST_AUTO_TEST_CASE(appcache_purge)
+{
+    CAppCache cache;
+    for (int i = 0; i < 100; i++)
+        cache.Write("UTXOWEIGHT", strprintf("K%d", i), "v", 1000 + i);
+    cache.Write("UNBANKED", "K0", "v", 0);
+
+    // rewriting an entry moves it in the time index
+    cache.Write("UTXOWEIGHT", "K0", "v", 5000);
+
+    BOOST_CHECK(cache.PurgeSection("UTXOWEIGHT", 1050) == 49);
+    BOOST_CHECK(cache.Size() == 52);
+    BOOST_CHECK(cache.ReadValue("UTXOWEIGHT", "K0") == "v");
+    BOOST_CHECK(cache.ReadValue("UTXOWEIGHT", "K49") == "");
+    BOOST_CHECK(cache.ReadValue("UTXOWEIGHT", "K50") == "v");
+    BOOST_CHECK(cache.ReadValue("UNBANKED", "K0") == "v");
+
+    BOOST_CHECK(cache.PurgeSection("UTXOWEIGHT", 10000) == 51);
+    BOOST_CHECK(cache.GetSection("UTXOWEIGHT").empty());
+    BOOST_CHECK(cache.PurgeSection("MISSING", 10000) == 0);
+    BOOST_CHECK(cache.Size() == 1);
+}
+
+BOOST_AUTO_TEST_CASE(appcache_journal)
+{
+    CAppCache cache;
+    cache.Write("PRAYER", "A", "1", 1);
+    std::vector<CAppCacheRecord> vRecords;
+    cache.TakeJournal(vRecords);
+    BOOST_CHECK(vRecords.empty());
+
+    cache.SetJournal(true);
+    cache.Write("PRAYER", "B", "2", 2);
+    cache.Write("PRAYER", "B", "3", 3);
+    cache.Erase("PRAYER", "A");
+    cache.Write("SPORK", "X", "x", 4);
+    cache.ClearSection("SPORK");
+    cache.Write("SPORK", "Y", "y", 5);
+    cache.TakeJournal(vRecords);
+
+    // Replaying the journal onto the old state reproduces the new state
+    CAppCache replica;
+    replica.Write("PRAYER", "A", "1", 1);
+    replica.Write("SPORK", "OLD", "o", 1);
+    replica.Apply(vRecords);
+    BOOST_CHECK(replica.Size() == 2);
+    BOOST_CHECK(replica.ReadValue("PRAYER", "B") == "3");
+    BOOST_CHECK(replica.ReadTimestamp("PRAYER", "B") == 3);
+    BOOST_CHECK(replica.ReadValue("SPORK", "Y") == "y");
+    BOOST_CHECK(replica.ReadValue("SPORK", "OLD") == "");
+
+    cache.TakeJournal(vRecords);
+    BOOST_CHECK(vRecords.empty());
+}
+
+BOOST_AUTO_TEST_CASE(appcache_keypool)
+{
+    CAppCacheKeyPool pool;
+    CAppCacheKeyPool::id_t idA = pool.Acquire("A");
+    CAppCacheKeyPool::id_t idB = pool.Acquire("BB");
+    BOOST_CHECK(pool.Acquire("A") == idA);
+    BOOST_CHECK(pool.size() == 2);
+    BOOST_CHECK(pool.Get(idB) == "BB");
+
+    CAppCacheKeyPool::id_t id;
+    pool.Release(idA);
+    BOOST_CHECK(pool.Find("A", id) && id == idA);
+    pool.Release(idA);
+    BOOST_CHECK(!pool.Find("A", id));
+    BOOST_CHECK(pool.size() == 1);
+    // Released ids are handed out again
+    BOOST_CHECK(pool.Acquire("C") == idA);
+    BOOST_CHECK(pool.Get(idA) == "C");
+
+    // Churn leaves the arena bounded by the live keys
+    for (int i = 0; i < 20000; i++)
+        pool.Release(pool.Acquire(strprintf("%064d", i)));
+    BOOST_CHECK(pool.size() == 2);
+    BOOST_CHECK(pool.ArenaSize() < 20000 * 64 / 2);
+    BOOST_CHECK(pool.Get(idB) == "BB" && pool.Get(idA) == "C");
+}
+
+BOOST_AUTO_TEST_CASE(appcache_shared_keys)
+{
+    CAppCache cache;
+    std::string sCPID = "00112233445566778899AABBCCDDEEFF";
+    cache.Write("DCC", sCPID, "dcc", 1);
+    cache.Write("UTXOWEIGHT", sCPID, "100", 1);
+    cache.Write("TASKWEIGHT", sCPID, "50", 1);
+    BOOST_CHECK(cache.Size() == 3);
+    BOOST_CHECK(cache.KeyCount() == 1);
+
+    cache.SetJournal(true);
+    cache.Erase("DCC", sCPID);
+    cache.ClearSection("UTXOWEIGHT");
+    BOOST_CHECK(cache.PurgeSection("TASKWEIGHT", 2) == 1);
+    BOOST_CHECK(cache.Size() == 0);
+    BOOST_CHECK(cache.GetSectionNames().empty());
+    // The journal still needs the key to record the erase
+    BOOST_CHECK(cache.KeyCount() == 1);
+    std::vector<CAppCacheRecord> vRecords;
+    cache.TakeJournal(vRecords);
+    BOOST_CHECK(vRecords.size() == 3);
+    BOOST_CHECK(cache.KeyCount() == 0);
+
+    CAppCache replica;
+    replica.Write("DCC", sCPID, "dcc", 1);
+    replica.Write("TASKWEIGHT", sCPID, "50", 1);
+    replica.Apply(vRecords);
+    BOOST_CHECK(replica.Size() == 0);
+    BOOST_CHECK(replica.KeyCount() == 0);
+}
+
+BOOST_AUTO_TEST_CASE(appcachedb_snapshot_and_deltas)
+{
+    boost::filesystem::path ph = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+    CAppCacheDB db;
+    db.SetPath(ph);
+
+    CAppCache cache;
+    BOOST_CHECK(db.Load(cache) == -1);
+    for (int i = 0; i < 50; i++)
+        cache.Write("DCC", strprintf("CPID%d", i), strprintf("value%d", i), 1000 + i);
+    cache.Write("MESSAGE", "EMPTY", "", 1);
+    BOOST_CHECK(db.Flush(cache, 100));
+    uintmax_t nSnapshotSize = boost::filesystem::file_size(ph);
+
+    // Later flushes only append the changes
+    cache.Write("DCC", "CPID0", "changed", 2000);
+    cache.Erase("DCC", "CPID1");
+    BOOST_CHECK(db.Flush(cache, 101));
+    BOOST_CHECK(db.Flush(cache, 102));
+    BOOST_CHECK(boost::filesystem::file_size(ph) > nSnapshotSize);
+    BOOST_CHECK(boost::filesystem::file_size(ph) < nSnapshotSize * 2);
+
+    CAppCache loaded;
+    CAppCacheDB db2;
+    db2.SetPath(ph);
+    BOOST_CHECK(db2.Load(loaded) == 101);
+    BOOST_CHECK(loaded.Size() == 49);
+    BOOST_CHECK(loaded.ReadValue("DCC", "CPID0") == "changed");
+    BOOST_CHECK(loaded.ReadTimestamp("DCC", "CPID0") == 2000);
+    BOOST_CHECK(loaded.ReadValue("DCC", "CPID1") == "");
+    BOOST_CHECK(loaded.ReadValue("DCC", "CPID49") == "value49");
+
+    // A torn append is ignored, and everything before it still loads
+    FILE* file = fopen(ph.string().c_str(), "ab");
+    fwrite("garbage", 1, 7, file);
+    fclose(file);
+    CAppCache torn;
+    BOOST_CHECK(db2.Load(torn) == 101);
+    BOOST_CHECK(torn.Size() == 49);
+
+    boost::filesystem::remove(ph);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
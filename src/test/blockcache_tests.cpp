@@ -0,0 +1,139 @@
+// Copyright (c) 2017-2018 The Biblepay Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "blockcache.h"
+#include "chainparams.h"
+#include "clientversion.h"
+#include "main.h"
+#include "random.h"
+#include "streams.h"
+#include "util.h"
+#include "test/test_biblepay.h"
+
+#include <boost/filesystem.hpp>
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(blockcache_tests, BasicTestingSetup)
+
+static CBlockCache::block_ptr MakeBlock(unsigned int nNonce)
+{
+    CBlock* pblock = new CBlock();
+    pblock->nNonce = nNonce;
+    return CBlockCache::block_ptr(pblock);
+}
+
+BOOST_AUTO_TEST_CASE(blockcache_lru)
+{
+    CBlockCache cache(300);
+    uint256 hash1 = GetRandHash(), hash2 = GetRandHash(), hash3 = GetRandHash();
+    CBlockCache::block_ptr pblock;
+    BOOST_CHECK(!cache.Get(hash1, false, pblock));
+
+    cache.Insert(hash1, MakeBlock(1), 100, true);
+    cache.Insert(hash2, MakeBlock(2), 100, true);
+    BOOST_CHECK(cache.Get(hash1, true, pblock) && pblock->nNonce == 1);
+
+    // hash2 is the least recently used now, and makes way
+    cache.Insert(hash3, MakeBlock(3), 150, true);
+    BOOST_CHECK(!cache.Get(hash2, false, pblock));
+    BOOST_CHECK(cache.Get(hash1, false, pblock));
+    BOOST_CHECK(cache.Get(hash3, false, pblock) && pblock->nNonce == 3);
+
+    CBlockCacheStats stats = cache.GetStats();
+    BOOST_CHECK_EQUAL(stats.nBlocks, 2U);
+    BOOST_CHECK_EQUAL(stats.nBytes, 250U);
+    BOOST_CHECK_EQUAL(stats.nHits, 3U);
+    BOOST_CHECK_EQUAL(stats.nMisses, 2U);
+
+    // Too large to keep at all
+    cache.Insert(hash2, MakeBlock(2), 301, true);
+    BOOST_CHECK(!cache.Get(hash2, false, pblock));
+
+    cache.Erase(hash1);
+    BOOST_CHECK(!cache.Get(hash1, false, pblock));
+    cache.SetMaxSize(100);
+    BOOST_CHECK(!cache.Get(hash3, false, pblock));
+    BOOST_CHECK_EQUAL(cache.GetStats().nBytes, 0U);
+}
+
+BOOST_AUTO_TEST_CASE(blockcache_pow_checked)
+{
+    CBlockCache cache(1000);
+    uint256 hash = GetRandHash();
+    CBlockCache::block_ptr pblock;
+
+    // A block read without its proof of work checked only serves reads that skip the check
+    cache.Insert(hash, MakeBlock(1), 100, false);
+    BOOST_CHECK(cache.Get(hash, false, pblock));
+    BOOST_CHECK(!cache.Get(hash, true, pblock));
+    cache.Insert(hash, MakeBlock(1), 100, true);
+    BOOST_CHECK(cache.Get(hash, true, pblock));
+    cache.Insert(hash, MakeBlock(1), 100, false);
+    BOOST_CHECK(cache.Get(hash, true, pblock));
+    BOOST_CHECK_EQUAL(cache.GetStats().nBlocks, 1U);
+
+    cache.Clear();
+    BOOST_CHECK(!cache.Get(hash, false, pblock));
+}
+
+static CDiskBlockPos AppendBlock(const CBlock& block)
+{
+    CDiskBlockPos pos(0, 0);
+    FILE* file = fopen(GetBlockPosFilename(pos, "blk").string().c_str(), "ab");
+    CAutoFile fileout(file, SER_DISK, CLIENT_VERSION);
+    fseek(file, 0, SEEK_END);
+    fileout << FLATDATA(Params().MessageStart()) << (unsigned int)::GetSerializeSize(block, SER_DISK, CLIENT_VERSION);
+    pos.nPos = ftell(file);
+    fileout << block;
+    return pos;
+}
+
+BOOST_AUTO_TEST_CASE(blockcache_mapped_files)
+{
+    boost::filesystem::path pathTemp = GetTempPath() / strprintf("test_biblepay_%lu_%i", (unsigned long)GetTime(), (int)(GetRand(100000)));
+    boost::filesystem::create_directories(pathTemp / "blocks");
+    mapArgs["-datadir"] = pathTemp.string();
+    ClearDatadirCache();
+
+    CBlockFileCache files;
+    CBlock block;
+    size_t nSize = 0;
+    BOOST_CHECK(!files.ReadBlock(CDiskBlockPos(0, 8), block, nSize));
+
+    CBlock blockA = *MakeBlock(1);
+    CDiskBlockPos posA = AppendBlock(blockA);
+    BOOST_CHECK(files.ReadBlock(posA, block, nSize));
+    BOOST_CHECK(block.GetHash() == blockA.GetHash());
+    BOOST_CHECK_EQUAL(nSize, ::GetSerializeSize(blockA, SER_DISK, CLIENT_VERSION));
+
+    // The file grows past its map while it stays mapped
+    CBlock blockB = *MakeBlock(2);
+    CDiskBlockPos posB = AppendBlock(blockB);
+    {
+        CBlockFileScan scan;
+        BOOST_CHECK(files.ReadBlock(posB, block, nSize));
+        BOOST_CHECK(block.GetHash() == blockB.GetHash());
+    }
+    BOOST_CHECK(files.ReadBlock(posA, block, nSize));
+    BOOST_CHECK(block.GetHash() == blockA.GetHash());
+
+    size_t nOpen;
+    uint64_t nOpens, nReads;
+    files.GetStats(nOpen, nOpens, nReads);
+    BOOST_CHECK_EQUAL(nOpen, 1U);
+    BOOST_CHECK_EQUAL(nOpens, 2U);
+    BOOST_CHECK_EQUAL(nReads, 3U);
+
+    // Past the end of the file
+    BOOST_CHECK(!files.ReadBlock(CDiskBlockPos(0, posB.nPos + 1000), block, nSize));
+    files.Close(0);
+    files.GetStats(nOpen, nOpens, nReads);
+    BOOST_CHECK_EQUAL(nOpen, 0U);
+
+    mapArgs.erase("-datadir");
+    ClearDatadirCache();
+    boost::filesystem::remove_all(pathTemp);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,228 @@
+// Copyright (c) 2017-2018 The Biblepay Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "appcache.h"
+#include "bostore.h"
+#include "test/test_biblepay.h"
+
+#include <map>
+
+#include <boost/bind.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
+#include <boost/test/unit_test.hpp>
+
+namespace {
+
+/** Stands in for the IPFS gateway: serves a fixed set of objects and counts the downloads */
+class CTestGateway
+{
+public:
+    std::map<std::string, std::string> mapObjects;
+    CCriticalSection cs;
+    int nRequests;
+
+    CTestGateway() : nRequests(0) {}
+
+    bool Fetch(const std::string& sHash, const std::string& sPath)
+    {
+        std::string sData;
+        {
+            LOCK(cs);
+            nRequests++;
+            std::map<std::string, std::string>::const_iterator it = mapObjects.find(sHash);
+            if (it == mapObjects.end())
+                return false;
+            sData = it->second;
+        }
+        boost::filesystem::ofstream stream(sPath);
+        stream << sData;
+        return true;
+    }
+};
+
+/** Loads the objects of a CTestGateway the way GetBusinessObject does, counting the loads */
+class CTestLoader
+{
+public:
+    CAppCache& cache;
+    CTestGateway& gateway;
+    int nLoads;
+
+    CTestLoader(CAppCache& cacheIn, CTestGateway& gatewayIn) : cache(cacheIn), gateway(gatewayIn), nLoads(0) {}
+
+    bool Load(const std::string& sType, const std::string& sPrimaryKey, UniValue& o)
+    {
+        nLoads++;
+        std::map<std::string, std::string>::const_iterator it = gateway.mapObjects.find(cache.ReadValue(sType, sPrimaryKey));
+        return it != gateway.mapObjects.end() && o.read(it->second);
+    }
+};
+
+} // namespace
+
+BOOST_FIXTURE_TEST_SUITE(bostore_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(bostore_get)
+{
+    boost::filesystem::path pathStore = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+    CTestGateway gateway;
+    gateway.mapObjects["QmObjectA"] = "{\"objecttype\": \"contact\",\n \"email\": \"a@example.com\"}";
+    gateway.mapObjects["QmObjectB"] = "not json";
+
+    CBusinessObjectStore store(pathStore.string(), boost::bind(&CTestGateway::Fetch, &gateway, _1, _2));
+    UniValue o(UniValue::VOBJ);
+    std::string sError;
+    BOOST_CHECK(store.Get("QmObjectA", o, sError));
+    BOOST_CHECK(sError.empty());
+    BOOST_CHECK_EQUAL(o["email"].get_str(), "a@example.com");
+    BOOST_CHECK(store.Have("QmObjectA"));
+
+    // Served from memory, then from disk, without another download
+    BOOST_CHECK(store.Get("QmObjectA", o, sError));
+    CBusinessObjectStore store2(pathStore.string(), boost::bind(&CTestGateway::Fetch, &gateway, _1, _2));
+    BOOST_CHECK(store2.Get("QmObjectA", o, sError));
+    BOOST_CHECK_EQUAL(o["objecttype"].get_str(), "contact");
+    BOOST_CHECK_EQUAL(gateway.nRequests, 1);
+
+    BOOST_CHECK(!store.Get("QmMissing", o, sError));
+    BOOST_CHECK_EQUAL(sError, "IPFS Download error.");
+    BOOST_CHECK(!store.Have("QmMissing"));
+    sError.clear();
+    BOOST_CHECK(!store.Get("QmObjectB", o, sError));
+    BOOST_CHECK(!sError.empty());
+    sError.clear();
+    BOOST_CHECK(!store.Get("../QmObjectA", o, sError));
+    BOOST_CHECK(!sError.empty());
+
+    // Objects are written once; no temporary files are left behind
+    BOOST_CHECK(store.Put("QmObjectC", "{}"));
+    BOOST_CHECK(store.Put("QmObjectC", "{\"changed\": 1}"));
+    std::string sData;
+    BOOST_CHECK(store.Read("QmObjectC", sData, sError));
+    BOOST_CHECK_EQUAL(sData, "{}");
+    int nFiles = 0;
+    for (boost::filesystem::directory_iterator it(pathStore); it != boost::filesystem::directory_iterator(); ++it)
+        nFiles++;
+    BOOST_CHECK_EQUAL(nFiles, 3);
+
+    boost::filesystem::remove_all(pathStore);
+}
+
+BOOST_AUTO_TEST_CASE(bostore_check_content)
+{
+    // What ipfs add gives for "hello world\n", as a CIDv0 and as a raw CIDv1
+    std::string sHello = "hello world\n";
+    BOOST_CHECK(CBusinessObjectStore::CheckContent("QmT78zSuBmuS4z925WZfrqQ1qHaJ56DQaTfyMUF7F8ff5o", sHello));
+    BOOST_CHECK(CBusinessObjectStore::CheckContent("bafkreifjjcie6lypi6ny7amxnfftagclbuxndqonfipmb64f2km2devei4", sHello));
+    BOOST_CHECK(!CBusinessObjectStore::CheckContent("QmT78zSuBmuS4z925WZfrqQ1qHaJ56DQaTfyMUF7F8ff5o", "hello world"));
+    BOOST_CHECK(!CBusinessObjectStore::CheckContent("QmT78zSuBmuS4z925WZfrqQ1qHaJ56DQaTfyMUF7F8ff5o", "<html>502 Bad Gateway</html>"));
+    BOOST_CHECK(!CBusinessObjectStore::CheckContent("bafkreifjjcie6lypi6ny7amxnfftagclbuxndqonfipmb64f2km2devei4", "hello"));
+    BOOST_CHECK(!CBusinessObjectStore::CheckContent("QmObjectA", ""));
+    // Hashes that cannot be checked locally only need some content
+    BOOST_CHECK(CBusinessObjectStore::CheckContent("QmObjectA", "{}"));
+
+    boost::filesystem::path pathStore = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+    CTestGateway gateway;
+    gateway.mapObjects["QmT78zSuBmuS4z925WZfrqQ1qHaJ56DQaTfyMUF7F8ff5o"] = "hello wor";
+    CBusinessObjectStore store(pathStore.string(), boost::bind(&CTestGateway::Fetch, &gateway, _1, _2));
+    std::string sData, sError;
+    BOOST_CHECK(!store.Read("QmT78zSuBmuS4z925WZfrqQ1qHaJ56DQaTfyMUF7F8ff5o", sData, sError));
+    BOOST_CHECK(!store.Have("QmT78zSuBmuS4z925WZfrqQ1qHaJ56DQaTfyMUF7F8ff5o"));
+    gateway.mapObjects["QmT78zSuBmuS4z925WZfrqQ1qHaJ56DQaTfyMUF7F8ff5o"] = sHello;
+    BOOST_CHECK(store.Read("QmT78zSuBmuS4z925WZfrqQ1qHaJ56DQaTfyMUF7F8ff5o", sData, sError));
+    BOOST_CHECK_EQUAL(sData, sHello);
+    BOOST_CHECK_EQUAL(gateway.nRequests, 2);
+    boost::filesystem::remove_all(pathStore);
+}
+
+BOOST_AUTO_TEST_CASE(bostore_prefetch)
+{
+    boost::filesystem::path pathStore = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+    CTestGateway gateway;
+    std::vector<std::string> vHashes;
+    for (int i = 0; i < 20; i++) {
+        std::string sHash = "QmObject" + std::to_string(i);
+        gateway.mapObjects[sHash] = "{\"amount\": " + std::to_string(i) + "}";
+        vHashes.push_back(sHash);
+    }
+    vHashes.push_back("QmObject3");
+    vHashes.push_back("QmMissing");
+    vHashes.push_back("");
+
+    CBusinessObjectStore store(pathStore.string(), boost::bind(&CTestGateway::Fetch, &gateway, _1, _2));
+    store.Prefetch(vHashes, 4);
+    BOOST_CHECK_EQUAL(gateway.nRequests, 21);
+    for (int i = 0; i < 20; i++) {
+        UniValue o(UniValue::VOBJ);
+        std::string sError;
+        BOOST_CHECK(store.Get(vHashes[i], o, sError));
+        BOOST_CHECK_EQUAL(o["amount"].get_int(), i);
+    }
+    BOOST_CHECK_EQUAL(gateway.nRequests, 21);
+
+    // Only the object that could not be downloaded is requested again
+    store.Prefetch(vHashes, 4);
+    BOOST_CHECK_EQUAL(gateway.nRequests, 22);
+
+    boost::filesystem::remove_all(pathStore);
+}
+
+BOOST_AUTO_TEST_CASE(bostore_index)
+{
+    CAppCache cache;
+    CTestGateway gateway;
+    CTestLoader loader(cache, gateway);
+    gateway.mapObjects["QmRev1"] = "{\"amount\": \"10.50\", \"email\": \"A@Example.com\"}";
+    gateway.mapObjects["QmRev2"] = "{\"amount\": 2.25, \"email\": \"b@example.com\"}";
+    gateway.mapObjects["QmRev3"] = "{\"amount\": \"100\", \"deleted\": \"1\"}";
+    gateway.mapObjects["QmRev4"] = "{\"amount\": \"0.01\", \"email\": \"a@example.com\"}";
+    cache.Write("REVENUE", "K2", "QmRev2", 1);
+    cache.Write("REVENUE", "K1", "QmRev1", 1);
+    cache.Write("REVENUE", "K3", "QmRev3", 1);
+    cache.Write("REVENUE", "K5", "QmMissing", 1);
+
+    CBusinessObjectIndex index(cache, boost::bind(&CTestLoader::Load, &loader, _1, _2, _3));
+    index.Declare("REVENUE", "amount", BO_INDEX_SUM);
+    int64_t nCount = 0;
+    BOOST_CHECK_EQUAL(index.GetSum("revenue", "amount", nCount), 12.75);
+    BOOST_CHECK_EQUAL(nCount, 2);
+    BOOST_CHECK_EQUAL(loader.nLoads, 4);
+
+    // Unchanged: only the object that failed to load is tried again
+    index.GetSum("REVENUE", "amount", nCount);
+    BOOST_CHECK_EQUAL(loader.nLoads, 5);
+
+    // A new index loads every object once more, after that lookups are free
+    std::string sPrimaryKey;
+    BOOST_CHECK(index.FindFirst("REVENUE", "email", "a@EXAMPLE.com", sPrimaryKey));
+    BOOST_CHECK_EQUAL(sPrimaryKey, "K1");
+    BOOST_CHECK_EQUAL(loader.nLoads, 9);
+    BOOST_CHECK(!index.FindFirst("REVENUE", "email", "c@example.com", sPrimaryKey));
+    BOOST_CHECK_EQUAL(index.GetSum("REVENUE", "amount", nCount), 12.75);
+    BOOST_CHECK_EQUAL(loader.nLoads, 11);
+
+    // Ingesting objects only loads those
+    gateway.mapObjects["QmMissing"] = "{\"amount\": \"1\"}";
+    cache.Write("REVENUE", "K0", "QmRev4", 2);
+    cache.Write("REVENUE", "K2", "QmRev3", 2);
+    int nLoads = loader.nLoads;
+    BOOST_CHECK(index.FindFirst("REVENUE", "email", "A@EXAMPLE.COM", sPrimaryKey));
+    BOOST_CHECK_EQUAL(sPrimaryKey, "K0");
+    BOOST_CHECK_EQUAL(loader.nLoads, nLoads + 3);
+    BOOST_CHECK_EQUAL(index.GetSum("REVENUE", "amount", nCount), 11.51);
+    BOOST_CHECK_EQUAL(nCount, 3);
+
+    cache.Erase("REVENUE", "K1");
+    BOOST_CHECK(index.FindFirst("REVENUE", "email", "a@example.com", sPrimaryKey));
+    BOOST_CHECK_EQUAL(sPrimaryKey, "K0");
+    BOOST_CHECK_EQUAL(index.GetSum("REVENUE", "amount", nCount), 1.01);
+    BOOST_CHECK_EQUAL(nCount, 2);
+
+    cache.ClearSection("REVENUE");
+    BOOST_CHECK_EQUAL(index.GetSum("REVENUE", "amount", nCount), 0);
+    BOOST_CHECK_EQUAL(nCount, 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
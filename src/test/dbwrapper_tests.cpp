@@ -3,8 +3,10 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include "dbwrapper.h"
+#include "main.h"
 #include "uint256.h"
 #include "random.h"
+#include "txdb.h"
 #include "test/test_biblepay.h"
 
 #include <boost/assign/std/vector.hpp> // for 'operator+=()'
@@ -322,6 +324,81 @@ BOOST_AUTO_TEST_CASE(iterator_string_ordering)
     }
 }
 
+BOOST_AUTO_TEST_CASE(biblehash_db)
+{
+    CBibleHashDB db(1 << 20, true);
+    uint256 hashBlock = GetRandHash();
+    uint256 hashBible = GetRandHash();
+    uint256 res;
+
+    BOOST_CHECK(!db.ReadBibleHash(hashBlock, 1000, 900, 7000, 42, res));
+    BOOST_CHECK(db.WriteBibleHash(hashBlock, CBibleHashRecord(1000, 900, 7000, 42, hashBible)));
+    BOOST_CHECK(db.ReadBibleHash(hashBlock, 1000, 900, 7000, 42, res));
+    BOOST_CHECK_EQUAL(res.ToString(), hashBible.ToString());
+
+    // A hit needs every input to match, not just the block hash
+    BOOST_CHECK(!db.ReadBibleHash(hashBlock, 1001, 900, 7000, 42, res));
+    BOOST_CHECK(!db.ReadBibleHash(hashBlock, 1000, 0, 7000, 42, res));
+    BOOST_CHECK(!db.ReadBibleHash(hashBlock, 1000, 900, 0, 42, res));
+    BOOST_CHECK(!db.ReadBibleHash(hashBlock, 1000, 900, 7000, 43, res));
+    BOOST_CHECK(!db.ReadBibleHash(GetRandHash(), 1000, 900, 7000, 42, res));
+}
+
+BOOST_AUTO_TEST_CASE(superblock_payment_index)
+{
+    CBlockTreeDB db(1 << 20, true);
+    int heights[] = {300, 70000, 100, 65536};
+    for (int i = 0; i < 4; i++) {
+        CSuperblockPayments payments;
+        payments.hashBlock = GetRandHash();
+        payments.nTime = 1500000000 + heights[i];
+        payments.nBudget = heights[i] * COIN;
+        payments.vPayments.push_back(std::make_pair(strprintf("BAddress%d", i), (CAmount)heights[i]));
+        payments.vPayments.push_back(std::make_pair(std::string("BOther"), (CAmount)1));
+        BOOST_CHECK(db.WriteSuperblockPayments(heights[i], payments));
+    }
+    BOOST_CHECK(db.WriteFlag("txindex", true));
+    BOOST_CHECK(db.EraseSuperblockPayments(300));
+
+    // Every height comes back, whatever the byte order of its key, and nothing else does
+    std::map<int, CSuperblockPayments> mapPayments;
+    BOOST_CHECK(db.ReadSuperblockPayments(mapPayments));
+    BOOST_CHECK_EQUAL(mapPayments.size(), 3);
+    BOOST_CHECK(!mapPayments.count(300));
+    BOOST_CHECK_EQUAL(mapPayments[70000].nTime, 1500070000);
+    BOOST_CHECK_EQUAL(mapPayments[65536].nBudget, 65536 * COIN);
+    BOOST_CHECK_EQUAL(mapPayments[100].vPayments.size(), 2);
+    BOOST_CHECK_EQUAL(mapPayments[100].vPayments[0].first, "BAddress2");
+    BOOST_CHECK_EQUAL(mapPayments[100].vPayments[0].second, 100);
+}
 
+BOOST_AUTO_TEST_CASE(block_summary_index)
+{
+    CBlockTreeDB db(1 << 20, true);
+    CBlock block;
+    CMutableTransaction coinbase;
+    coinbase.vin.resize(1);
+    coinbase.vout.resize(2);
+    coinbase.vout[0].scriptPubKey = CScript() << OP_TRUE;
+    coinbase.vout[1].scriptPubKey = CScript() << OP_FALSE;
+    block.vtx.push_back(coinbase);
+    CMutableTransaction tx;
+    tx.vin.resize(1);
+    tx.nLockTime = 1;
+    block.vtx.push_back(tx);
+    uint256 hashBlock = block.GetHash();
+
+    CBlockSummary summary;
+    BOOST_CHECK(!db.ReadBlockSummary(hashBlock, summary));
+    BOOST_CHECK(db.WriteBlockSummary(hashBlock, CBlockSummary(block)));
+    BOOST_CHECK(db.ReadBlockSummary(hashBlock, summary));
+    BOOST_CHECK_EQUAL(summary.vTxIds.size(), 2);
+    BOOST_CHECK(summary.vTxIds[0] == block.vtx[0].GetHash());
+    BOOST_CHECK(summary.vTxIds[1] == block.vtx[1].GetHash());
+    BOOST_CHECK_EQUAL(summary.vOutputs[0], 2);
+    BOOST_CHECK_EQUAL(summary.vOutputs[1], 0);
+    BOOST_CHECK(CScript(summary.vFirstScripts[0].begin(), summary.vFirstScripts[0].end()) == coinbase.vout[0].scriptPubKey);
+    BOOST_CHECK(summary.vFirstScripts[1].empty());
+}
 
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,213 @@
+// Copyright (c) 2017-2018 The Biblepay Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "dccfile.h"
+#include "podc.h"
+#include "random.h"
+#include "test/test_biblepay.h"
+
+#include <fstream>
+#include <sstream>
+
+#include <boost/algorithm/string/case_conv.hpp>
+#include <boost/bind.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/test/unit_test.hpp>
+
+namespace {
+
+std::string TempPath()
+{
+    return (boost::filesystem::temp_directory_path() / boost::filesystem::unique_path()).string();
+}
+
+void WriteFile(const std::string& sPath, const std::string& sData)
+{
+    FILE* file = fopen(sPath.c_str(), "wb");
+    fwrite(sData.data(), 1, sData.size(), file);
+    fclose(file);
+}
+
+std::string ReadFile(const std::string& sPath)
+{
+    std::ifstream stream(sPath.c_str(), std::ios::binary);
+    std::stringstream ss;
+    ss << stream.rdbuf();
+    return ss.str();
+}
+
+std::string ExtraFor(const std::string& sCPID)
+{
+    return "<extra>" + sCPID + "</extra>";
+}
+
+/** The line by line FilterPhase1 loop the streaming filter replaced */
+std::string FilterPhase1Reference(const std::string& sSourcePath, const std::string& sConcatCPIDs, const std::vector<std::string>& vCPIDs)
+{
+    std::ifstream streamIn(sSourcePath.c_str());
+    std::string sBuffer;
+    std::string sOutData;
+    std::string line;
+    while (std::getline(streamIn, line)) {
+        std::string sCpid = ExtractXML(line, "<cpid>", "</cpid>");
+        sBuffer += line + "<ROW>";
+        if (sCpid.empty())
+            continue;
+        boost::to_upper(sCpid);
+        if (!Contains(sConcatCPIDs, sCpid)) {
+            sBuffer = "";
+            continue;
+        }
+        for (unsigned int i = 0; i < vCPIDs.size(); i++) {
+            if (boost::to_upper_copy(vCPIDs[i]) != sCpid)
+                continue;
+            for (int z = 0; z < 2; z++) {
+                if (std::getline(streamIn, line))
+                    sBuffer += line + "<ROW>";
+            }
+            sOutData += FilterBoincData(sBuffer, "<user>", "</user>", ExtraFor(sCpid));
+            sBuffer = "";
+        }
+    }
+    return sOutData;
+}
+
+std::string UserRecord(const std::string& sCPID, int nTeam, int nRAC, const std::string& sEOL)
+{
+    return "<user>" + sEOL + " <id>" + std::to_string(nRAC) + "</id>" + sEOL + " <name>user " + sCPID.substr(0, 4) + "</name>" + sEOL
+        + " <create_time>1500000000</create_time>" + sEOL + " <total_credit>" + std::to_string(nRAC * 10) + "</total_credit>" + sEOL
+        + " <expavg_credit>" + std::to_string(nRAC) + ".25</expavg_credit>" + sEOL + " <cpid>" + sCPID + "</cpid>" + sEOL
+        + " <url>http://example.com</url>" + sEOL + " <teamid>" + std::to_string(nTeam) + "</teamid>" + sEOL + "</user>" + sEOL;
+}
+
+} // namespace
+
+BOOST_FIXTURE_TEST_SUITE(dccfile_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(dccfile_line_reader)
+{
+    std::string sPath = TempPath();
+    std::string sData = "first\r\n\nthird line is longer than the buffer\n\n\nlast without newline";
+    WriteFile(sPath, sData);
+
+    std::vector<std::string> vExpected;
+    std::ifstream stream(sPath.c_str());
+    std::string line;
+    while (std::getline(stream, line))
+        vExpected.push_back(line);
+
+    CDCCLineReader reader(sPath, 4);
+    BOOST_CHECK(reader.IsOpen());
+    std::vector<std::string> vLines;
+    while (reader.ReadLine(line))
+        vLines.push_back(line);
+    BOOST_CHECK(vLines == vExpected);
+    BOOST_CHECK_EQUAL(reader.GetLineCount(), (int64_t)vExpected.size());
+
+    BOOST_CHECK(!CDCCLineReader(sPath + ".missing").IsOpen());
+    boost::filesystem::remove(sPath);
+}
+
+BOOST_AUTO_TEST_CASE(dccfile_filter_matches_reference)
+{
+    std::vector<std::string> vAll;
+    for (int i = 0; i < 40; i++)
+        vAll.push_back(GetRandHash().GetHex().substr(0, 32));
+
+    // Researchers with lower case and duplicate DCC entries; one is not in the concatenated list
+    std::vector<std::string> vCPIDs;
+    std::string sConcatCPIDs;
+    for (int i = 0; i < 40; i += 3) {
+        vCPIDs.push_back(i % 2 ? vAll[i] : boost::to_upper_copy(vAll[i]));
+        if (i != 9)
+            sConcatCPIDs += vAll[i] + ",";
+    }
+    vCPIDs.push_back(vAll[6]);
+    vCPIDs.push_back(vAll[15]);
+    boost::to_upper(sConcatCPIDs);
+
+    std::string sData = "<users>\n";
+    for (int i = 0; i < 40; i++) {
+        std::string sRecord = UserRecord(vAll[i], i % 4, 100 + i, i % 5 ? "\n" : "\r\n");
+        // An indented root element is not recognized by FilterBoincData
+        if (i == 21)
+            sRecord = "  " + sRecord;
+        sData += sRecord;
+    }
+    sData += "</users>";
+
+    std::string sSource = TempPath();
+    std::string sTarget = TempPath();
+    WriteFile(sSource, sData);
+
+    DCCResearcherMap mapResearchers;
+    for (unsigned int i = 0; i < vCPIDs.size(); i++) {
+        std::string sCPID = boost::to_upper_copy(vCPIDs[i]);
+        if (Contains(sConcatCPIDs, sCPID))
+            mapResearchers[sCPID]++;
+    }
+    BOOST_CHECK(FilterDCCUserFile(sSource, sTarget, mapResearchers, boost::bind(&ExtraFor, _1)));
+    std::string sExpected = FilterPhase1Reference(sSource, sConcatCPIDs, vCPIDs);
+    BOOST_CHECK(!sExpected.empty());
+    BOOST_CHECK(ReadFile(sTarget) == sExpected);
+
+    BOOST_CHECK(!FilterDCCUserFile(sSource + ".missing", sTarget, mapResearchers, boost::bind(&ExtraFor, _1)));
+    boost::filesystem::remove(sSource);
+    boost::filesystem::remove(sTarget);
+}
+
+BOOST_AUTO_TEST_CASE(dccfile_team_filter)
+{
+    std::string sData = UserRecord("00112233445566778899aabbccddeeff", 7, 150, "\n") + UserRecord("ffeeddccbbaa99887766554433221100", 8, 42, "\n")
+        + UserRecord("0123456789abcdef0123456789abcdef", 7, 99, "\r\n");
+    std::string sSource = TempPath();
+    std::string sTarget = TempPath();
+    WriteFile(sSource, sData);
+
+    BOOST_CHECK(FilterDCCTeamFile(sSource, sTarget, 7));
+    BOOST_CHECK_EQUAL(ReadFile(sTarget), "00112233445566778899aabbccddeeff,7,150,1500,1500000000,user 0011\r\n"
+        "0123456789abcdef0123456789abcdef,7,99,990,1500000000,user 0123\r\n");
+
+    boost::filesystem::remove(sSource);
+    boost::filesystem::remove(sTarget);
+}
+
+BOOST_AUTO_TEST_CASE(dccfile_table)
+{
+    std::string sA = "00112233445566778899aabbccddeeff";
+    std::string sB = "ffeeddccbbaa99887766554433221100";
+    DCCResearcherMap mapResearchers;
+    mapResearchers[boost::to_upper_copy(sA)] = 2;
+    mapResearchers[boost::to_upper_copy(sB)] = 1;
+    std::string sData = UserRecord(sA, 7, 150, "\n") + UserRecord("0123456789abcdef0123456789abcdef", 7, 99, "\n") + UserRecord(sB, 8, 42, "\n")
+        + UserRecord(sA, 9, 10, "\n");
+    std::string sSource = TempPath();
+    std::string sFiltered = TempPath();
+    WriteFile(sSource, sData);
+    BOOST_CHECK(FilterDCCUserFile(sSource, sFiltered, mapResearchers, boost::bind(&ExtraFor, _1)));
+
+    CDCCTable table;
+    BOOST_CHECK(table.Load(sFiltered));
+    // sA has two DCC entries: the second one takes the next two lines, "</user>" and "<user>", and yields a row without a CPID
+    BOOST_CHECK_EQUAL(table.size(), 4U);
+    const std::vector<unsigned int>& vRowsA = table.GetRows(boost::to_upper_copy(sA));
+    BOOST_CHECK_EQUAL(vRowsA.size(), 2U);
+    BOOST_CHECK_EQUAL(table.vTeam[vRowsA[0]], 7);
+    BOOST_CHECK_EQUAL(table.vCredit[vRowsA[0]], 150.25);
+    BOOST_CHECK_EQUAL(table.vCreditTotal[vRowsA[0]], 150.25);
+    BOOST_CHECK_EQUAL(table.vTeam[vRowsA[1]], 9);
+    BOOST_CHECK_EQUAL(table.GetRows("").size(), 1U);
+    const std::vector<unsigned int>& vRowsB = table.GetRows(boost::to_upper_copy(sB));
+    BOOST_CHECK_EQUAL(vRowsB.size(), 1U);
+    BOOST_CHECK_EQUAL(table.vTeam[vRowsB[0]], 8);
+    BOOST_CHECK_EQUAL(table.vCPID[vRowsB[0]], boost::to_upper_copy(sB));
+    BOOST_CHECK(table.GetRows("0123456789ABCDEF0123456789ABCDEF").empty());
+
+    BOOST_CHECK(!table.Load(sFiltered + ".missing"));
+    BOOST_CHECK_EQUAL(table.size(), 0U);
+    boost::filesystem::remove(sSource);
+    boost::filesystem::remove(sFiltered);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -2,6 +2,9 @@
 // Distributed under the MIT software license, see the accompanying
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
+#include "crypto/common.h"
+#include "crypto/sph_aesni.h"
+#include "crypto/x11.h"
 #include "hash.h"
 #include "utilstrencodings.h"
 #include "test/test_biblepay.h"
@@ -47,4 +50,60 @@ BOOST_AUTO_TEST_CASE(murmurhash3)
 #undef T
 }
 
+BOOST_AUTO_TEST_CASE(x11_batch)
+{
+    unsigned char header[X11_HEADER_SIZE];
+    for (unsigned int i = 0; i < X11_HEADER_SIZE; i++)
+        header[i] = (unsigned char)(i * 7 + 3);
+
+    // Every batch size, including short passes and a nonce that wraps
+    unsigned char hashes[32 * X11_MAX_BATCH];
+    for (unsigned int nCount = 1; nCount <= X11_MAX_BATCH; nCount++)
+    {
+        X11HashHeaders(header, 0xfffffffc, nCount, hashes);
+        for (unsigned int i = 0; i < nCount; i++)
+        {
+            unsigned char expected[X11_HEADER_SIZE];
+            memcpy(expected, header, X11_HEADER_SIZE);
+            WriteLE32(expected + X11_HEADER_SIZE - 4, 0xfffffffc + i);
+            uint256 hash = HashX11(expected, expected + X11_HEADER_SIZE);
+            BOOST_CHECK(memcmp(hash.begin(), hashes + 32 * i, 32) == 0);
+        }
+    }
+}
+
+template <typename Context, void (*Init)(void*), void (*Update)(void*, const void*, size_t), void (*Close)(void*, void*)>
+static std::vector<unsigned char> Sph512(const std::vector<unsigned char>& vData, bool fAESNI)
+{
+    std::vector<unsigned char> vHash(64);
+    Context ctx;
+    sph_aesni_enable(fAESNI);
+    Init(&ctx);
+    // Uneven pieces exercise the buffering around each block
+    for (size_t nPos = 0; nPos < vData.size(); nPos += 37)
+        Update(&ctx, &vData[nPos], std::min((size_t)37, vData.size() - nPos));
+    Close(&ctx, &vHash[0]);
+    sph_aesni_enable(1);
+    return vHash;
+}
+
+BOOST_AUTO_TEST_CASE(x11_aesni_stages)
+{
+    if (!sph_aesni_available())
+        return;
+    std::vector<unsigned char> vData;
+    for (unsigned int nLen = 0; nLen < 600; nLen += 13)
+    {
+        vData.resize(nLen);
+        for (unsigned int i = 0; i < nLen; i++)
+            vData[i] = (unsigned char)(i * 31 + nLen);
+        BOOST_CHECK((Sph512<sph_groestl512_context, sph_groestl512_init, sph_groestl512, sph_groestl512_close>(vData, true) ==
+                     Sph512<sph_groestl512_context, sph_groestl512_init, sph_groestl512, sph_groestl512_close>(vData, false)));
+        BOOST_CHECK((Sph512<sph_echo512_context, sph_echo512_init, sph_echo512, sph_echo512_close>(vData, true) ==
+                     Sph512<sph_echo512_context, sph_echo512_init, sph_echo512, sph_echo512_close>(vData, false)));
+        BOOST_CHECK((Sph512<sph_shavite512_context, sph_shavite512_init, sph_shavite512, sph_shavite512_close>(vData, true) ==
+                     Sph512<sph_shavite512_context, sph_shavite512_init, sph_shavite512, sph_shavite512_close>(vData, false)));
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,203 @@
+// Copyright (c) 2017-2018 The Biblepay Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "httpsclient.h"
+#include "compat.h"
+#include "netbase.h"
+#include "test/test_biblepay.h"
+
+#include <signal.h>
+
+#include <boost/bind.hpp>
+#include <boost/test/unit_test.hpp>
+#include <boost/thread.hpp>
+
+#include <openssl/ec.h>
+#include <openssl/evp.h>
+#include <openssl/x509.h>
+
+namespace {
+
+/**
+ * A local TLS server that serves one connection at a time and keeps it open
+ * between requests. The request path selects the response.
+ */
+class CTestHTTPSServer
+{
+public:
+    SSL_CTX* ctx;
+    SOCKET hListen;
+    int nPort;
+    boost::thread thread;
+
+    CTestHTTPSServer() : ctx(NULL), hListen(INVALID_SOCKET), nPort(0)
+    {
+        SSL_library_init();
+        ctx = SSL_CTX_new(SSLv23_server_method());
+        EVP_PKEY* key = NULL;
+        EVP_PKEY_CTX* pctx = EVP_PKEY_CTX_new_id(EVP_PKEY_EC, NULL);
+        EVP_PKEY_keygen_init(pctx);
+        EVP_PKEY_CTX_set_ec_paramgen_curve_nid(pctx, NID_X9_62_prime256v1);
+        EVP_PKEY_keygen(pctx, &key);
+        EVP_PKEY_CTX_free(pctx);
+        X509* cert = X509_new();
+        ASN1_INTEGER_set(X509_get_serialNumber(cert), 1);
+        X509_gmtime_adj(X509_get_notBefore(cert), 0);
+        X509_gmtime_adj(X509_get_notAfter(cert), 3600);
+        X509_set_pubkey(cert, key);
+        X509_NAME_add_entry_by_txt(X509_get_subject_name(cert), "CN", MBSTRING_ASC, (const unsigned char*)"localhost", -1, -1, 0);
+        X509_set_issuer_name(cert, X509_get_subject_name(cert));
+        X509_sign(cert, key, EVP_sha256());
+        SSL_CTX_use_certificate(ctx, cert);
+        SSL_CTX_use_PrivateKey(ctx, key);
+        X509_free(cert);
+        EVP_PKEY_free(key);
+
+        hListen = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+        struct sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port = 0;
+        bind(hListen, (struct sockaddr*)&addr, sizeof(addr));
+        listen(hListen, 4);
+        socklen_t len = sizeof(addr);
+        getsockname(hListen, (struct sockaddr*)&addr, &len);
+        nPort = ntohs(addr.sin_port);
+        thread = boost::thread(boost::bind(&CTestHTTPSServer::Run, this));
+    }
+
+    ~CTestHTTPSServer()
+    {
+        thread.join();
+        CloseSocket(hListen);
+        SSL_CTX_free(ctx);
+    }
+
+    /** Serves connections until none arrives for a few seconds */
+    void Run()
+    {
+        while (true) {
+            fd_set fdset;
+            FD_ZERO(&fdset);
+            FD_SET(hListen, &fdset);
+            struct timeval timeout;
+            timeout.tv_sec = 3;
+            timeout.tv_usec = 0;
+            if (select(hListen + 1, &fdset, NULL, NULL, &timeout) <= 0)
+                return;
+            SOCKET hSocket = accept(hListen, NULL, NULL);
+            if (hSocket == INVALID_SOCKET)
+                return;
+            SSL* ssl = SSL_new(ctx);
+            SSL_set_fd(ssl, hSocket);
+            if (SSL_accept(ssl) > 0)
+                Serve(ssl);
+            SSL_shutdown(ssl);
+            SSL_free(ssl);
+            CloseSocket(hSocket);
+        }
+    }
+
+    void Serve(SSL* ssl)
+    {
+        std::string sData;
+        while (true) {
+            size_t nHeaderEnd;
+            while ((nHeaderEnd = sData.find("\r\n\r\n")) == std::string::npos) {
+                char buf[4096];
+                int nRead = SSL_read(ssl, buf, sizeof(buf));
+                if (nRead <= 0)
+                    return;
+                sData.append(buf, nRead);
+            }
+            // The test requests have no body
+            std::string sPath = sData.substr(0, sData.find(" HTTP/1.1"));
+            sData.erase(0, nHeaderEnd + 4);
+
+            std::string sResponse;
+            bool fClose = false;
+            if (sPath == "GET /length") {
+                sResponse = "HTTP/1.1 200 OK\r\nContent-Length: 5\r\n\r\nhello";
+            } else if (sPath == "GET /close") {
+                sResponse = "HTTP/1.1 200 OK\r\nContent-Length: 3\r\nConnection: close\r\n\r\nbye";
+                fClose = true;
+            } else if (sPath == "GET /chunked") {
+                sResponse = "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n5\r\nhello\r\n6;ext=1\r\n world\r\n0\r\n\r\n";
+            } else if (sPath == "GET /marker") {
+                // Neither a length nor a close: only the completion check ends it
+                sResponse = "HTTP/1.1 200 OK\r\n\r\n<html>pool</html>";
+            } else if (sPath == "GET /drop") {
+                // Closed afterwards without saying so, as an idle timeout would
+                sResponse = "HTTP/1.1 200 OK\r\nContent-Length: 4\r\n\r\ndrop";
+                fClose = true;
+            }
+            SSL_write(ssl, sResponse.data(), sResponse.size());
+            if (fClose)
+                return;
+        }
+    }
+};
+
+bool HasHTMLEnd(const std::string& sData)
+{
+    return sData.find("</html>") != std::string::npos;
+}
+
+std::string GetBody(const std::string& sResponse)
+{
+    size_t nPos = sResponse.find("\r\n\r\n");
+    return nPos == std::string::npos ? "" : sResponse.substr(nPos + 4);
+}
+
+} // namespace
+
+BOOST_FIXTURE_TEST_SUITE(httpsclient_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(httpsclient_keepalive)
+{
+#ifndef WIN32
+    signal(SIGPIPE, SIG_IGN);
+#endif
+    CTestHTTPSServer server;
+    CHTTPSClient client;
+    HTTPSCompletionCheck fnComplete = boost::bind(&HasHTMLEnd, _1);
+    std::string sError;
+
+    // Requests reuse the connection
+    std::string sResponse = client.Request("127.0.0.1", server.nPort, "GET /length HTTP/1.1\r\nHost: 127.0.0.1\r\n\r\n", 10, 1000, fnComplete, sError);
+    BOOST_CHECK(sError.empty());
+    BOOST_CHECK_EQUAL(GetBody(sResponse), "hello");
+    BOOST_CHECK_EQUAL(sResponse.substr(0, 15), "HTTP/1.1 200 OK");
+    sResponse = client.Request("127.0.0.1", server.nPort, "GET /length HTTP/1.1\r\nHost: 127.0.0.1\r\n\r\n", 10, 1000, fnComplete, sError);
+    BOOST_CHECK_EQUAL(GetBody(sResponse), "hello");
+    sResponse = client.Request("127.0.0.1", server.nPort, "GET /close HTTP/1.1\r\nHost: 127.0.0.1\r\n\r\n", 10, 1000, fnComplete, sError);
+    BOOST_CHECK_EQUAL(GetBody(sResponse), "bye");
+    BOOST_CHECK_EQUAL(client.GetConnectCount(), 1);
+    BOOST_CHECK_EQUAL(client.GetResumedCount(), 0);
+
+    // After "Connection: close" a new connection resumes the TLS session
+    sResponse = client.Request("127.0.0.1", server.nPort, "GET /chunked HTTP/1.1\r\nHost: 127.0.0.1\r\n\r\n", 10, 1000, fnComplete, sError);
+    BOOST_CHECK_EQUAL(GetBody(sResponse), "hello world");
+    sResponse = client.Request("127.0.0.1", server.nPort, "GET /marker HTTP/1.1\r\nHost: 127.0.0.1\r\n\r\n", 10, 1000, fnComplete, sError);
+    BOOST_CHECK_EQUAL(GetBody(sResponse), "<html>pool</html>");
+    BOOST_CHECK_EQUAL(client.GetConnectCount(), 2);
+    BOOST_CHECK_EQUAL(client.GetResumedCount(), 1);
+
+    // A pooled connection the server closed is replaced transparently
+    sResponse = client.Request("127.0.0.1", server.nPort, "GET /drop HTTP/1.1\r\nHost: 127.0.0.1\r\n\r\n", 10, 1000, fnComplete, sError);
+    BOOST_CHECK_EQUAL(GetBody(sResponse), "drop");
+    sResponse = client.Request("127.0.0.1", server.nPort, "GET /length HTTP/1.1\r\nHost: 127.0.0.1\r\n\r\n", 10, 1000, fnComplete, sError);
+    BOOST_CHECK(sError.empty());
+    BOOST_CHECK_EQUAL(GetBody(sResponse), "hello");
+    BOOST_CHECK_EQUAL(client.GetConnectCount(), 4);
+    BOOST_CHECK_EQUAL(client.GetResumedCount(), 3);
+
+    client.Clear();
+    sResponse = client.Request("127.0.0.1", 1, "GET /length HTTP/1.1\r\n\r\n", 10, 1000, fnComplete, sError);
+    BOOST_CHECK(sResponse.empty());
+    BOOST_CHECK_EQUAL(sError, "Failed connection to 127.0.0.1:1");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
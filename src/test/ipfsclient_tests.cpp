@@ -0,0 +1,227 @@
+// Copyright (c) 2017-2018 The Biblepay Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "ipfsclient.h"
+#include "compat.h"
+#include "crypto/sha256.h"
+#include "netbase.h"
+#include "tinyformat.h"
+#include "utilstrencodings.h"
+#include "test/test_biblepay.h"
+
+#include <boost/bind.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
+#include <boost/test/unit_test.hpp>
+#include <boost/thread.hpp>
+
+namespace {
+
+/** A local gateway that answers each connection according to the request path, then closes it */
+class CTestGateway
+{
+public:
+    SOCKET hListen;
+    int nPort;
+    std::string sBody;
+    volatile bool fStop;
+    boost::thread thread;
+
+    CTestGateway() : hListen(INVALID_SOCKET), nPort(0), fStop(false)
+    {
+        for (int i = 0; i < 200000; i++)
+            sBody += (char)('a' + (i * 7) % 26);
+        hListen = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+        struct sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port = 0;
+        bind(hListen, (struct sockaddr*)&addr, sizeof(addr));
+        listen(hListen, 16);
+        socklen_t len = sizeof(addr);
+        getsockname(hListen, (struct sockaddr*)&addr, &len);
+        nPort = ntohs(addr.sin_port);
+        thread = boost::thread(boost::bind(&CTestGateway::Run, this));
+    }
+
+    ~CTestGateway()
+    {
+        fStop = true;
+        thread.join();
+        CloseSocket(hListen);
+    }
+
+    std::string GetURL(const std::string& sPath) const
+    {
+        return strprintf("http://127.0.0.1:%d%s", nPort, sPath);
+    }
+
+    void Run()
+    {
+        while (!fStop) {
+            fd_set fdset;
+            FD_ZERO(&fdset);
+            FD_SET(hListen, &fdset);
+            struct timeval timeout = MillisToTimeval(100);
+            if (select(hListen + 1, &fdset, NULL, NULL, &timeout) <= 0)
+                continue;
+            SOCKET hSocket = accept(hListen, NULL, NULL);
+            if (hSocket == INVALID_SOCKET)
+                continue;
+            Serve(hSocket);
+            CloseSocket(hSocket);
+        }
+    }
+
+    void Send(SOCKET hSocket, const std::string& sData)
+    {
+        size_t nSent = 0;
+        while (nSent < sData.size()) {
+            int nRet = send(hSocket, sData.data() + nSent, sData.size() - nSent, MSG_NOSIGNAL);
+            if (nRet <= 0)
+                return;
+            nSent += nRet;
+        }
+    }
+
+    void Serve(SOCKET hSocket)
+    {
+        std::string sRequest;
+        while (sRequest.find("\r\n\r\n") == std::string::npos) {
+            char buf[1024];
+            int nRead = recv(hSocket, buf, sizeof(buf), 0);
+            if (nRead <= 0)
+                return;
+            sRequest.append(buf, nRead);
+        }
+        std::string sPath = sRequest.substr(4, sRequest.find(" HTTP/1.1") - 4);
+        size_t nRange = sRequest.find("Range: bytes=");
+        size_t nOffset = nRange == std::string::npos ? 0 : atoi(sRequest.substr(nRange + 13).c_str());
+
+        if (sPath == "/length") {
+            Send(hSocket, strprintf("HTTP/1.1 200 OK\r\nContent-Length: %d\r\n\r\n", sBody.size()) + sBody);
+        } else if (sPath == "/chunked") {
+            Send(hSocket, "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n");
+            for (size_t nPos = 0; nPos < sBody.size(); nPos += 999) {
+                std::string sChunk = sBody.substr(nPos, 999);
+                Send(hSocket, strprintf("%x;ext=1\r\n", sChunk.size()) + sChunk + "\r\n");
+            }
+            Send(hSocket, "0\r\nX-Trailer: 1\r\n\r\n");
+        } else if (sPath == "/close") {
+            Send(hSocket, "HTTP/1.1 200 OK\r\n\r\n" + sBody);
+        } else if (sPath == "/short") {
+            Send(hSocket, strprintf("HTTP/1.1 200 OK\r\nContent-Length: %d\r\n\r\n", sBody.size()) + sBody.substr(0, 1000));
+        } else if (sPath == "/range" && nOffset >= sBody.size()) {
+            Send(hSocket, "HTTP/1.1 416 Range Not Satisfiable\r\nContent-Length: 0\r\n\r\n");
+        } else if (sPath == "/range") {
+            std::string sRest = sBody.substr(nOffset);
+            Send(hSocket, strprintf("HTTP/1.1 %s\r\nContent-Length: %d\r\n\r\n", nOffset ? "206 Partial Content" : "200 OK", sRest.size()) + sRest);
+        } else if (sPath == "/norange") {
+            Send(hSocket, strprintf("HTTP/1.1 200 OK\r\nContent-Length: %d\r\n\r\n", sBody.size()) + sBody);
+        } else {
+            Send(hSocket, "HTTP/1.1 404 Not Found\r\nContent-Length: 9\r\n\r\nnot found");
+        }
+    }
+};
+
+std::string SHA256Hex(const std::string& sData)
+{
+    unsigned char hash[CSHA256::OUTPUT_SIZE];
+    CSHA256().Write((const unsigned char*)sData.data(), sData.size()).Finalize(hash);
+    return HexStr(hash, hash + sizeof(hash));
+}
+
+std::string ReadFile(const boost::filesystem::path& path)
+{
+    boost::filesystem::ifstream stream(path, std::ios::binary);
+    return std::string((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+}
+
+void WriteFile(const boost::filesystem::path& path, const std::string& sData)
+{
+    boost::filesystem::ofstream stream(path, std::ios::binary);
+    stream << sData;
+}
+
+} // namespace
+
+BOOST_FIXTURE_TEST_SUITE(ipfsclient_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(ipfsclient_parse_url)
+{
+    std::string sHost, sPath;
+    int nPort;
+    BOOST_CHECK(ParseHTTPURL("http://ipfs.biblepay.org:8080/ipfs/QmHash#x", sHost, nPort, sPath));
+    BOOST_CHECK_EQUAL(sHost, "ipfs.biblepay.org");
+    BOOST_CHECK_EQUAL(nPort, 8080);
+    BOOST_CHECK_EQUAL(sPath, "/ipfs/QmHash");
+    BOOST_CHECK(ParseHTTPURL("127.0.0.1", sHost, nPort, sPath));
+    BOOST_CHECK_EQUAL(nPort, 80);
+    BOOST_CHECK_EQUAL(sPath, "/");
+    BOOST_CHECK(!ParseHTTPURL("https://ipfs.biblepay.org/", sHost, nPort, sPath));
+}
+
+BOOST_AUTO_TEST_CASE(ipfsclient_get)
+{
+    CTestGateway gateway;
+    std::string sData;
+    BOOST_CHECK_EQUAL(IPFSGetString(gateway.GetURL("/length"), 10, 1000000, sData), IPFS_OK);
+    BOOST_CHECK(sData == gateway.sBody);
+    BOOST_CHECK_EQUAL(IPFSGetString(gateway.GetURL("/chunked"), 10, 1000000, sData), IPFS_OK);
+    BOOST_CHECK(sData == gateway.sBody);
+    BOOST_CHECK_EQUAL(IPFSGetString(gateway.GetURL("/close"), 10, 1000000, sData), IPFS_OK);
+    BOOST_CHECK(sData == gateway.sBody);
+
+    BOOST_CHECK_EQUAL(IPFSGetString(gateway.GetURL("/short"), 10, 1000000, sData), IPFS_INCOMPLETE);
+    BOOST_CHECK_EQUAL(IPFSGetString(gateway.GetURL("/missing"), 10, 1000000, sData), IPFS_HTTP_ERROR);
+    BOOST_CHECK_EQUAL(IPFSGetString(gateway.GetURL("/length"), 10, 1000, sData), IPFS_FILE_ERROR);
+    BOOST_CHECK_EQUAL(IPFSGetString("http://127.0.0.1:1/", 10, 1000, sData), IPFS_CONNECT_FAILED);
+
+    // The hash is checked on the way, without keeping the body
+    CIPFSRequest req;
+    req.sURL = gateway.GetURL("/chunked");
+    req.sExpectedSHA256 = SHA256Hex(gateway.sBody);
+    BOOST_CHECK_EQUAL(IPFSGet(req), IPFS_OK);
+    req.sExpectedSHA256 = SHA256Hex("other");
+    BOOST_CHECK_EQUAL(IPFSGet(req), IPFS_HASH_MISMATCH);
+
+    std::vector<CIPFSRequest> vRequests(6, req);
+    for (unsigned int i = 0; i < vRequests.size(); i++)
+        vRequests[i].sExpectedSHA256 = i % 2 ? "" : SHA256Hex(gateway.sBody);
+    vRequests[3].sURL = gateway.GetURL("/missing");
+    std::vector<int> vStatus = IPFSGetAll(vRequests, 3);
+    BOOST_CHECK_EQUAL(vStatus.size(), 6);
+    for (unsigned int i = 0; i < vStatus.size(); i++)
+        BOOST_CHECK_EQUAL(vStatus[i], i == 3 ? IPFS_HTTP_ERROR : IPFS_OK);
+}
+
+BOOST_AUTO_TEST_CASE(ipfsclient_download_file)
+{
+    CTestGateway gateway;
+    boost::filesystem::path path = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+    std::string sHash = SHA256Hex(gateway.sBody);
+
+    BOOST_CHECK_EQUAL(IPFSDownloadFile(gateway.GetURL("/chunked"), path.string(), 10), IPFS_OK);
+    BOOST_CHECK(ReadFile(path) == gateway.sBody);
+
+    // Resumed from the end of the partial file, whether or not the server honours the range
+    WriteFile(path, gateway.sBody.substr(0, 70000));
+    BOOST_CHECK_EQUAL(IPFSDownloadFile(gateway.GetURL("/range"), path.string(), 10, true, sHash), IPFS_OK);
+    BOOST_CHECK(ReadFile(path) == gateway.sBody);
+    WriteFile(path, gateway.sBody.substr(0, 123456));
+    BOOST_CHECK_EQUAL(IPFSDownloadFile(gateway.GetURL("/norange"), path.string(), 10, true, sHash), IPFS_OK);
+    BOOST_CHECK(ReadFile(path) == gateway.sBody);
+    BOOST_CHECK_EQUAL(IPFSDownloadFile(gateway.GetURL("/range"), path.string(), 10, true, sHash), IPFS_OK);
+    BOOST_CHECK(ReadFile(path) == gateway.sBody);
+
+    // A corrupt partial file fails the check and is removed
+    WriteFile(path, "corrupt");
+    BOOST_CHECK_EQUAL(IPFSDownloadFile(gateway.GetURL("/range"), path.string(), 10, true, sHash), IPFS_HASH_MISMATCH);
+    BOOST_CHECK(!boost::filesystem::exists(path));
+
+    boost::filesystem::remove(path);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,89 @@
+// Copyright (c) 2017-2018 The Biblepay Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "keyset.h"
+#include "base58.h"
+#include "random.h"
+#include "test/test_biblepay.h"
+
+#include <boost/algorithm/string/case_conv.hpp>
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(keyset_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(keyset_fixed_keys)
+{
+    // Enough keys to resize the table several times; every second one is inserted
+    CFixedKeySet<20> set;
+    std::vector<uint160> vKeys;
+    for (int i = 0; i < 2000; i++) {
+        uint256 hash = GetRandHash();
+        vKeys.push_back(uint160(std::vector<unsigned char>(hash.begin(), hash.begin() + 20)));
+    }
+    for (unsigned int i = 0; i < vKeys.size(); i += 2)
+        BOOST_CHECK(set.Insert(vKeys[i].begin()));
+    BOOST_CHECK(!set.Insert(vKeys[0].begin()));
+    BOOST_CHECK_EQUAL(set.size(), 1000U);
+    for (unsigned int i = 0; i < vKeys.size(); i++)
+        BOOST_CHECK_EQUAL(set.Contains(vKeys[i].begin()), i % 2 == 0);
+
+    // Keys that agree on the bytes used as the hash still differ
+    uint160 a = vKeys[1];
+    uint160 b = a;
+    *(b.begin() + 19) ^= 1;
+    BOOST_CHECK(set.Insert(a.begin()));
+    BOOST_CHECK(!set.Contains(b.begin()));
+    BOOST_CHECK(set.Insert(b.begin()));
+    BOOST_CHECK(set.Contains(a.begin()) && set.Contains(b.begin()));
+
+    set.clear();
+    BOOST_CHECK_EQUAL(set.size(), 0U);
+    BOOST_CHECK(!set.Contains(a.begin()));
+}
+
+BOOST_AUTO_TEST_CASE(keyset_cpids)
+{
+    std::string sA = "00112233445566778899AABBCCDDEEFF";
+    std::string sB = "FFEEDDCCBBAA99887766554433221100";
+    CCPIDSet set(sA + "," + sB + ",,NOTACPID,");
+    BOOST_CHECK_EQUAL(set.size(), 3U);
+    BOOST_CHECK(set.Contains(sA));
+    BOOST_CHECK(set.Contains(boost::to_lower_copy(sB)));
+    BOOST_CHECK(set.Contains("NOTACPID"));
+    BOOST_CHECK(!set.Contains("0123456789ABCDEF0123456789ABCDEF"));
+
+    // What Contains() on the joined list used to find as well
+    BOOST_CHECK(!set.Contains(""));
+    BOOST_CHECK(!set.Contains(sA.substr(4)));
+    BOOST_CHECK(!set.Contains(sA.substr(16) + "," + sB.substr(0, 15)));
+    BOOST_CHECK(!set.Contains("NOTA"));
+}
+
+BOOST_AUTO_TEST_CASE(keyset_addresses)
+{
+    std::string sA = CBitcoinAddress(CKeyID(uint160(std::vector<unsigned char>(20, 1)))).ToString();
+    std::string sB = CBitcoinAddress(CKeyID(uint160(std::vector<unsigned char>(20, 2)))).ToString();
+    std::string sC = CBitcoinAddress(CScriptID(uint160(std::vector<unsigned char>(20, 1)))).ToString();
+    CAddressSet set(sA + "|" + sC + "; garbage,");
+    BOOST_CHECK_EQUAL(set.size(), 2U);
+    BOOST_CHECK(set.Contains(sA));
+    BOOST_CHECK(set.Contains(sC));
+    BOOST_CHECK(!set.Contains(sB));
+    BOOST_CHECK(!set.Contains("garbage"));
+    BOOST_CHECK(!set.Contains(""));
+    BOOST_CHECK(!set.Contains(sA.substr(1)));
+    BOOST_CHECK(set.Insert(sB));
+    BOOST_CHECK(!set.Insert("garbage"));
+    BOOST_CHECK(set.Contains(sB));
+
+    // Decoded once, probed by key
+    BOOST_CHECK(set.Contains(CAddressKey(sA)));
+    BOOST_CHECK(set.Contains(CAddressKey(sC)));
+    BOOST_CHECK(!set.Contains(CAddressKey(CBitcoinAddress(CKeyID(uint160(std::vector<unsigned char>(20, 3)))).ToString())));
+    BOOST_CHECK(CAddressKey("garbage").IsNull());
+    BOOST_CHECK(!set.Contains(CAddressKey("garbage")));
+    BOOST_CHECK(!set.Contains(CAddressKey()));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
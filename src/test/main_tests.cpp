@@ -4,7 +4,9 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include "chainparams.h"
+#include "governance-classes.h"
 #include "main.h"
+#include "txdb.h"
 
 #include "test/test_biblepay.h"
 
@@ -78,4 +80,28 @@ BOOST_AUTO_TEST_CASE(test_combiner_all)
     Test.disconnect(&ReturnTrue);
     BOOST_CHECK(Test());
 }
+BOOST_FIXTURE_TEST_CASE(superblock_payment_index_verifychain, TestChain100Setup)
+{
+    // Extend the chain past the first regtest DC superblock height
+    const Consensus::Params& consensusParams = Params().GetConsensus();
+    int nSuperblock = consensusParams.nDCCSuperblockStartBlock + 1;
+    while (!CSuperblock::IsDCCSuperblock(nSuperblock))
+        nSuperblock++;
+    CScript scriptPubKey = CScript() << ToByteVector(coinbaseKey.GetPubKey()) << OP_CHECKSIG;
+    std::vector<CMutableTransaction> noTxns;
+    while (chainActive.Height() < nSuperblock + 10)
+        CreateAndProcessBlock(noTxns, scriptPubKey);
+
+    CSuperblockPayments payments;
+    BOOST_CHECK(GetSuperblockPayments(nSuperblock, payments));
+    BOOST_CHECK(payments.hashBlock == chainActive[nSuperblock]->GetBlockHash());
+
+    // VerifyDB disconnects the superblock on a scratch view; the index must not notice
+    BOOST_CHECK(CVerifyDB().VerifyDB(Params(), pcoinsTip, 3, 288));
+    BOOST_CHECK(GetSuperblockPayments(nSuperblock, payments));
+    std::map<int, CSuperblockPayments> mapPayments;
+    BOOST_CHECK(pblocktree->ReadSuperblockPayments(mapPayments));
+    BOOST_CHECK(mapPayments.count(nSuperblock));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,73 @@
+// Copyright (c) 2017-2018 The Biblepay Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "stakeweight.h"
+#include "random.h"
+#include "test/test_biblepay.h"
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(stakeweight_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(stakeweight_parse_signatures)
+{
+    std::map<int, std::string> mapSigs;
+    ParseStakeSignatures("<polmessage>abc</polmessage><polweight>12.00</polweight><SIG_0>sig0=</SIG_0><SIG_1>sig1=</SIG_1>", mapSigs);
+    BOOST_CHECK_EQUAL(mapSigs.size(), 2);
+    BOOST_CHECK_EQUAL(mapSigs[0], "sig0=");
+    BOOST_CHECK_EQUAL(mapSigs[1], "sig1=");
+
+    // Two-digit indexes, out of order, and a repeated tag: the first one wins
+    ParseStakeSignatures("<SIG_10>ten</SIG_10><SIG_2>two</SIG_2><SIG_2>again</SIG_2><SIG_1>one</SIG_1>", mapSigs);
+    BOOST_CHECK_EQUAL(mapSigs.size(), 3);
+    BOOST_CHECK_EQUAL(mapSigs[10], "ten");
+    BOOST_CHECK_EQUAL(mapSigs[2], "two");
+    BOOST_CHECK_EQUAL(mapSigs[1], "one");
+
+    // Tags ExtractXML would never be asked for, and an unclosed one
+    ParseStakeSignatures("<SIG_>x</SIG_><SIG_01>y</SIG_01><SIG_a>z</SIG_a><SIG_3>open", mapSigs);
+    BOOST_CHECK_EQUAL(mapSigs.size(), 1);
+    BOOST_CHECK_EQUAL(mapSigs[3], "");
+
+    ParseStakeSignatures("", mapSigs);
+    BOOST_CHECK(mapSigs.empty());
+}
+
+BOOST_AUTO_TEST_CASE(stakeweight_signature_cache)
+{
+    CStakeWeightCache cache;
+    uint256 txid = GetRandHash();
+    std::vector<std::string> vSigs;
+    vSigs.push_back("a");
+    vSigs.push_back("b");
+    uint256 key = CStakeWeightCache::GetSignatureKey(txid, "message", vSigs);
+
+    // Any change to what was verified is a different check
+    BOOST_CHECK(key != CStakeWeightCache::GetSignatureKey(GetRandHash(), "message", vSigs));
+    BOOST_CHECK(key != CStakeWeightCache::GetSignatureKey(txid, "other", vSigs));
+    std::vector<std::string> vSwapped;
+    vSwapped.push_back("b");
+    vSwapped.push_back("a");
+    BOOST_CHECK(key != CStakeWeightCache::GetSignatureKey(txid, "message", vSwapped));
+
+    bool fSigned = false;
+    std::string sError;
+    BOOST_CHECK(!cache.GetSignatureResult(key, fSigned, sError));
+    cache.SetSignatureResult(key, false, "Unable to recover public key.");
+    BOOST_CHECK(cache.GetSignatureResult(key, fSigned, sError));
+    BOOST_CHECK(!fSigned);
+    BOOST_CHECK_EQUAL(sError, "Unable to recover public key.");
+
+    // Bounded: the oldest results make way
+    for (size_t i = 0; i < CStakeWeightCache::MAX_SIGNATURES; i++)
+        cache.SetSignatureResult(GetRandHash(), true, "");
+    BOOST_CHECK(!cache.GetSignatureResult(key, fSigned, sError));
+
+    cache.SetSignatureResult(key, true, "");
+    cache.Clear();
+    BOOST_CHECK(!cache.GetSignatureResult(key, fSigned, sError));
+    BOOST_CHECK_EQUAL(cache.GetCoinCount(), 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
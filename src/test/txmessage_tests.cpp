@@ -0,0 +1,105 @@
+// Copyright (c) 2017-2018 The Biblepay Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "txmessage.h"
+
+#include "podc.h"
+#include "test/test_biblepay.h"
+#include "tinyformat.h"
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(txmessage_tests, BasicTestingSetup)
+
+static const char* const TAG_NAMES[CTxMessageTags::TAG_COUNT] =
+{
+    "MT", "MK", "MV", "MS", "NONCE", "SPORKSIG", "BOSIG", "BOSIGNER", "ipfshash", "ipfssize", "cpidsig", "PODC_TASKS"
+};
+
+static void CheckMatchesExtractXML(const std::string& sMessage)
+{
+    CTxMessageTags tags(sMessage);
+    for (int i = 0; i < CTxMessageTags::TAG_COUNT; i++)
+    {
+        std::string sName = TAG_NAMES[i];
+        std::string sExpected = ExtractXML(sMessage, "<" + sName + ">", "</" + sName + ">");
+        BOOST_CHECK_MESSAGE(tags.GetString((CTxMessageTags::Tag)i) == sExpected, strprintf("tag %s in %s", sName, sMessage));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(txmessage_tags_basic)
+{
+    std::string sMessage = "<MT>PRAYER</MT><MK>Healing</MK><MV>Please pray for my family</MV><NONCE>1530000000</NONCE><BOSIGNER>B5tWpb8K1S7NmH4Zx8rMLpN</BOSIGNER>";
+    CTxMessageTags tags(sMessage);
+    BOOST_CHECK(tags.GetString(CTxMessageTags::TAG_MT) == "PRAYER");
+    BOOST_CHECK(tags.GetString(CTxMessageTags::TAG_MK) == "Healing");
+    BOOST_CHECK(tags.GetString(CTxMessageTags::TAG_MV) == "Please pray for my family");
+    BOOST_CHECK(tags.GetString(CTxMessageTags::TAG_NONCE) == "1530000000");
+    BOOST_CHECK(tags.GetString(CTxMessageTags::TAG_BOSIGNER) == "B5tWpb8K1S7NmH4Zx8rMLpN");
+    BOOST_CHECK(tags.Get(CTxMessageTags::TAG_BOSIG).empty());
+    BOOST_CHECK(tags.Get(CTxMessageTags::TAG_SPORKSIG).empty());
+    // Values are views into the message
+    CTxMessageTags::Value v = tags.Get(CTxMessageTags::TAG_MK);
+    BOOST_CHECK(v.pbegin == sMessage.data() + sMessage.find("Healing") && v.nSize == 7);
+    CheckMatchesExtractXML(sMessage);
+}
+
+BOOST_AUTO_TEST_CASE(txmessage_tags_extractxml_compat)
+{
+    // First open tag wins, value runs to the first close after it, tags nest and are case sensitive
+    CheckMatchesExtractXML("");
+    CheckMatchesExtractXML("no tags at all");
+    CheckMatchesExtractXML("<MT>unterminated");
+    CheckMatchesExtractXML("</MT>close first<MT>open</MT>");
+    CheckMatchesExtractXML("<MT>a</MT><MT>b</MT>");
+    CheckMatchesExtractXML("<MV><MT>inner</MT><MK>k</MK></MV><MT>outer</MT>");
+    CheckMatchesExtractXML("<<MT>>x</MT></MT>");
+    CheckMatchesExtractXML("<MT></MT><mt>lower</mt><IPFSHASH>upper</IPFSHASH><ipfshash>Qm123</ipfshash>");
+    CheckMatchesExtractXML("<cpidsig>cpid;hash;sig</cpidsig><PODC_TASKS>1=2,3=4</PODC_TASKS><ipfssize>10</ipfssize>");
+    CheckMatchesExtractXML("<PODC_TASKSX>no</PODC_TASKSX><MS>sig<MS>nested</MS></MS>");
+    CheckMatchesExtractXML("<MT>x</MT");
+}
+
+BOOST_AUTO_TEST_CASE(txmessage_cache)
+{
+    CTxMessageCache cache(2);
+    TxMessage t;
+    t.sMessageType = "PRAYER";
+    t.nTime = 100;
+
+    uint256 hash1 = uint256S("01");
+    uint256 hash2 = uint256S("02");
+    uint256 hash3 = uint256S("03");
+    TxMessage tOut;
+    BOOST_CHECK(!cache.Get(hash1, 100, tOut));
+    cache.Put(hash1, t);
+    BOOST_CHECK(cache.Get(hash1, 100, tOut) && tOut.sMessageType == "PRAYER");
+    // Parsed in a different block context
+    BOOST_CHECK(!cache.Get(hash1, 101, tOut));
+
+    cache.Put(hash2, t);
+    cache.Put(hash3, t);
+    BOOST_CHECK(cache.Size() == 2);
+    BOOST_CHECK(!cache.Get(hash1, 100, tOut));
+    BOOST_CHECK(cache.Get(hash3, 100, tOut));
+
+    cache.Clear();
+    BOOST_CHECK(cache.Size() == 0);
+}
+
+BOOST_AUTO_TEST_CASE(txmessage_ipfs_fee_record)
+{
+    CIPFSFeeRecord fee(1530000000, 25, 1048576);
+    BOOST_CHECK_EQUAL(fee.ToString(), "1530000000;25;1048576");
+    CIPFSFeeRecord parsed;
+    BOOST_CHECK(parsed.FromString(fee.ToString()));
+    BOOST_CHECK(parsed.nTime == fee.nTime && parsed.nFee == fee.nFee && parsed.nSize == fee.nSize);
+
+    BOOST_CHECK(!parsed.FromString(""));
+    BOOST_CHECK(!parsed.FromString("25"));
+    BOOST_CHECK(!parsed.FromString("1530000000;25"));
+    BOOST_CHECK(!parsed.FromString("1530000000;x;1"));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
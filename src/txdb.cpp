@@ -26,6 +26,8 @@ static const char DB_ADDRESSINDEX = 'a';
 static const char DB_ADDRESSUNSPENTINDEX = 'u';
 static const char DB_TIMESTAMPINDEX = 's';
 static const char DB_SPENTINDEX = 'p';
+static const char DB_SUPERBLOCKINDEX = 'S';
+static const char DB_BLOCK_SUMMARY = 'X';
 static const char DB_BLOCK_INDEX = 'b';
 
 static const char DB_BEST_BLOCK = 'B';
@@ -33,6 +35,9 @@ static const char DB_FLAG = 'F';
 static const char DB_REINDEX_FLAG = 'R';
 static const char DB_LAST_BLOCK = 'l';
 
+static const char DB_BIBLEHASH = 'h';
+static const char DB_POW_VERIFIED = 'V';
+
 uint256 BibleHash(uint256 hash, int64_t nBlockTime, int64_t nPrevBlockTime, bool bMining, int nPrevHeight, const CBlockIndex* pindexLast, bool bRequireTxIndex, bool f7000, bool f8000, bool f9000, bool fTitheBlocksActive, unsigned int nNonce);
 
 
@@ -298,6 +303,45 @@ bool CBlockTreeDB::ReadTimestampIndex(const unsigned int &high, const unsigned i
     return true;
 }
 
+bool CBlockTreeDB::WriteSuperblockPayments(int nHeight, const CSuperblockPayments &payments) {
+    return Write(make_pair(DB_SUPERBLOCKINDEX, nHeight), payments);
+}
+
+bool CBlockTreeDB::EraseSuperblockPayments(int nHeight) {
+    return Erase(make_pair(DB_SUPERBLOCKINDEX, nHeight));
+}
+
+bool CBlockTreeDB::WriteBlockSummary(const uint256 &hashBlock, const CBlockSummary &summary) {
+    return Write(make_pair(DB_BLOCK_SUMMARY, hashBlock), summary);
+}
+
+bool CBlockTreeDB::ReadBlockSummary(const uint256 &hashBlock, CBlockSummary &summary) {
+    return Read(make_pair(DB_BLOCK_SUMMARY, hashBlock), summary);
+}
+
+bool CBlockTreeDB::ReadSuperblockPayments(std::map<int, CSuperblockPayments> &mapPayments) {
+
+    boost::scoped_ptr<CDBIterator> pcursor(NewIterator());
+
+    pcursor->Seek(make_pair(DB_SUPERBLOCKINDEX, 0));
+
+    while (pcursor->Valid()) {
+        boost::this_thread::interruption_point();
+        std::pair<char, int> key;
+        if (pcursor->GetKey(key) && key.first == DB_SUPERBLOCKINDEX) {
+            CSuperblockPayments payments;
+            if (!pcursor->GetValue(payments))
+                return error("failed to get superblock payments value");
+            mapPayments[key.second] = payments;
+            pcursor->Next();
+        } else {
+            break;
+        }
+    }
+
+    return true;
+}
+
 bool CBlockTreeDB::WriteFlag(const std::string &name, bool fValue) {
     return Write(std::make_pair(DB_FLAG, name), fValue ? '1' : '0');
 }
@@ -310,6 +354,40 @@ bool CBlockTreeDB::ReadFlag(const std::string &name, bool &fValue) {
     return true;
 }
 
+bool CBlockTreeDB::ReadPowVerified(uint256 &hashBlock) {
+    return Read(DB_POW_VERIFIED, hashBlock);
+}
+
+bool CBlockTreeDB::WritePowVerified(const uint256 &hashBlock) {
+    return Write(DB_POW_VERIFIED, hashBlock);
+}
+
+/** Checks the proof of work of the headers taken by index from *pnNext, until they run out or one fails */
+static void VerifyIndexPowThread(const std::vector<CBlockIndex*>* pvIndex, size_t* pnNext, const CBlockIndex** ppindexFailed, CCriticalSection* pcs)
+{
+    const Consensus::Params& consensusParams = Params().GetConsensus();
+    while (true) {
+        size_t i;
+        {
+            LOCK(*pcs);
+            if (*pnNext >= pvIndex->size() || *ppindexFailed != NULL)
+                return;
+            i = (*pnNext)++;
+        }
+        const CBlockIndex* pindex = (*pvIndex)[i];
+        if (!CheckProofOfWork(pindex->GetBlockHash(), pindex->nBits, consensusParams,
+            pindex->nTime,
+            (pindex->pprev) ? pindex->pprev->nTime : 0,
+            (pindex->pprev) ? pindex->pprev->nHeight : 0, pindex->nNonce,
+            pindex->pprev, true)) {
+            LOCK(*pcs);
+            if (*ppindexFailed == NULL)
+                *ppindexFailed = pindex;
+            return;
+        }
+    }
+}
+
 bool CBlockTreeDB::LoadBlockIndexGuts()
 {
     boost::scoped_ptr<CDBIterator> pcursor(NewIterator());
@@ -320,8 +398,10 @@ bool CBlockTreeDB::LoadBlockIndexGuts()
 	const CChainParams& chainparams = Params();
 	int nCheckpointHeight = Checkpoints::GetTotalBlocksEstimate(chainparams.Checkpoints());
     LogPrintf(" Last Checkpoint Height %f ",nCheckpointHeight);
+    int64_t nStart = GetTimeMillis();
 
-    // Load mapBlockIndex
+    // Phase 1: load mapBlockIndex; headers are checked once they are all linked, so each one sees its real parent
+    std::vector<CBlockIndex*> vLoaded;
     while (pcursor->Valid()) 
 	{
 		iBlock++;
@@ -352,15 +432,7 @@ bool CBlockTreeDB::LoadBlockIndexGuts()
                 pindexNew->nTx            = diskindex.nTx;
 				// pindexNew->sBlockMessage  = diskindex.sBlockMessage;
 				pindexNew->hashBibleHash  = diskindex.hashBibleHash;
-				if (diskindex.nHeight > nCheckpointHeight || diskindex.nHeight % 10 == 0)
-				{
-					if (!CheckProofOfWork(pindexNew->GetBlockHash(), pindexNew->nBits, Params().GetConsensus(), 
-						pindexNew->nTime,
-						(pindexNew->pprev) ? pindexNew->pprev->nTime : 0,
-						(pindexNew->pprev) ? pindexNew->pprev->nHeight : 0, pindexNew->nNonce, 
-						pindexNew->pprev, true))
-						return error("LoadBlockIndex(): CheckProofOfWork failed: %s", pindexNew->ToString());
-				}
+                vLoaded.push_back(pindexNew);
 
                 pcursor->Next();
             } else {
@@ -370,7 +442,71 @@ bool CBlockTreeDB::LoadBlockIndexGuts()
             break;
         }
     }
-	fLoadingIndex=false;
-	
+    int64_t nLoaded = GetTimeMillis();
+
+    // Phase 2: check proof of work for every header above the last checkpoint and every 10th below it,
+    // except those at or below the header a previous run verified (and its ancestors)
+    std::vector<CBlockIndex*> vVerifiedChain;
+    uint256 hashVerified;
+    if (ReadPowVerified(hashVerified)) {
+        BlockMap::iterator mi = mapBlockIndex.find(hashVerified);
+        if (mi != mapBlockIndex.end()) {
+            vVerifiedChain.resize(mi->second->nHeight + 1);
+            for (CBlockIndex* pindex = mi->second; pindex && pindex->nHeight >= 0 && pindex->nHeight < (int)vVerifiedChain.size(); pindex = pindex->pprev)
+                vVerifiedChain[pindex->nHeight] = pindex;
+        }
+    }
+    std::vector<CBlockIndex*> vVerify;
+    CBlockIndex* pindexHighest = NULL;
+    size_t nAlreadyVerified = 0;
+    for (size_t i = 0; i < vLoaded.size(); i++) {
+        CBlockIndex* pindex = vLoaded[i];
+        if (pindexHighest == NULL || pindex->nHeight > pindexHighest->nHeight)
+            pindexHighest = pindex;
+        if (pindex->nHeight <= nCheckpointHeight && pindex->nHeight % 10 != 0)
+            continue;
+        if (pindex->nHeight >= 0 && pindex->nHeight < (int)vVerifiedChain.size() && vVerifiedChain[pindex->nHeight] == pindex) {
+            nAlreadyVerified++;
+            continue;
+        }
+        vVerify.push_back(pindex);
+    }
+
+    int nThreads = std::max(1, std::min(GetNumCores(), (int)vVerify.size()));
+    const CBlockIndex* pindexFailed = NULL;
+    if (!vVerify.empty()) {
+        size_t nNext = 0;
+        CCriticalSection cs;
+        boost::thread_group threads;
+        for (int i = 0; i < nThreads; i++)
+            threads.create_thread(boost::bind(&VerifyIndexPowThread, &vVerify, &nNext, &pindexFailed, &cs));
+        threads.join_all();
+    }
+    if (pindexFailed != NULL)
+        return error("LoadBlockIndex(): CheckProofOfWork failed: %s", pindexFailed->ToString());
+    if (pindexHighest != NULL && pindexHighest->GetBlockHash() != hashVerified && !WritePowVerified(pindexHighest->GetBlockHash())) {
+        LogPrintf("LoadBlockIndex(): failed to record the verified header %s\n", pindexHighest->GetBlockHash().ToString());
+    }
+    fLoadingIndex = false;
+
+    LogPrintf("LoadBlockIndex(): loaded %u headers in %dms, checked %u proofs of work (%u already verified) with %d threads in %dms\n",
+        vLoaded.size(), nLoaded - nStart, vVerify.size(), nAlreadyVerified, nThreads, GetTimeMillis() - nLoaded);
     return true;
 }
+
+CBibleHashDB::CBibleHashDB(size_t nCacheSize, bool fMemory, bool fWipe) : CDBWrapper(GetDataDir() / "blocks" / "biblehash", nCacheSize, fMemory, fWipe) {
+}
+
+bool CBibleHashDB::ReadBibleHash(const uint256& hashBlock, int64_t nBlockTime, int64_t nPrevBlockTime, int nPrevHeight, unsigned int nNonce, uint256& hashBibleHashRet) {
+    CBibleHashRecord record;
+    if (!Read(make_pair(DB_BIBLEHASH, hashBlock), record))
+        return false;
+    if (record.nBlockTime != nBlockTime || record.nPrevBlockTime != nPrevBlockTime || record.nPrevHeight != nPrevHeight || record.nNonce != nNonce)
+        return false;
+    hashBibleHashRet = record.hashBibleHash;
+    return true;
+}
+
+bool CBibleHashDB::WriteBibleHash(const uint256& hashBlock, const CBibleHashRecord& record) {
+    return Write(make_pair(DB_BIBLEHASH, hashBlock), record);
+}
@@ -26,6 +26,8 @@ struct CTimestampIndexKey;
 struct CTimestampIndexIteratorKey;
 struct CSpentIndexKey;
 struct CSpentIndexValue;
+struct CSuperblockPayments;
+struct CBlockSummary;
 class uint256;
 
 //! -dbcache default (MiB)
@@ -34,6 +36,8 @@ static const int64_t nDefaultDbCache = 100;
 static const int64_t nMaxDbCache = sizeof(void*) > 4 ? 16384 : 1024;
 //! min. -dbcache in (MiB)
 static const int64_t nMinDbCache = 4;
+//! BibleHash database cache (bytes)
+static const int64_t nBibleHashDbCache = 1 << 20;
 
 /** CCoinsView backed by the coin database (chainstate/) */
 class CCoinsViewDB : public CCoinsView
@@ -78,9 +82,64 @@ public:
                           int start = 0, int end = 0);
     bool WriteTimestampIndex(const CTimestampIndexKey &timestampIndex);
     bool ReadTimestampIndex(const unsigned int &high, const unsigned int &low, std::vector<uint256> &vect);
+    bool WriteSuperblockPayments(int nHeight, const CSuperblockPayments &payments);
+    bool EraseSuperblockPayments(int nHeight);
+    bool ReadSuperblockPayments(std::map<int, CSuperblockPayments> &mapPayments);
+    bool WriteBlockSummary(const uint256 &hashBlock, const CBlockSummary &summary);
+    bool ReadBlockSummary(const uint256 &hashBlock, CBlockSummary &summary);
     bool WriteFlag(const std::string &name, bool fValue);
     bool ReadFlag(const std::string &name, bool &fValue);
+    /** The header whose proof of work (and that of its ancestors) LoadBlockIndexGuts verified last */
+    bool ReadPowVerified(uint256 &hashBlock);
+    bool WritePowVerified(const uint256 &hashBlock);
     bool LoadBlockIndexGuts();
 };
 
+/** The inputs a BibleHash was computed from, stored with it so a lookup only hits for the same header context */
+struct CBibleHashRecord
+{
+    int64_t nBlockTime;
+    int64_t nPrevBlockTime;
+    int nPrevHeight;
+    unsigned int nNonce;
+    uint256 hashBibleHash;
+
+    CBibleHashRecord() : nBlockTime(0), nPrevBlockTime(0), nPrevHeight(0), nNonce(0) {}
+
+    CBibleHashRecord(int64_t nBlockTimeIn, int64_t nPrevBlockTimeIn, int nPrevHeightIn, unsigned int nNonceIn, const uint256& hashBibleHashIn) :
+        nBlockTime(nBlockTimeIn), nPrevBlockTime(nPrevBlockTimeIn), nPrevHeight(nPrevHeightIn), nNonce(nNonceIn), hashBibleHash(hashBibleHashIn) {}
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action, int nType, int nVersion) {
+        READWRITE(nBlockTime);
+        READWRITE(nPrevBlockTime);
+        READWRITE(nPrevHeight);
+        READWRITE(nNonce);
+        READWRITE(hashBibleHash);
+    }
+};
+
+/**
+ * Validated BibleHash results keyed by block hash (blocks/biblehash).
+ *
+ * Only hashes computed locally by a passing CheckProofOfWork are written, so
+ * the store can be trusted by later checks, RPC block views and -reindex. It
+ * lives apart from the block index so a -reindex, which wipes blocks/index,
+ * does not have to recompute the BibleHash of every historical block.
+ */
+class CBibleHashDB : public CDBWrapper
+{
+public:
+    CBibleHashDB(size_t nCacheSize, bool fMemory = false, bool fWipe = false);
+private:
+    CBibleHashDB(const CBibleHashDB&);
+    void operator=(const CBibleHashDB&);
+public:
+    /** Finds the BibleHash of hashBlock, provided it was computed from the same inputs */
+    bool ReadBibleHash(const uint256& hashBlock, int64_t nBlockTime, int64_t nPrevBlockTime, int nPrevHeight, unsigned int nNonce, uint256& hashBibleHashRet);
+    bool WriteBibleHash(const uint256& hashBlock, const CBibleHashRecord& record);
+};
+
 #endif // BITCOIN_TXDB_H
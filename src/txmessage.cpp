@@ -0,0 +1,135 @@
+// Copyright (c) 2017-2018 The Biblepay Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "txmessage.h"
+
+#include "tinyformat.h"
+#include "utilstrencodings.h"
+
+#include <string.h>
+
+#include <boost/thread/locks.hpp>
+
+/** Number of transactions whose parsed message is kept */
+static const size_t DEFAULT_TXMESSAGE_CACHE_SIZE = 10000;
+
+CTxMessageCache txMessageCache(DEFAULT_TXMESSAGE_CACHE_SIZE);
+
+static const char* const TX_MESSAGE_TAG_NAMES[CTxMessageTags::TAG_COUNT] =
+{
+    "MT", "MK", "MV", "MS", "NONCE", "SPORKSIG", "BOSIG", "BOSIGNER", "ipfshash", "ipfssize", "cpidsig", "PODC_TASKS"
+};
+
+//! Longest name in TX_MESSAGE_TAG_NAMES
+static const size_t MAX_TX_MESSAGE_TAG_LENGTH = 10;
+
+std::string CIPFSFeeRecord::ToString() const
+{
+    return strprintf("%d;%d;%d", nTime, nFee, nSize);
+}
+
+bool CIPFSFeeRecord::FromString(const std::string& sValue)
+{
+    size_t nFirst = sValue.find(';');
+    size_t nSecond = nFirst == std::string::npos ? std::string::npos : sValue.find(';', nFirst + 1);
+    if (nSecond == std::string::npos)
+        return false;
+    return ParseInt64(sValue.substr(0, nFirst), &nTime) &&
+           ParseInt64(sValue.substr(nFirst + 1, nSecond - nFirst - 1), &nFee) &&
+           ParseInt64(sValue.substr(nSecond + 1), &nSize);
+}
+
+static int FindTxMessageTag(const char* pname, size_t nLength)
+{
+    for (int i = 0; i < CTxMessageTags::TAG_COUNT; i++)
+    {
+        const char* pTag = TX_MESSAGE_TAG_NAMES[i];
+        if (strlen(pTag) == nLength && memcmp(pTag, pname, nLength) == 0)
+            return i;
+    }
+    return -1;
+}
+
+CTxMessageTags::CTxMessageTags(const std::string& sMessage) : pmessage(sMessage.data())
+{
+    for (int i = 0; i < TAG_COUNT; i++)
+        vBegin[i] = vEnd[i] = std::string::npos;
+
+    const char* p = sMessage.data();
+    size_t nSize = sMessage.size();
+    int nRemaining = TAG_COUNT;
+    for (size_t i = 0; i < nSize && nRemaining > 0; i++)
+    {
+        if (p[i] != '<')
+            continue;
+        bool fClose = i + 1 < nSize && p[i + 1] == '/';
+        size_t nName = i + 1 + (fClose ? 1 : 0);
+        size_t j = nName;
+        while (j < nSize && j - nName <= MAX_TX_MESSAGE_TAG_LENGTH && p[j] != '>' && p[j] != '<')
+            j++;
+        if (j >= nSize || p[j] != '>')
+            continue;
+        int nTag = FindTxMessageTag(p + nName, j - nName);
+        if (nTag < 0)
+            continue;
+        // Like ExtractXML, tags are matched anywhere (even inside another value), so keep scanning from the next character
+        if (!fClose)
+        {
+            if (vBegin[nTag] == std::string::npos)
+                vBegin[nTag] = j + 1;
+        }
+        else if (vBegin[nTag] != std::string::npos && vEnd[nTag] == std::string::npos && i >= vBegin[nTag])
+        {
+            vEnd[nTag] = i;
+            nRemaining--;
+        }
+    }
+}
+
+CTxMessageTags::Value CTxMessageTags::Get(Tag tag) const
+{
+    if (vBegin[tag] == std::string::npos || vEnd[tag] == std::string::npos)
+        return Value();
+    return Value(pmessage + vBegin[tag], vEnd[tag] - vBegin[tag]);
+}
+
+bool CTxMessageCache::Get(const uint256& txid, int64_t nTime, TxMessage& t) const
+{
+    boost::shared_lock<boost::shared_mutex> lock(cs_txmessagecache);
+    map_type::const_iterator it = mapMessages.find(txid);
+    if (it == mapMessages.end() || it->second.nTime != nTime)
+        return false;
+    t = it->second;
+    return true;
+}
+
+void CTxMessageCache::Put(const uint256& txid, const TxMessage& t)
+{
+    boost::unique_lock<boost::shared_mutex> lock(cs_txmessagecache);
+    std::pair<map_type::iterator, bool> ret = mapMessages.insert(std::make_pair(txid, t));
+    if (!ret.second)
+    {
+        ret.first->second = t;
+        return;
+    }
+    dequeOrder.push_back(txid);
+    while (mapMessages.size() > nMaxEntries)
+    {
+        mapMessages.erase(dequeOrder.front());
+        dequeOrder.pop_front();
+    }
+}
+
+size_t CTxMessageCache::Size() const
+{
+    boost::shared_lock<boost::shared_mutex> lock(cs_txmessagecache);
+    return mapMessages.size();
+}
+
+void CTxMessageCache::Clear()
+{
+    boost::unique_lock<boost::shared_mutex> lock(cs_txmessagecache);
+    mapMessages.clear();
+    dequeOrder.clear();
+}
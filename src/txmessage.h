@@ -0,0 +1,159 @@
+// Copyright (c) 2017-2018 The Biblepay Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_TXMESSAGE_H
+#define BITCOIN_TXMESSAGE_H
+
+#include "uint256.h"
+
+#include <deque>
+#include <string>
+
+#include <stdint.h>
+
+#include <boost/thread/shared_mutex.hpp>
+#include <boost/unordered_map.hpp>
+
+/** A blockchain message (prayer, spork, DCC, business object, ...) carried in a transaction's outputs */
+struct TxMessage
+{
+  std::string sMessageType;
+  std::string sMessageKey;
+  std::string sMessageValue;
+  std::string sSig;
+  std::string sNonce;
+  std::string sSporkSig;
+  std::string sIPFSHash;
+  std::string sBOSig;
+  std::string sBOSigner;
+  std::string sTimestamp;
+  std::string sIPFSSize;
+  std::string sCPIDSig;
+  std::string sCPID;
+  std::string sPODCTasks;
+  std::string sTxId;
+  std::string sVoteSignal;
+  std::string sVoteHash;
+  double      nNonce;
+  double      dAmount;
+  bool        fNonceValid;
+  bool        fPrayersMustBeSigned;
+  bool        fSporkSigValid;
+  bool        fBOSigValid;
+  bool        fPassedSecurityCheck;
+  bool        fSigChecked;
+  int64_t     nAge;
+  int64_t     nTime;
+
+  TxMessage() : nNonce(0), dAmount(0), fNonceValid(false), fPrayersMustBeSigned(false), fSporkSigValid(false), fBOSigValid(false),
+                fPassedSecurityCheck(false), fSigChecked(false), nAge(0), nTime(0) {}
+};
+
+/**
+ * What was paid to pin an IPFS attachment, memorized in the IPFSFEE section
+ * under the attachment's hash (in place of an IPFSFEE<time> and an
+ * IPFSSIZE<time> section per attachment).
+ */
+struct CIPFSFeeRecord
+{
+  int64_t nTime;
+  //! Whole coins donated to the foundation
+  int64_t nFee;
+  //! Attachment size in bytes
+  int64_t nSize;
+
+  CIPFSFeeRecord() : nTime(0), nFee(0), nSize(0) {}
+  CIPFSFeeRecord(int64_t nTimeIn, int64_t nFeeIn, int64_t nSizeIn) : nTime(nTimeIn), nFee(nFeeIn), nSize(nSizeIn) {}
+
+  /** Cache value: "<time>;<fee>;<size>" */
+  std::string ToString() const;
+  /** Parse a cache value, returns false if it is not a record */
+  bool FromString(const std::string& sValue);
+};
+
+/**
+ * Single pass tokenizer for the tags of a transaction message.
+ *
+ * One scan of the message records where each known tag's value starts and
+ * ends; values are then handed out as views into the message without copying.
+ * Matches ExtractXML: the first opening tag wins and its value runs to the
+ * first closing tag after it. Tags are case sensitive.
+ */
+class CTxMessageTags
+{
+public:
+    enum Tag
+    {
+        TAG_MT,
+        TAG_MK,
+        TAG_MV,
+        TAG_MS,
+        TAG_NONCE,
+        TAG_SPORKSIG,
+        TAG_BOSIG,
+        TAG_BOSIGNER,
+        TAG_IPFSHASH,
+        TAG_IPFSSIZE,
+        TAG_CPIDSIG,
+        TAG_PODC_TASKS,
+        TAG_COUNT
+    };
+
+    /** A view of one tag value; only valid while the parsed message is alive */
+    struct Value
+    {
+        const char* pbegin;
+        size_t nSize;
+
+        Value() : pbegin(NULL), nSize(0) {}
+        Value(const char* pbeginIn, size_t nSizeIn) : pbegin(pbeginIn), nSize(nSizeIn) {}
+        bool empty() const { return nSize == 0; }
+        std::string str() const { return std::string(pbegin, pbegin + nSize); }
+    };
+
+    explicit CTxMessageTags(const std::string& sMessage);
+
+    Value Get(Tag tag) const;
+    std::string GetString(Tag tag) const { return Get(tag).str(); }
+
+private:
+    const char* pmessage;
+    size_t vBegin[TAG_COUNT];
+    size_t vEnd[TAG_COUNT];
+};
+
+struct TxMessageHasher
+{
+    size_t operator()(const uint256& hash) const { return hash.GetCheapHash(); }
+};
+
+/**
+ * Parsed messages by txid, so block connect, prayer memorization and the RPC
+ * reports share one parse (and one signature check) per transaction. The
+ * message is part of the txid, so an entry never goes stale; the oldest
+ * entries are evicted once the cache is full.
+ */
+class CTxMessageCache
+{
+private:
+    typedef boost::unordered_map<uint256, TxMessage, TxMessageHasher> map_type;
+
+    mutable boost::shared_mutex cs_txmessagecache;
+    map_type mapMessages;
+    std::deque<uint256> dequeOrder;
+    size_t nMaxEntries;
+
+public:
+    explicit CTxMessageCache(size_t nMaxEntriesIn) : nMaxEntries(nMaxEntriesIn) {}
+
+    /** Look up the message parsed for txid in the context of a block at nTime */
+    bool Get(const uint256& txid, int64_t nTime, TxMessage& t) const;
+    void Put(const uint256& txid, const TxMessage& t);
+    size_t Size() const;
+    void Clear();
+};
+
+extern CTxMessageCache txMessageCache;
+
+#endif // BITCOIN_TXMESSAGE_H